@@ -1,7 +1,7 @@
 declare_module(
     "core", 
     {
-        deps = {"types", "gfx", "job-sys"},
+        deps = {"types", "gfx", "job-sys", "shader_compiler"},
         packages = {{name = "unordered_dense", public = true}},
         enable_reflection = true
     }
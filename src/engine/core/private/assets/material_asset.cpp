@@ -7,10 +7,25 @@
 #include "gfx/vulkan/device.hpp"
 #include "shader_compiler/shader_compiler.hpp"
 
+#include <ranges>
+
 namespace Eng
 {
+// Pipelines requested and not compiled yet, over every material
+static std::atomic<int64_t> pending_compilations = 0;
+
+// Above this, precompiling every permutation would flood the job system : only the default one is
+static constexpr size_t MAX_PRECOMPILED_SWITCHES = 8;
+
 MaterialAsset::MaterialAsset() = default;
 
+MaterialAsset::~MaterialAsset()
+{
+    // The compile jobs keep the permutations alive, but not the material
+    for (const auto& permutation : permutations | std::views::values)
+        permutation->cancel_compilations();
+}
+
 void MaterialAsset::set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override)
 {
     std::unique_lock lk(pipeline_mutex);
@@ -44,6 +59,35 @@ std::weak_ptr<MaterialPermutation> MaterialAsset::get_permutation(const Gfx::Per
     return permutations.emplace(permutation, std::make_shared<MaterialPermutation>(this, permutation)).first->second;
 }
 
+void MaterialAsset::precompile(const std::vector<Gfx::RenderPassGenericId>& render_pass_types)
+{
+    PROFILER_SCOPE_NAMED(PrecompileMaterial, "Precompile material " + std::string(get_name()));
+    const auto                      device = Engine::get().get_device().lock();
+    std::vector<Gfx::RenderPassRef> render_passes;
+    for (const auto& type : render_pass_types.empty() ? device->get_render_pass_types() : render_pass_types)
+        for (const auto& pass : device->get_all_pass_of_type(type))
+            render_passes.emplace_back(pass);
+
+    const auto  default_desc = get_default_permutation();
+    const auto& switches     = default_desc.keys();
+    size_t      switch_count = switches.size();
+    if (switch_count > MAX_PRECOMPILED_SWITCHES)
+    {
+        LOG_WARNING("Material {} has {} permutation switches : only the default permutation is precompiled", get_name(), switch_count);
+        switch_count = 0;
+    }
+
+    for (uint64_t bits = 0; bits < 1ull << switch_count; ++bits)
+    {
+        auto permutation_desc = default_desc;
+        for (size_t i = 0; i < switch_count; ++i)
+            permutation_desc.set(switches[i], bits & 1ull << i);
+        if (const auto permutation = get_permutation(permutation_desc).lock())
+            for (const auto& pass : render_passes)
+                permutation->try_get_resource(pass);
+    }
+}
+
 void MaterialAsset::update_options(const Gfx::PipelineOptions& in_options)
 {
     options = in_options;
@@ -69,52 +113,182 @@ MaterialPermutation::~MaterialPermutation()
         Engine::get().get_device().lock()->drop_resource(pass.second.pipeline);
 }
 
-std::shared_ptr<Gfx::Pipeline> MaterialPermutation::get_resource(const Gfx::RenderPassRef& render_pass)
+void MaterialPermutation::cancel_compilations()
 {
+    std::vector<std::shared_ptr<CompileTask>> tasks;
     {
         std::shared_lock lk(owner->pipeline_mutex);
-        if (auto found = passes.find(render_pass); found != passes.end())
-            return found->second.pipeline;
+        for (const auto& infos : passes | std::views::values)
+            if (infos.compile_task)
+                tasks.emplace_back(infos.compile_task);
     }
+    for (const auto& task : tasks)
+    {
+        std::unique_lock task_lock(task->lock);
+        if (task->b_started)
+        {
+            task->finished_cond.wait(task_lock,
+                                     [&]
+                                     {
+                                         return task->b_finished;
+                                     });
+            continue;
+        }
+        // The job finds the task started and returns, the callers waiting for it get no pipeline
+        task->b_started  = true;
+        task->b_finished = true;
+        task->finished_cond.notify_all();
+        --pending_compilations;
+        PROFILER_COUNTER(PipelineCompileQueue, pending_compilations.load());
+    }
+}
 
-    std::unique_lock lk(owner->pipeline_mutex);
-    if (!owner->compiler_session)
+std::shared_ptr<Gfx::DescriptorSet> MaterialPermutation::get_shared_descriptors(const Gfx::RenderPassRef& render_pass)
+{
+    const auto pipeline = get_resource(render_pass);
+    if (!pipeline)
         return nullptr;
 
-    PROFILER_SCOPE_NAMED(CompileShader, std::string("Compile material '") + owner->get_name() + "' for render pass " + render_pass.to_string());
-    auto compilation_result = owner->compiler_session->compile(render_pass.generic_id(), permutation_description);
+    std::unique_lock lk(owner->pipeline_mutex);
+    auto&            infos = passes.find(render_pass)->second;
+    if (!infos.shared_descriptors)
+        infos.shared_descriptors = Gfx::DescriptorSet::create(std::string(owner->get_name()) + "_shared_descriptors_" + render_pass.to_string(), Engine::get().get_device(), pipeline->get_layout());
+    return infos.shared_descriptors;
+}
+
+std::shared_ptr<Gfx::Pipeline> MaterialPermutation::get_resource(const Gfx::RenderPassRef& render_pass)
+{
+    std::shared_ptr<Gfx::Pipeline> pipeline;
+    const auto                      task = request_compilation(render_pass, pipeline);
+    if (!task)
+        return pipeline;
 
-    if (!compilation_result.errors.empty())
+    // Don't wait for a job that is still queued : the workers may all be waiting too
+    compile(render_pass, task);
     {
-        std::string error_message = "Failed to compile shader:";
-        for (const auto& error : compilation_result.errors)
-            error_message += "\n" + error.message;
-        LOG_ERROR("{}", error_message);
+        std::unique_lock lk(task->lock);
+        task->finished_cond.wait(lk,
+                                 [&]
+                                 {
+                                     return task->b_finished;
+                                 });
+    }
+    std::shared_lock lk(owner->pipeline_mutex);
+    if (auto found = passes.find(render_pass); found != passes.end())
+        return found->second.pipeline;
+    return nullptr;
+}
 
-        PassInfos infos;
-        return passes.emplace(render_pass, infos).first->second.pipeline;
+std::shared_ptr<Gfx::Pipeline> MaterialPermutation::try_get_resource(const Gfx::RenderPassRef& render_pass)
+{
+    std::shared_ptr<Gfx::Pipeline> pipeline;
+    request_compilation(render_pass, pipeline);
+    return pipeline;
+}
+
+std::shared_ptr<MaterialPermutation::CompileTask> MaterialPermutation::request_compilation(const Gfx::RenderPassRef& render_pass, std::shared_ptr<Gfx::Pipeline>& out_pipeline)
+{
+    {
+        std::shared_lock lk(owner->pipeline_mutex);
+        if (auto found = passes.find(render_pass); found != passes.end())
+        {
+            out_pipeline = found->second.pipeline;
+            return found->second.compile_task;
+        }
     }
 
-    auto device = Engine::get().get_device();
+    std::unique_lock lk(owner->pipeline_mutex);
+    if (auto found = passes.find(render_pass); found != passes.end())
+    {
+        out_pipeline = found->second.pipeline;
+        return found->second.compile_task;
+    }
+    if (!owner->compiler_session)
+        return nullptr;
 
-    auto render_pass_object = device.lock()->get_render_pass(render_pass.generic_id());
-    if (!render_pass_object.lock())
+    auto task           = std::make_shared<CompileTask>();
+    task->session       = owner->compiler_session;
+    task->options       = owner->options;
+    task->vertex_inputs = owner->vertex_inputs;
+    task->name          = owner->get_name();
+    passes.emplace(render_pass, PassInfos{.compile_task = task});
+
+    ++pending_compilations;
+    PROFILER_COUNTER(PipelineCompileQueue, pending_compilations.load());
+    JobSystem::get().schedule(
+        [permutation = weak_from_this(), render_pass, task]
+        {
+            // The permutation is destroyed when the material is reloaded : the result is not needed anymore
+            if (const auto permutation_ptr = permutation.lock())
+                permutation_ptr->compile(render_pass, task);
+            else
+            {
+                std::lock_guard task_lock(task->lock);
+                if (!task->b_started)
+                {
+                    --pending_compilations;
+                    PROFILER_COUNTER(PipelineCompileQueue, pending_compilations.load());
+                }
+                task->b_started = true;
+            }
+        });
+    return task;
+}
+
+void MaterialPermutation::compile(const Gfx::RenderPassRef& render_pass, const std::shared_ptr<CompileTask>& task)
+{
     {
-        LOG_ERROR("There is no render pass named {}", render_pass);
+        std::lock_guard task_lock(task->lock);
+        if (task->b_started)
+            return;
+        task->b_started = true;
     }
 
     PassInfos infos;
+    {
+        PROFILER_SCOPE_NAMED(CompileShader, "Compile material '" + task->name + "' for render pass " + render_pass.to_string());
+        auto compilation_result = task->session->compile(render_pass.generic_id(), permutation_description);
 
-    std::vector<std::shared_ptr<Gfx::ShaderModule>> modules;
+        if (!compilation_result.errors.empty())
+        {
+            std::string error_message = "Failed to compile shader:";
+            for (const auto& error : compilation_result.errors)
+                error_message += "\n" + error.message;
+            LOG_ERROR("{}", error_message);
+        }
+        else
+        {
+            auto device = Engine::get().get_device();
 
-    for (const auto& stage : compilation_result.stages)
-    {
-        infos.per_stage_code.emplace(stage.first, stage.second.compiled_module);
-        modules.emplace_back(Gfx::ShaderModule::create(device, stage.second));
+            auto render_pass_object = device.lock()->get_render_pass(render_pass.generic_id());
+            if (!render_pass_object.lock())
+            {
+                LOG_ERROR("There is no render pass named {}", render_pass);
+            }
+
+            std::vector<std::shared_ptr<Gfx::ShaderModule>> modules;
+
+            for (const auto& stage : compilation_result.stages)
+            {
+                infos.per_stage_code.emplace(stage.first, stage.second.compiled_module);
+                modules.emplace_back(Gfx::ShaderModule::create(device, stage.second));
+            }
+            if (!modules.empty() && render_pass_object.lock())
+                infos.pipeline = Gfx::Pipeline::create(task->name, device, render_pass_object, modules, Gfx::Pipeline::CreateInfos{.options = task->options, .vertex_inputs = task->vertex_inputs});
+        }
     }
-    if (!modules.empty() && render_pass_object.lock())
-        infos.pipeline = Gfx::Pipeline::create(owner->get_name(), device, render_pass_object, modules, Gfx::Pipeline::CreateInfos{.options = owner->options, .vertex_inputs = owner->vertex_inputs});
 
-    return passes.emplace(render_pass, infos).first->second.pipeline;
-};
+    {
+        std::unique_lock lk(owner->pipeline_mutex);
+        if (auto found = passes.find(render_pass); found != passes.end() && found->second.compile_task == task)
+            found->second = std::move(infos);
+    }
+    {
+        std::lock_guard task_lock(task->lock);
+        task->b_finished = true;
+    }
+    task->finished_cond.notify_all();
+    --pending_compilations;
+    PROFILER_COUNTER(PipelineCompileQueue, pending_compilations.load());
+}
 } // namespace Eng
\ No newline at end of file
@@ -5,8 +5,12 @@
 #include "assets/texture_asset.hpp"
 #include "engine.hpp"
 #include "gfx/vulkan/descriptor_sets.hpp"
+#include "gfx/vulkan/pipeline_layout.hpp"
 #include "object_ptr.hpp"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Eng
 {
 
@@ -14,11 +18,10 @@ MaterialInstanceAsset::MaterialInstanceAsset(const TObjectRef<MaterialAsset>& ba
 {
 }
 
-std::shared_ptr<Gfx::Pipeline> MaterialInstanceAsset::get_base_resource(const Gfx::RenderPassRef& render_pass_id)
+std::shared_ptr<MaterialPermutation> MaterialInstanceAsset::resolve_permutation()
 {
-    auto perm = permutation.lock();
-    if (perm)
-        return perm->get_resource(render_pass_id);
+    if (auto perm = permutation.lock())
+        return perm;
 
     permutation = base->get_permutation(permutation_description);
     if (!permutation.lock())
@@ -26,80 +29,184 @@ std::shared_ptr<Gfx::Pipeline> MaterialInstanceAsset::get_base_resource(const Gf
         permutation_description = base->get_default_permutation();
         permutation             = base->get_permutation(permutation_description);
     }
-    perm = permutation.lock();
-    if (!perm)
-        return nullptr;
-    return perm->get_resource(render_pass_id);
+    return permutation.lock();
+}
+
+std::shared_ptr<Gfx::Pipeline> MaterialInstanceAsset::get_base_resource(const Gfx::RenderPassRef& render_pass_id)
+{
+    const auto perm = resolve_permutation();
+    return perm ? perm->get_resource(render_pass_id) : nullptr;
+}
+
+std::shared_ptr<Gfx::Pipeline> MaterialInstanceAsset::try_get_base_resource(const Gfx::RenderPassRef& render_pass_id)
+{
+    const auto perm = resolve_permutation();
+    return perm ? perm->try_get_resource(render_pass_id) : nullptr;
 }
 
 std::shared_ptr<Gfx::DescriptorSet> MaterialInstanceAsset::get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id)
 {
     {
         std::shared_lock lk(descriptor_lock);
-        if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
-            return found->second;
+        if (auto found = pass_resources.find(render_pass_id); found != pass_resources.end())
+            return found->second.descriptors;
     }
     std::unique_lock lk(descriptor_lock);
+    if (auto found = pass_resources.find(render_pass_id); found != pass_resources.end())
+        return found->second.descriptors;
     if (auto base_material = get_base_resource(render_pass_id))
     {
-        auto new_descriptor = descriptors.emplace(render_pass_id, Gfx::DescriptorSet::create(std::string(get_name()) + "_descriptors_" + render_pass_id.to_string(), Engine::get().get_device(), base_material->get_layout())).first->
-                                          second;
+        const Gfx::PipelineLayout& layout          = *base_material->get_layout();
+        const auto                 pass_bindings   = pass_buffers.find(render_pass_id);
+        PassResources&             resources       = pass_resources[render_pass_id];
+        bool                       b_bindless_only = buffers.empty() && pass_bindings == pass_buffers.end();
+        for (const auto& texture : textures)
+        {
+            if (auto offset = layout.get_push_constant_offset(texture.first))
+                resources.bindless_parameters.push_back(BindlessParameter{*offset, texture.second->get_bindless_index()});
+            else
+                b_bindless_only = false;
+        }
+        for (const auto& sampler : samplers)
+        {
+            if (auto offset = layout.get_push_constant_offset(sampler.first))
+                resources.bindless_parameters.push_back(BindlessParameter{*offset, sampler.second->get_bindless_index()});
+            else
+                b_bindless_only = false;
+        }
+        if (b_bindless_only)
+            if (auto shared_descriptors = permutation.lock()->get_shared_descriptors(render_pass_id))
+            {
+                resources.descriptors          = shared_descriptors;
+                resources.b_shared_descriptors = true;
+                return shared_descriptors;
+            }
+
+        resources.descriptors = Gfx::DescriptorSet::create(std::string(get_name()) + "_descriptors_" + render_pass_id.to_string(), Engine::get().get_device(), base_material->get_layout());
 
         for (const auto& sampler : samplers)
-            new_descriptor->bind_sampler(sampler.first, sampler.second->get_resource());
+            resources.descriptors->bind_sampler(sampler.first, sampler.second->get_resource());
 
         for (const auto& texture : textures)
-            new_descriptor->bind_image(texture.first, texture.second->get_view());
+            resources.descriptors->bind_image(texture.first, texture.second->get_view());
 
         for (const auto& buffer : buffers)
-            new_descriptor->bind_buffer(buffer.first, buffer.second.lock());
+            resources.descriptors->bind_buffer(buffer.first, buffer.second.lock());
+
+        if (pass_bindings != pass_buffers.end())
+            for (const auto& buffer : pass_bindings->second)
+                resources.descriptors->bind_buffer(buffer.first, buffer.second.lock());
 
-        return new_descriptor;
+        return resources.descriptors;
     }
     return {};
 }
 
+void MaterialInstanceAsset::write_push_constants(const Gfx::RenderPassRef& render_pass_id, std::span<uint8_t> push_constants)
+{
+    std::shared_lock lk(descriptor_lock);
+    if (auto found = pass_resources.find(render_pass_id); found != pass_resources.end())
+        for (const auto& parameter : found->second.bindless_parameters)
+            if (parameter.offset + sizeof(uint32_t) <= push_constants.size())
+                std::memcpy(push_constants.data() + parameter.offset, &parameter.index, sizeof(uint32_t));
+}
+
+void MaterialInstanceAsset::set_pass_parameter(const std::string& binding, uint32_t bindless_index, const std::function<void(Gfx::DescriptorSet&)>& bind)
+{
+    for (auto it = pass_resources.begin(); it != pass_resources.end();)
+    {
+        PassResources& resources     = it->second;
+        const auto     base_material = get_base_resource(it->first);
+        if (auto offset = base_material ? base_material->get_layout()->get_push_constant_offset(binding) : std::nullopt)
+        {
+            auto parameter = std::ranges::find(resources.bindless_parameters, *offset, &BindlessParameter::offset);
+            if (parameter != resources.bindless_parameters.end())
+                parameter->index = bindless_index;
+            else
+                resources.bindless_parameters.push_back(BindlessParameter{*offset, bindless_index});
+        }
+        else if (!resources.b_shared_descriptors)
+            bind(*resources.descriptors);
+        else
+        {
+            // The parameter needs descriptors of its own
+            it = pass_resources.erase(it);
+            continue;
+        }
+        ++it;
+    }
+}
+
 void MaterialInstanceAsset::set_sampler(const std::string& binding, const TObjectRef<SamplerAsset>& sampler)
 {
     std::unique_lock lk(descriptor_lock);
     samplers.insert_or_assign(binding, sampler);
-    for (const auto& desc : descriptors)
-        desc.second->bind_sampler(binding, sampler->get_resource());
+    set_pass_parameter(binding, sampler->get_bindless_index(),
+                       [&](Gfx::DescriptorSet& descriptors)
+                       {
+                           descriptors.bind_sampler(binding, sampler->get_resource());
+                       });
 }
 
 void MaterialInstanceAsset::set_texture(const std::string& binding, const TObjectRef<TextureAsset>& texture)
 {
     std::unique_lock lk(descriptor_lock);
     textures.insert_or_assign(binding, texture);
-    for (const auto& desc : descriptors)
-        desc.second->bind_image(binding, texture->get_view());
+    set_pass_parameter(binding, texture->get_bindless_index(),
+                       [&](Gfx::DescriptorSet& descriptors)
+                       {
+                           descriptors.bind_image(binding, texture->get_view());
+                       });
 }
 
 void MaterialInstanceAsset::set_buffer(const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer)
 {
     std::unique_lock lk(descriptor_lock);
+    if (auto existing = buffers.find(binding); existing != buffers.end() && existing->second.lock() == buffer.lock())
+        return;
     buffers.insert_or_assign(binding, buffer);
-    for (const auto& desc : descriptors)
-        desc.second->bind_buffer(binding, buffer.lock());
+
+    // Buffers are never shared : the passes using the descriptors of the permutation get their own
+    for (auto it = pass_resources.begin(); it != pass_resources.end();)
+    {
+        if (it->second.b_shared_descriptors)
+        {
+            it = pass_resources.erase(it);
+            continue;
+        }
+        const auto pass_bindings = pass_buffers.find(it->first);
+        if (pass_bindings == pass_buffers.end() || !pass_bindings->second.contains(binding))
+            it->second.descriptors->bind_buffer(binding, buffer.lock());
+        ++it;
+    }
 }
 
 void MaterialInstanceAsset::set_buffer(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer)
 {
     std::unique_lock lk(descriptor_lock);
+    BufferBindings&  bindings = pass_buffers[render_pass_id];
+    if (auto existing = bindings.find(binding); existing != bindings.end() && existing->second.lock() == buffer.lock())
+        return;
+    bindings.insert_or_assign(binding, buffer);
 
-    if (auto existing = buffers.find(binding); existing != buffers.end())
+    // Only the descriptors of this pass are affected
+    if (auto found = pass_resources.find(render_pass_id); found != pass_resources.end())
     {
-        if (existing->second.lock() == buffer.lock())
-            return;
-        existing->second = buffer;
+        if (found->second.b_shared_descriptors)
+            pass_resources.erase(found);
+        else
+            found->second.descriptors->bind_buffer(binding, buffer.lock());
     }
-    else
-        buffers.emplace(binding, buffer);
-    if (auto found = descriptors.find(render_pass_id); found != descriptors.end())
-        found->second->bind_buffer(binding, buffer.lock());
 }
 
-void MaterialInstanceAsset::set_scene_data(const Gfx::RenderPassRef& render_pass_id, const std::weak_ptr<Gfx::Buffer>& buffer_data)
+void MaterialInstanceAsset::set_buffer(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const Gfx::TransientBuffer& buffer)
+{
+    std::shared_lock lk(descriptor_lock);
+    if (auto found = pass_resources.find(render_pass_id); found != pass_resources.end() && found->second.descriptors)
+        found->second.descriptors->bind_buffer(binding, buffer);
+}
+
+void MaterialInstanceAsset::set_scene_data(const Gfx::RenderPassRef& render_pass_id, const Gfx::TransientBuffer& buffer_data)
 {
     set_buffer(render_pass_id, "scene_data_buffer", buffer_data);
 }
@@ -107,6 +214,6 @@ void MaterialInstanceAsset::set_scene_data(const Gfx::RenderPassRef& render_pass
 void MaterialInstanceAsset::prepare_for_passes(const Gfx::RenderPassGenericId& render_pass_id)
 {
     for (const auto& pass : Engine::get().get_device().lock()->get_all_pass_of_type(render_pass_id))
-        get_base_resource(pass);
+        try_get_base_resource(pass);
 }
 } // namespace Eng
\ No newline at end of file
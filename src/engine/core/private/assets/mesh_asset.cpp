@@ -6,7 +6,8 @@
 namespace Eng
 {
 
-void MeshAsset::add_section(const std::string& section_name, const std::vector<Vertex>& vertices, const Gfx::BufferData& indices, const TObjectRef<MaterialInstanceAsset>& material, const Bounds& in_bounds)
+void MeshAsset::add_section(const std::string& section_name, const std::vector<Vertex>& vertices, const Gfx::BufferData& indices, const TObjectRef<MaterialInstanceAsset>& material, const Bounds& in_bounds,
+                            const std::vector<MeshLod>& lods)
 {
     Bounds section_bounds = in_bounds;
     if (!section_bounds)
@@ -17,6 +18,6 @@ void MeshAsset::add_section(const std::string& section_name, const std::vector<V
     bounds += section_bounds;
 
     mesh_sections.emplace_back(section_bounds, Gfx::Mesh::create(section_name, Engine::get().get_device(), Gfx::EBufferType::IMMUTABLE, Gfx::BufferData(vertices.data(), sizeof(Vertex), vertices.size()), &indices),
-                               material);
+                               material, lods.empty() ? nullptr : std::make_shared<const std::vector<MeshLod>>(lods));
 }
 } // namespace Eng
\ No newline at end of file
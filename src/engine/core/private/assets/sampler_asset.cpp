@@ -2,6 +2,8 @@
 
 #include "assets/texture_asset.hpp"
 #include "engine.hpp"
+#include "gfx/vulkan/bindless_table.hpp"
+#include "gfx/vulkan/device.hpp"
 #include "gfx/vulkan/sampler.hpp"
 
 namespace Eng
@@ -9,7 +11,18 @@ namespace Eng
 
 SamplerAsset::SamplerAsset()
 {
-    sampler = Gfx::Sampler::create(get_name(), Engine::get().get_device(), Gfx::Sampler::CreateInfos{});
+    sampler       = Gfx::Sampler::create(get_name(), Engine::get().get_device(), Gfx::Sampler::CreateInfos{});
+    bindless_slot = Engine::get().get_device().lock()->get_bindless_table().add_sampler(sampler);
+}
+
+SamplerAsset::~SamplerAsset()
+{
+    Engine::get().get_device().lock()->drop_resource(bindless_slot);
+}
+
+uint32_t SamplerAsset::get_bindless_index() const
+{
+    return bindless_slot->get_index();
 }
 
 } // namespace Eng
\ No newline at end of file
@@ -2,17 +2,29 @@
 
 #include "assets/asset_registry.hpp"
 #include "engine.hpp"
+#include "gfx/vulkan/bindless_table.hpp"
+#include "gfx/vulkan/device.hpp"
 #include "gfx/vulkan/image.hpp"
 #include "gfx/vulkan/image_view.hpp"
 
 namespace Eng
 {
 
+TextureAsset::~TextureAsset()
+{
+    Engine::get().get_device().lock()->drop_resource(bindless_slot);
+}
+
 const Gfx::ColorFormat& TextureAsset::get_format() const
 {
     return image->get_params().format;
 }
 
+uint32_t TextureAsset::get_bindless_index() const
+{
+    return bindless_slot->get_index();
+}
+
 static TObjectRef<TextureAsset> default_asset = {};
 
 TObjectRef<TextureAsset> TextureAsset::get_default_asset()
@@ -77,6 +89,7 @@ TextureAsset::TextureAsset(const std::vector<Gfx::BufferData>& mips, const Creat
                                        .depth = infos.depth,
                                        .array_size = infos.array_size
                                    }, mips);
-    view = Gfx::ImageView::create(get_name(), image);
+    view          = Gfx::ImageView::create(get_name(), image);
+    bindless_slot = Engine::get().get_device().lock()->get_bindless_table().add_texture(view);
 }
 } // namespace Eng
\ No newline at end of file
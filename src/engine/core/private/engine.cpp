@@ -12,6 +12,7 @@
 #include "gfx/window.hpp"
 #include "profiler.hpp"
 #include "assets/material_asset.hpp"
+#include "shader_compiler/shader_compiler.hpp"
 
 #if _WIN32
 #include <Windows.h>
@@ -24,6 +25,8 @@ Engine* engine_singleton = nullptr;
 Engine::Engine(Config config) : app_config(std::move(config)), job_system(std::make_unique<JobSystem>(config.worker_threads ? config.worker_threads : std::thread::hardware_concurrency()))
 {
     LOG_INFO("Using {} parallel workers", config.worker_threads ? config.worker_threads : std::thread::hardware_concurrency());
+    // The pipelines are compiled on the workers
+    ShaderCompiler::Compiler::get().set_max_contexts(job_system->get_workers().size());
 #if _WIN32
     timeBeginPeriod(1);
 #endif
@@ -73,6 +76,7 @@ std::weak_ptr<Gfx::Window> Engine::new_window(const Gfx::WindowConfig& config)
 
 void Engine::run_internal()
 {
+    bool b_first_frame = true;
     while (!windows.empty())
     {
         auto new_time = std::chrono::steady_clock::now();
@@ -89,6 +93,8 @@ void Engine::run_internal()
                 });
         }
 
+        // The tick does not overlap the rendering : the render passes still read the live scene (camera views, directional light cascades) and
+        // the game polls the GLFW input, which must stay on the main thread
         app->tick_game(*this, delta_second);
         std::vector<size_t> windows_to_remove;
         for (const auto& [id, window] : windows)
@@ -103,6 +109,13 @@ void Engine::run_internal()
             window.second->reset_events();
         gfx_device->next_frame();
         Profiler::get().next_frame();
+
+        // Includes the compilation of every pipeline used by the first frame (see Gfx::PipelineCache)
+        if (b_first_frame)
+        {
+            LOG_INFO("First frame rendered {:.3f}s after startup", get_seconds());
+            b_first_frame = false;
+        }
     }
 }
 
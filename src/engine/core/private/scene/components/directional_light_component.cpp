@@ -1,8 +1,96 @@
 #include "scene/components/directional_light_component.hpp"
 
+#include "scene/components/camera_component.hpp"
+#include "scene/scene_view.hpp"
+
+#include <imgui.h>
+#include <glm/common.hpp>
+#include <glm/ext/quaternion_double.hpp>
+
 namespace Eng
 {
 DirectionalLightComponent::DirectionalLightComponent()
 {
+    cascade_count = 4;
+}
+
+void DirectionalLightComponent::post_tick(double delta_second)
+{
+    LightComponent::post_tick(delta_second);
+
+    const auto& camera = get_scene().get_active_camera();
+    if (shadow_cascades.empty() || !camera)
+        return;
+
+    const SceneView& camera_view = camera->get_view();
+    const glm::uvec2 resolution  = camera_view.get_resolution();
+    if (resolution.x == 0 || resolution.y == 0)
+        return;
+
+    const float     aspect  = static_cast<float>(resolution.x) / static_cast<float>(resolution.y);
+    const glm::vec3 forward = camera_view.get_rotation() * glm::vec3(1, 0, 0);
+    const glm::vec3 right   = camera_view.get_rotation() * glm::vec3(0, 1, 0);
+    const glm::vec3 up      = camera_view.get_rotation() * glm::vec3(0, 0, 1);
+
+    const float near_distance = std::max(camera_view.get_z_near(), 0.001f);
+    const float far_distance  = std::max(std::min(shadow_distance, camera_view.get_z_far()), near_distance * 2);
+    const float count         = static_cast<float>(shadow_cascades.size());
+
+    float slice_near = near_distance;
+    for (size_t i = 0; i < shadow_cascades.size(); ++i)
+    {
+        // Practical split scheme : blend of the uniform and logarithmic splits
+        const float ratio      = static_cast<float>(i + 1) / count;
+        const float uniform    = near_distance + (far_distance - near_distance) * ratio;
+        const float logarithm  = near_distance * std::pow(far_distance / near_distance, ratio);
+        const float slice_far  = glm::mix(uniform, logarithm, cascade_split_lambda);
+        glm::vec3   corners[8] = {}; // Relative to the camera position to keep float precision
+        glm::vec3   center     = {0, 0, 0};
+        for (uint32_t c = 0; c < 8; ++c)
+        {
+            const float depth       = c < 4 ? slice_near : slice_far;
+            const float half_height = camera_view.is_orthographic() ? camera_view.get_fov() / aspect : depth * std::tan(glm::radians(camera_view.get_fov()) * 0.5f);
+            const float half_width  = camera_view.is_orthographic() ? camera_view.get_fov() : half_height * aspect;
+            corners[c]              = forward * depth + right * (c & 1 ? half_width : -half_width) + up * (c & 2 ? half_height : -half_height);
+            center += corners[c] / 8.f;
+        }
+
+        // A bounding sphere keeps the projection size constant when the camera rotates, and rounding it avoids flickering from float errors
+        float radius = 0;
+        for (const auto& corner : corners)
+            radius = std::max(radius, distance(corner, center));
+        radius = std::ceil(radius * 16.f) / 16.f;
+
+        // Snap the center to the shadow map texels in light space so static geometry always rasterizes to the same texels. The world position
+        // can be far from the origin : snap it in double precision.
+        const glm::quat rotation    = get_relative_rotation();
+        const double    texel_size  = 2.0 * radius / static_cast<double>(shadow_resolution);
+        glm::dvec3      light_space = inverse(glm::dquat(rotation)) * (camera_view.get_position() + glm::dvec3(center));
+        light_space.y               = std::floor(light_space.y / texel_size) * texel_size;
+        light_space.z               = std::floor(light_space.z / texel_size) * texel_size;
+
+        ShadowCascade& cascade = shadow_cascades[i];
+        cascade.far_distance   = slice_far;
+        cascade.view->set_rotation(rotation);
+        cascade.view->set_position(glm::dquat(rotation) * light_space);
+        cascade.view->set_orthographic_width(radius);
+        cascade.view->set_z_near(-radius - caster_distance);
+        cascade.view->set_z_far(radius);
+
+        slice_near = slice_far;
+    }
+}
+
+void DirectionalLightComponent::build_outliner(Gfx::ImGuiWrapper& ctx)
+{
+    // The shadow views are fitted to the camera : skip the fixed orthographic settings of LightComponent
+    SceneComponent::build_outliner(ctx);
+
+    int cascades = static_cast<int>(cascade_count);
+    if (ImGui::SliderInt("Cascades", &cascades, 1, static_cast<int>(max_cascades)))
+        set_cascade_count(static_cast<uint32_t>(cascades));
+    ImGui::SliderFloat("Split lambda", &cascade_split_lambda, 0, 1);
+    ImGui::SliderFloat("Shadow distance", &shadow_distance, 100, 100000);
+    ImGui::SliderFloat("Caster distance", &caster_distance, 0, 50000);
 }
-}
\ No newline at end of file
+} // namespace Eng
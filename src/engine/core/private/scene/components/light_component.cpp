@@ -16,12 +16,12 @@ public:
 
     void pre_draw(const Gfx::RenderPassInstanceBase& rp) override
     {
-        scene_view->pre_draw(rp);
+        scene_view->pre_draw(*scene, rp);
     }
 
     void draw(const Gfx::RenderPassInstanceBase& rp, Gfx::CommandBuffer& command_buffer, size_t thread_index) override
     {
-        scene_view->draw(*scene, rp, command_buffer, thread_index, record_threads());
+        scene_view->draw(rp, command_buffer, thread_index, record_threads());
     }
 
     size_t record_threads() override
@@ -51,52 +51,73 @@ void LightComponent::enable_shadow(ELightType in_light_type, bool in_enabled)
 
     if (in_enabled)
     {
-        shadow_view = SceneView::create();
-        shadow_view->set_perspective(false);
-        shadow_view->set_z_far(z_far);
-        shadow_view->set_z_near(z_near);
-        shadow_view->set_orthographic_width(orthographic_width);
-
-        auto          obj_ref = as_ref();
-        Gfx::Renderer renderer;
-        renderer["shadows"]
-            .render_pass<SceneShadowsInterface>(shadow_view, get_scene())
-            .flip_culling(true)
-            .resize_callback(
-                [obj_ref](const glm::uvec2&) -> glm::uvec2
-                {
-                    return {obj_ref.cast<LightComponent>()->shadow_resolution, obj_ref.cast<LightComponent>()->shadow_resolution};
-                })
-            [Gfx::Attachment::slot("depth").format(Gfx::ColorFormat::D24_UNORM_S8_UINT).clear_depth({0.0f, 0.0f})];
-
-        shadow_update_pass = get_scene().add_custom_pass({"gbuffer_resolve"}, renderer);
+        for (uint32_t i = 0; i < cascade_count; ++i)
+        {
+            auto shadow_view = SceneView::create();
+            shadow_view->set_perspective(false);
+            shadow_view->set_z_far(z_far);
+            shadow_view->set_z_near(z_near);
+            shadow_view->set_orthographic_width(orthographic_width);
+            shadow_view->set_position(get_relative_position());
+            shadow_view->set_rotation(get_relative_rotation());
+
+            auto          obj_ref = as_ref();
+            Gfx::Renderer renderer;
+            renderer["shadows"]
+                .render_pass<SceneShadowsInterface>(shadow_view, get_scene())
+                .flip_culling(true)
+                .resize_callback(
+                    [obj_ref](const glm::uvec2&) -> glm::uvec2
+                    {
+                        return {obj_ref.cast<LightComponent>()->shadow_resolution, obj_ref.cast<LightComponent>()->shadow_resolution};
+                    })
+                [Gfx::Attachment::slot("depth").format(Gfx::ColorFormat::D24_UNORM_S8_UINT).clear_depth({0.0f, 0.0f}).read_outside_graph()];
+
+            shadow_cascades.emplace_back(shadow_view, get_scene().add_custom_pass({"gbuffer_resolve"}, renderer));
+        }
     }
     else
     {
-        get_scene().remove_custom_pass(shadow_update_pass);
+        for (const auto& cascade : shadow_cascades)
+            get_scene().remove_custom_pass(cascade.pass);
+        shadow_cascades.clear();
+    }
+}
+
+void LightComponent::set_cascade_count(uint32_t in_cascade_count)
+{
+    in_cascade_count = std::clamp(in_cascade_count, 1u, max_cascades);
+    if (in_cascade_count == cascade_count)
+        return;
+    cascade_count = in_cascade_count;
+    if (shadows)
+    {
+        enable_shadow(light_type, false);
+        enable_shadow(light_type, true);
     }
 }
 
-void LightComponent::set_position(glm::vec3 in_position)
+void LightComponent::set_position(glm::dvec3 in_position)
 {
     SceneComponent::set_position(in_position);
-    if (shadow_view)
-        shadow_view->set_position(in_position);
+    for (const auto& cascade : shadow_cascades)
+        cascade.view->set_position(in_position);
 }
 
 void LightComponent::set_rotation(glm::quat in_rotation)
 {
     SceneComponent::set_rotation(in_rotation);
-    if (shadow_view)
-        shadow_view->set_rotation(in_rotation);
+    for (const auto& cascade : shadow_cascades)
+        cascade.view->set_rotation(in_rotation);
 }
 
 void LightComponent::build_outliner(Gfx::ImGuiWrapper& ctx)
 {
     SceneComponent::build_outliner(ctx);
 
-    if (shadow_view)
+    if (!shadow_cascades.empty())
     {
+        const auto& shadow_view = shadow_cascades[0].view;
         if (ImGui::SliderFloat("Width", &orthographic_width, 10, 50000))
             shadow_view->set_orthographic_width(orthographic_width);
         if (ImGui::SliderFloat("Z near", &z_near, -50000, 0))
@@ -1,52 +1,46 @@
 #include "scene/components/mesh_component.hpp"
 
-#include "assets/material_asset.hpp"
-#include "assets/material_instance_asset.hpp"
 #include "assets/mesh_asset.hpp"
-#include "gfx/vulkan/buffer.hpp"
-#include "gfx/vulkan/command_buffer.hpp"
-#include "profiler.hpp"
-#include "scene/scene_view.hpp"
-#include "scene/components/camera_component.hpp"
+#include "scene/render_scene.hpp"
 
-struct Pc
-{
-    glm::mat4 model;
-};
+#include <algorithm>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 
 namespace Eng
 {
+void MeshComponent::extract(RenderScene& render_scene)
+{
+    if (!mesh)
+        return;
+
+    const glm::mat4 transform = render_scene.to_render_space(get_world_transform());
+    for (const auto& section : mesh->get_sections())
+        render_scene.add_proxy(transform, transform * section.bounds, section.mesh, section.material, section.lods);
+}
+
+TObjectRef<AssetBase> MeshComponent::get_serialized_asset() const
+{
+    TObjectRef<AssetBase> asset;
+    asset = mesh;
+    return asset;
+}
+
+void MeshComponent::set_serialized_asset(const TObjectRef<AssetBase>& asset)
+{
+    mesh = asset.cast<MeshAsset>();
+}
 
-int  val = 5;
-void MeshComponent::draw(Gfx::CommandBuffer& command_buffer, const SceneView& view)
+std::optional<double> MeshComponent::get_bounding_radius()
 {
-    if (mesh)
-    {
-        if (!view.frustum_test(get_world_transform() * mesh->get_bounds()))
-            return;
-
-        PROFILER_SCOPE_NAMED(DrawMesh, "Draw mesh component " + std::string(get_name()) + " : " + std::to_string(mesh->get_sections().size()) + " sections");
-        for (const auto& section : mesh->get_sections())
-        {
-            if (!view.frustum_test(get_world_transform() * section.bounds))
-                continue;
-
-            if (section.material)
-            {
-                section.material->set_scene_data(command_buffer.render_pass(), view.get_view_buffer());
-
-                auto pipeline = section.material->get_base_resource(command_buffer.render_pass());
-                if (!pipeline)
-                    return;
-                command_buffer.bind_pipeline(pipeline);
-                command_buffer.push_constant(Gfx::EShaderStage::Vertex, *pipeline, Gfx::BufferData(Pc{.model = get_world_transform()}));
-
-                auto resources = section.material->get_descriptor_resource(command_buffer.render_pass());
-                assert(resources);
-                command_buffer.bind_descriptors(*resources, *pipeline);
-                command_buffer.draw_mesh(*section.mesh);
-            }
-        }
-    }
+    if (!mesh)
+        return {};
+
+    // Farthest corner of the sections from the component origin, scaled like the world transform
+    double local_radius = 0;
+    for (const auto& section : mesh->get_sections())
+        local_radius = std::max(local_radius, static_cast<double>(length(max(abs(section.bounds.min()), abs(section.bounds.max())))));
+    const glm::dmat4& transform = get_world_transform();
+    return local_radius * std::max({length(glm::dvec3(transform[0])), length(glm::dvec3(transform[1])), length(glm::dvec3(transform[2]))});
 }
-} // namespace Eng
\ No newline at end of file
+} // namespace Eng
@@ -0,0 +1,24 @@
+#include "scene/components/point_light_component.hpp"
+
+#include "scene/render_scene.hpp"
+
+#include <imgui.h>
+
+namespace Eng
+{
+PointLightComponent::PointLightComponent() = default;
+
+void PointLightComponent::extract(RenderScene& render_scene)
+{
+    render_scene.add_light({.position = render_scene.to_render_space(get_world_position()), .range = range, .color = color * intensity, .direction = glm::vec3(get_world_transform()[0])});
+}
+
+void PointLightComponent::build_outliner(Gfx::ImGuiWrapper& ctx)
+{
+    LightComponent::build_outliner(ctx);
+
+    ImGui::ColorEdit3("Color", &color.x);
+    ImGui::SliderFloat("Range", &range, 10, 10000);
+    ImGui::SliderFloat("Intensity", &intensity, 0, 10000000, "%.0f", ImGuiSliderFlags_Logarithmic);
+}
+} // namespace Eng
@@ -2,30 +2,25 @@
 
 #include <imgui.h>
 
-#include <ranges>
+#include <vector>
 
 namespace Eng
 {
-void SceneComponent::internal_tick(double delta_second)
+void SceneComponent::prune_dead_nodes()
 {
-    std::vector<std::vector<TObjectPtr<SceneComponent>>::iterator> deleted_nodes;
-    for (auto node = children.begin(); node != children.end(); ++node)
-    {
-        if (*node)
-            (*node)->tick(delta_second);
-        else
-            deleted_nodes.push_back(node);
-    }
-
-    for (auto& deleted_node : std::ranges::reverse_view(deleted_nodes))
-        children.erase(deleted_node);
-    tick(delta_second);
+    std::erase_if(children,
+                  [](const TObjectPtr<SceneComponent>& child)
+                  {
+                      return !child;
+                  });
+    for (const auto& child : children)
+        child->prune_dead_nodes();
 }
 
 void SceneComponent::build_outliner(Gfx::ImGuiWrapper&)
 {
-    glm::vec3 out_pos = get_relative_position();
-    ImGui::DragFloat3("position", &out_pos.x, 10);
+    glm::dvec3 out_pos = get_relative_position();
+    ImGui::DragScalarN("position", ImGuiDataType_Double, &out_pos.x, 3, 10);
     if (out_pos != get_relative_position())
         set_position(out_pos);
 
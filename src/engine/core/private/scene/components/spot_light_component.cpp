@@ -0,0 +1,30 @@
+#include "scene/components/spot_light_component.hpp"
+
+#include "scene/render_scene.hpp"
+
+#include <imgui.h>
+#include <glm/geometric.hpp>
+#include <glm/trigonometric.hpp>
+
+namespace Eng
+{
+SpotLightComponent::SpotLightComponent() = default;
+
+void SpotLightComponent::extract(RenderScene& render_scene)
+{
+    render_scene.add_light({.position        = render_scene.to_render_space(get_world_position()),
+                            .range           = range,
+                            .color           = color * intensity,
+                            .direction       = normalize(glm::vec3(get_world_transform()[0])),
+                            .cos_inner_angle = std::cos(glm::radians(inner_angle)),
+                            .cos_outer_angle = std::cos(glm::radians(outer_angle))});
+}
+
+void SpotLightComponent::build_outliner(Gfx::ImGuiWrapper& ctx)
+{
+    PointLightComponent::build_outliner(ctx);
+
+    ImGui::SliderFloat("Outer angle", &outer_angle, 1, 90);
+    ImGui::SliderFloat("Inner angle", &inner_angle, 0, outer_angle);
+}
+} // namespace Eng
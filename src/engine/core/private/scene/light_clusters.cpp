@@ -0,0 +1,150 @@
+#include "scene/light_clusters.hpp"
+
+#include "engine.hpp"
+#include "profiler.hpp"
+#include "gfx/vulkan/buffer.hpp"
+#include "jobsys/parallel_for.hpp"
+#include "scene/render_scene.hpp"
+#include "scene/scene_view.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+namespace Eng
+{
+LightClusters::LightClusters()
+{
+    cluster_lights.resize(cluster_count);
+    cluster_ranges.resize(cluster_count);
+}
+
+void LightClusters::update(const RenderScene& render_scene, const SceneView& view)
+{
+    PROFILER_SCOPE(BuildLightClusters);
+
+    const auto&      scene_lights = render_scene.get_lights();
+    const glm::mat4& view_matrix  = view.get_view_matrix();
+    const glm::mat4& projection   = view.get_projection_matrix();
+
+    z_near                 = std::max(view.get_z_near(), 0.001f);
+    const float z_far      = std::max(view.get_z_far(), z_near * 2);
+    z_scale                = static_cast<float>(grid_z) / std::log(z_far / z_near);
+    const auto depth_slice = [&](float depth)
+    {
+        return depth <= z_near ? 0u : std::min(static_cast<uint32_t>(std::log(depth / z_near) * z_scale), grid_z - 1);
+    };
+
+    lights.resize(scene_lights.size());
+    light_extents.resize(scene_lights.size());
+    for (size_t i = 0; i < scene_lights.size(); ++i)
+    {
+        const RenderLight& light = scene_lights[i];
+
+        // Point lights never fade with the angle
+        const bool  spot       = light.cos_outer_angle > -1;
+        const float spot_scale = spot ? 1.f / std::max(light.cos_inner_angle - light.cos_outer_angle, 0.0001f) : 0.f;
+        lights[i]              = {light.position, light.range, light.color, spot ? -light.cos_outer_angle * spot_scale : 1.f, light.direction, spot_scale};
+
+        // Bounding sphere of the lit volume. Narrow spot cones are enclosed in a much smaller sphere than their range.
+        glm::vec3 center = light.position;
+        float     radius = light.range;
+        if (spot && light.cos_outer_angle > 0)
+        {
+            const float sin_outer = std::sqrt(1.f - light.cos_outer_angle * light.cos_outer_angle);
+            if (light.cos_outer_angle > sin_outer) // Under 45 degrees
+            {
+                radius = light.range / (2.f * light.cos_outer_angle);
+                center = light.position + light.direction * radius;
+            }
+            else
+            {
+                radius = light.range * sin_outer;
+                center = light.position + light.direction * light.range * light.cos_outer_angle;
+            }
+        }
+
+        const glm::vec3 view_center = glm::vec3(view_matrix * glm::vec4(center, 1));
+        LightExtent&    extent      = light_extents[i];
+        extent.visible              = view_center.x + radius > view.get_z_near() && view_center.x - radius < z_far;
+        if (!extent.visible)
+            continue;
+
+        extent.min.z = depth_slice(view_center.x - radius);
+        extent.max.z = depth_slice(view_center.x + radius);
+
+        // Screen tiles covered by the projected bounding box of the sphere. Spheres crossing the near plane can cover the whole screen.
+        if (view_center.x - radius <= view.get_z_near())
+        {
+            extent.min.x = extent.min.y = 0;
+            extent.max.x                = grid_x - 1;
+            extent.max.y                = grid_y - 1;
+            continue;
+        }
+
+        glm::vec2 ndc_min(FLT_MAX);
+        glm::vec2 ndc_max(-FLT_MAX);
+        for (uint32_t c = 0; c < 8; ++c)
+        {
+            const glm::vec3 corner = view_center + glm::vec3(c & 1 ? radius : -radius, c & 2 ? radius : -radius, c & 4 ? radius : -radius);
+            const glm::vec4 clip   = projection * glm::vec4(corner, 1);
+            ndc_min                = min(ndc_min, glm::vec2(clip) / clip.w);
+            ndc_max                = max(ndc_max, glm::vec2(clip) / clip.w);
+        }
+        if (ndc_max.x < -1 || ndc_max.y < -1 || ndc_min.x > 1 || ndc_min.y > 1)
+        {
+            extent.visible = false;
+            continue;
+        }
+        const glm::vec2 grid_size(grid_x, grid_y);
+        const glm::vec2 tile_min = clamp((ndc_min * 0.5f + 0.5f) * grid_size, glm::vec2(0), grid_size - 1.f);
+        const glm::vec2 tile_max = clamp((ndc_max * 0.5f + 0.5f) * grid_size, glm::vec2(0), grid_size - 1.f);
+        extent.min.x             = static_cast<uint32_t>(tile_min.x);
+        extent.min.y             = static_cast<uint32_t>(tile_min.y);
+        extent.max.x             = static_cast<uint32_t>(tile_max.x);
+        extent.max.y             = static_cast<uint32_t>(tile_max.y);
+    }
+
+    // Each job fills whole depth slices, so no cluster is shared between two jobs
+    const size_t job_count = std::clamp<size_t>(scene_lights.size() / 16, 1, std::min<size_t>(grid_z, std::max<size_t>(1, JobSystem::get().get_workers().size())));
+    JobSys::parallel_for(job_count,
+                         [&](size_t job)
+                         {
+                             const uint32_t end = static_cast<uint32_t>(grid_z * (job + 1) / job_count);
+                             for (uint32_t z = static_cast<uint32_t>(grid_z * job / job_count); z < end; ++z)
+                             {
+                                 for (uint32_t c = z * grid_x * grid_y; c < (z + 1) * grid_x * grid_y; ++c)
+                                     cluster_lights[c].clear();
+
+                                 for (uint32_t i = 0; i < light_extents.size(); ++i)
+                                 {
+                                     const LightExtent& extent = light_extents[i];
+                                     if (!extent.visible || z < extent.min.z || z > extent.max.z)
+                                         continue;
+                                     for (uint32_t y = extent.min.y; y <= extent.max.y; ++y)
+                                         for (uint32_t x = extent.min.x; x <= extent.max.x; ++x)
+                                         {
+                                             auto& cluster = cluster_lights[(z * grid_y + y) * grid_x + x];
+                                             if (cluster.size() < max_lights_per_cluster)
+                                                 cluster.emplace_back(i);
+                                         }
+                                 }
+                             }
+                         });
+
+    // Compact the per cluster lists into a single index buffer
+    light_indices.clear();
+    for (uint32_t c = 0; c < cluster_count; ++c)
+    {
+        cluster_ranges[c] = {static_cast<uint32_t>(light_indices.size()), static_cast<uint32_t>(cluster_lights[c].size())};
+        light_indices.insert(light_indices.end(), cluster_lights[c].begin(), cluster_lights[c].end());
+    }
+
+    // Rewritten every frame : the descriptors only change their dynamic offsets
+    Gfx::TransientAllocator& transient_allocator = Engine::get().get_device().lock()->get_transient_allocator();
+    light_buffer                                 = transient_allocator.write(Gfx::BufferData(lights));
+    index_buffer                                 = transient_allocator.write(Gfx::BufferData(light_indices));
+    cluster_buffer                               = transient_allocator.write(Gfx::BufferData(cluster_ranges));
+}
+} // namespace Eng
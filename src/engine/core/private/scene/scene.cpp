@@ -1,5 +1,3 @@
-#include <ranges>
-
 #include "scene/scene.hpp"
 
 #include "engine.hpp"
@@ -7,14 +5,47 @@
 #include "object_allocator.hpp"
 #include "profiler.hpp"
 #include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "jobsys/parallel_for.hpp"
+#include "scene/render_scene.hpp"
+#include "scene/scene_view.hpp"
+#include "scene/components/camera_component.hpp"
+#include "scene/components/mesh_component.hpp"
+#include "scene/components/point_light_component.hpp"
 #include "scene/components/scene_component.hpp"
 
+#include <condition_variable>
+
 namespace Eng
 {
-Scene::Scene()
+/**
+ * Ring of render scenes : the extract writes the oldest snapshot while the views of the frames in flight may still read the others. Each
+ * snapshot counts its readers, and the last one to release it wakes up the extract waiting for it.
+ */
+struct Scene::RenderSceneSlots
 {
-    merge_queue_mtx = std::make_unique<std::mutex>();
-    allocator       = std::make_unique<ContiguousObjectAllocator>();
+    struct Slot
+    {
+        RenderScene scene;
+        uint32_t    readers = 0;
+    };
+
+    explicit RenderSceneSlots(size_t count) : slots(count)
+    {
+    }
+
+    std::mutex              lock;
+    std::condition_variable released;
+    std::vector<Slot>       slots; // Never resized : the acquired snapshots point into it
+    Slot*                   current = nullptr;
+};
+
+Scene::Scene(uint32_t render_pipeline_depth)
+{
+    merge_queue_mtx    = std::make_unique<std::mutex>();
+    render_scene_slots = std::make_shared<RenderSceneSlots>(std::max(render_pipeline_depth, 1u) + 1);
+    allocator          = std::make_unique<ContiguousObjectAllocator>();
+    visibility         = std::make_unique<SceneVisibility>();
+    partition          = std::make_unique<ScenePartition>();
 }
 
 void Scene::tick(double delta_second)
@@ -32,28 +63,195 @@ void Scene::tick(double delta_second)
                 });
             assert(scene.allocator);
             allocator->merge_with(*scene.allocator);
+            partition->merge_with(*scene.partition);
             root_nodes.reserve(root_nodes.size() + scene.root_nodes.size());
             for (const auto& component : scene.root_nodes)
                 root_nodes.push_back(component);
             scene.root_nodes.clear();
+            new_components.insert(new_components.end(), scene.new_components.begin(), scene.new_components.end());
+            scene.new_components.clear();
         }
         scenes_to_merge.clear();
     }
 
-    std::vector<std::vector<TObjectPtr<SceneComponent>>::iterator> deleted_nodes;
-    for (auto node = root_nodes.begin(); node != root_nodes.end(); ++node)
+    prune_dead_nodes();
+
+    tick_phase(ETickPhase::PreTick, delta_second);
+    tick_phase(ETickPhase::Tick, delta_second);
+    tick_phase(ETickPhase::PostTick, delta_second);
+
+    track_new_components();
+    partition->update();
+    if (active_camera)
+        partition->update_activation(active_camera->get_view().get_position());
+
+    extract_render_scene();
+}
+
+void Scene::tick_phase(ETickPhase phase, double delta_second) const
+{
+    PROFILER_SCOPE_NAMED(SceneTickPhase, std::format("Scene tick phase {}", static_cast<int>(phase)));
+
+    const auto tick_component = [phase, delta_second](SceneComponent& component)
     {
-        if (!*node)
-            deleted_nodes.push_back(node);
+        switch (phase)
+        {
+        case ETickPhase::PreTick:
+            component.pre_tick(delta_second);
+            break;
+        case ETickPhase::Tick:
+            component.tick(delta_second);
+            break;
+        case ETickPhase::PostTick:
+            component.post_tick(delta_second);
+            break;
+        }
+    };
+
+    // Regular components may add or destroy components : tick them first, while no worker is iterating the pools
+    std::vector<ContiguousObjectPool*> parallel_pools;
+    size_t                             parallel_components = 0;
+    for (ContiguousObjectPool* pool : allocator->find_pools(SceneComponent::static_class()))
+    {
+        if (pool->get_class()->get_flags() & SceneComponent::ParallelTick)
+        {
+            parallel_pools.emplace_back(pool);
+            parallel_components += pool->size();
+            continue;
+        }
+        for (size_t i = 0; i < pool->size(); ++i)
+            tick_component(*static_cast<SceneComponent*>(pool->nth(i)));
     }
-    for (auto& deleted_node : std::ranges::reverse_view(deleted_nodes))
-        root_nodes.erase(deleted_node);
 
-    for_each<SceneComponent>(
-        [delta_second](SceneComponent& object)
+    if (parallel_components == 0)
+        return;
+
+    const size_t job_count = std::clamp<size_t>(parallel_components / 256, 1, std::max<size_t>(1, JobSystem::get().get_workers().size()));
+    JobSys::parallel_for(job_count,
+                         [&](size_t job)
+                         {
+                             for (ContiguousObjectPool* pool : parallel_pools)
+                             {
+                                 const size_t end = pool->size() * (job + 1) / job_count;
+                                 for (size_t i = pool->size() * job / job_count; i < end; ++i)
+                                     tick_component(*static_cast<SceneComponent*>(pool->nth(i)));
+                             }
+                         });
+}
+
+void Scene::prune_dead_nodes()
+{
+    if (allocator->get_free_count() == pruned_free_count)
+        return;
+    PROFILER_SCOPE(PruneDeadNodes);
+    pruned_free_count = allocator->get_free_count();
+
+    std::erase_if(root_nodes,
+                  [](const TObjectPtr<SceneComponent>& node)
+                  {
+                      return !node;
+                  });
+    for (const auto& node : root_nodes)
+        node->prune_dead_nodes();
+}
+
+void Scene::track_new_components()
+{
+    if (new_components.empty())
+        return;
+    PROFILER_SCOPE(TrackNewComponents);
+    for (const auto& component : new_components)
+        if (component)
+            if (const auto radius = component->get_bounding_radius())
+                partition->track(component, *radius);
+    new_components.clear();
+}
+
+void Scene::extract_render_scene()
+{
+    PROFILER_SCOPE(ExtractRenderScene);
+
+    // The oldest snapshot of the ring, never the published one : the views acquiring it during the extract still get a complete snapshot
+    auto& slot = render_scene_slots->slots[extracted_frames % render_scene_slots->slots.size()];
+    {
+        PROFILER_SCOPE(WaitRenderSceneRelease);
+        std::unique_lock lk(render_scene_slots->lock);
+        render_scene_slots->released.wait(lk,
+                                          [&]
+                                          {
+                                              return slot.readers == 0;
+                                          });
+    }
+
+    // Rebase the render scene around the camera
+    RenderScene& render_scene = slot.scene;
+    render_scene.reset(extracted_frames, active_camera ? active_camera->get_view().get_position() : glm::dvec3{0, 0, 0});
+    for_each<MeshComponent>(
+        [&render_scene](MeshComponent& object)
         {
-            object.tick(delta_second);
+            object.extract(render_scene);
         });
+    // Also extracts the spot lights
+    for_each<PointLightComponent>(
+        [&render_scene](PointLightComponent& object)
+        {
+            object.extract(render_scene);
+        });
+
+    std::lock_guard lk(render_scene_slots->lock);
+    render_scene_slots->current = &slot;
+    ++extracted_frames;
+}
+
+std::shared_ptr<const RenderScene> Scene::get_render_scene() const
+{
+    std::lock_guard lk(render_scene_slots->lock);
+    const auto      slot = render_scene_slots->current;
+    if (!slot)
+        return nullptr;
+    ++slot->readers;
+    return std::shared_ptr<const RenderScene>(&slot->scene,
+                                              [slots = render_scene_slots, slot](const RenderScene*)
+                                              {
+                                                  {
+                                                      std::lock_guard release_lk(slots->lock);
+                                                      --slot->readers;
+                                                  }
+                                                  slots->released.notify_all();
+                                              });
+}
+
+TObjectRef<SceneComponent> Scene::add_component_of_class(const Reflection::Class* component_class, const std::string& name, const TObjectRef<SceneComponent>& parent)
+{
+    if (!component_class || !SceneComponent::static_class()->is_base_of(component_class) || !component_class->can_construct())
+    {
+        LOG_ERROR("Cannot create component {} : {} is not a default constructible component class", name, component_class ? component_class->name() : "null");
+        return {};
+    }
+    ObjectAllocation* alloc = allocator->allocate(component_class);
+    SceneComponent*   ptr   = static_cast<SceneComponent*>(alloc->ptr);
+    ptr->scene              = this;
+    ptr->name               = new char[name.size() + 1];
+    memcpy(const_cast<char*>(ptr->name), name.c_str(), name.size() + 1);
+    component_class->construct(alloc->ptr);
+    if (!ptr->name)
+        LOG_FATAL("Object {} does not contains any constructor", component_class->name())
+    TObjectPtr<SceneComponent> obj_ptr(alloc);
+    obj_ptr->this_ref = obj_ptr;
+    if (parent)
+    {
+        obj_ptr->parent = parent;
+        parent->children.emplace_back(obj_ptr);
+    }
+    else
+        root_nodes.emplace_back(obj_ptr);
+    new_components.emplace_back(obj_ptr);
+    return obj_ptr;
+}
+
+void Scene::reserve_components(const Reflection::Class* component_class, size_t additional_count) const
+{
+    allocator->reserve(component_class, additional_count);
 }
 
 void Scene::merge(Scene&& other_scene)
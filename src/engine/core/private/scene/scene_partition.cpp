@@ -0,0 +1,270 @@
+#include "scene/scene_partition.hpp"
+
+#include "profiler.hpp"
+#include "scene/scene_view.hpp"
+#include "scene/components/scene_component.hpp"
+
+#include <cassert>
+#include <cmath>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+namespace Eng
+{
+static CellKey parent_key(const CellKey& key)
+{
+    // Arithmetic shifts round toward negative infinity, like the cell coordinates
+    return {key.x >> 1, key.y >> 1, key.z >> 1, key.level + 1};
+}
+
+static uint8_t child_bit(const CellKey& key)
+{
+    return static_cast<uint8_t>(1 << ((key.x & 1) | (key.y & 1) << 1 | (key.z & 1) << 2));
+}
+
+static double distance_to_bounds(const glm::dvec3& position, const glm::dvec3& min, const glm::dvec3& max)
+{
+    return distance(position, clamp(position, min, max));
+}
+
+ScenePartition::ScenePartition(double in_cell_size, uint32_t in_level_count) : cell_size(in_cell_size), level_count(std::clamp(in_level_count, 1u, 48u))
+{
+}
+
+void ScenePartition::track(const TObjectRef<SceneComponent>& component, double radius)
+{
+    if (!component)
+        return LOG_ERROR("Cannot track an invalid component in the scene partition");
+
+    untrack(component);
+    const glm::dvec3 position = component->get_world_position();
+    const CellKey    key      = make_key(position, radius);
+    insert(component, key);
+    tracked.emplace(component, TrackedComponent{key, position, radius});
+}
+
+void ScenePartition::untrack(const TObjectRef<SceneComponent>& component)
+{
+    auto it = tracked.find(component);
+    if (it == tracked.end())
+        return;
+    remove(component, it->second.cell);
+    tracked.erase(it);
+}
+
+void ScenePartition::update()
+{
+    PROFILER_SCOPE(UpdateScenePartition);
+    for (auto it = tracked.begin(); it != tracked.end();)
+    {
+        TrackedComponent& entry = it->second;
+        if (!it->first)
+        {
+            remove(it->first, entry.cell);
+            it = tracked.erase(it);
+            continue;
+        }
+
+        const glm::dvec3 position = it->first->get_world_position();
+        if (position != entry.position)
+        {
+            entry.position    = position;
+            const CellKey key = make_key(position, entry.radius);
+            if (key != entry.cell)
+            {
+                remove(it->first, entry.cell);
+                insert(it->first, key);
+                entry.cell = key;
+            }
+        }
+        ++it;
+    }
+}
+
+void ScenePartition::update_activation(const glm::dvec3& position)
+{
+    PROFILER_SCOPE(UpdateCellActivation);
+
+    const double         deactivation_distance = activation_distance * (1 + hysteresis);
+    std::vector<CellKey> changed_cells;
+    for (const auto& key : active_cells)
+    {
+        glm::dvec3 min, max;
+        cell_bounds(key, min, max);
+        if (distance_to_bounds(position, min, max) > deactivation_distance)
+            changed_cells.emplace_back(key);
+    }
+    for (const auto& key : changed_cells)
+    {
+        active_cells.erase(key);
+        if (on_deactivate)
+            on_deactivate(key, cells.at(key).components);
+    }
+
+    // The loose bounds of a cell contain the ones of its children : stop at the first cell out of range
+    changed_cells.clear();
+    traverse(
+        [&](const CellKey& key, const Cell& cell)
+        {
+            glm::dvec3 min, max;
+            cell_bounds(key, min, max);
+            if (distance_to_bounds(position, min, max) > activation_distance)
+                return false;
+            if (!cell.components.empty() && active_cells.insert(key).second)
+                changed_cells.emplace_back(key);
+            return true;
+        });
+    if (on_activate)
+        for (const auto& key : changed_cells)
+            on_activate(key, cells.at(key).components);
+}
+
+bool ScenePartition::find_cell(const TObjectRef<SceneComponent>& component, CellKey& out_key) const
+{
+    auto it = tracked.find(component);
+    if (it == tracked.end())
+        return false;
+    out_key = it->second.cell;
+    return true;
+}
+
+void ScenePartition::query_radius(const glm::dvec3& center, double radius, const ComponentCallback& callback) const
+{
+    traverse(
+        [&](const CellKey& key, const Cell& cell)
+        {
+            glm::dvec3 min, max;
+            cell_bounds(key, min, max);
+            if (distance_to_bounds(center, min, max) > radius)
+                return false;
+            for (const auto& component : cell.components)
+                callback(component);
+            return true;
+        });
+}
+
+void ScenePartition::query_frustum(const Frustum& frustum, const glm::dvec3& origin, const ComponentCallback& callback) const
+{
+    traverse(
+        [&](const CellKey& key, const Cell& cell)
+        {
+            glm::dvec3 min, max;
+            cell_bounds(key, min, max);
+            if (!frustum.test(Bounds(glm::vec3(min - origin), glm::vec3(max - origin))))
+                return false;
+            for (const auto& component : cell.components)
+                callback(component);
+            return true;
+        });
+}
+
+void ScenePartition::merge_with(ScenePartition& other)
+{
+    for (const auto& [component, entry] : other.tracked)
+        if (component)
+            track(component, entry.radius);
+    other.tracked.clear();
+    other.cells.clear();
+    other.roots.clear();
+    other.active_cells.clear();
+}
+
+double ScenePartition::get_cell_size(uint32_t level) const
+{
+    return std::ldexp(cell_size, static_cast<int>(level));
+}
+
+CellKey ScenePartition::make_key(const glm::dvec3& position, double radius) const
+{
+    // A loose cell contains every sphere centered in it whose diameter is not larger than the cell
+    uint32_t level = 0;
+    while (level + 1 < level_count && get_cell_size(level) < radius * 2)
+        ++level;
+
+    const glm::dvec3 coordinates = floor(position / get_cell_size(level));
+    return {static_cast<int64_t>(coordinates.x), static_cast<int64_t>(coordinates.y), static_cast<int64_t>(coordinates.z), level};
+}
+
+void ScenePartition::insert(const TObjectRef<SceneComponent>& component, const CellKey& key)
+{
+    Cell& cell = cells[key];
+    cell.components.emplace_back(component);
+    ++cell.subtree_components;
+    if (on_activate && active_cells.contains(key))
+        on_activate(key, {component});
+
+    // Create the missing ancestors up to the top level
+    CellKey child = key;
+    while (child.level + 1 < level_count)
+    {
+        const CellKey parent = parent_key(child);
+        Cell&         node   = cells[parent];
+        node.child_mask |= child_bit(child);
+        ++node.subtree_components;
+        child = parent;
+    }
+    roots.insert(child);
+}
+
+void ScenePartition::remove(const TObjectRef<SceneComponent>& component, const CellKey& key)
+{
+    auto it = cells.find(key);
+    if (it == cells.end())
+        return;
+    std::erase(it->second.components, component);
+    if (active_cells.contains(key))
+    {
+        if (on_deactivate)
+            on_deactivate(key, {component});
+        // Only cells with components are activated
+        if (it->second.components.empty())
+            active_cells.erase(key);
+    }
+
+    // Release the cells left empty, up to the top level
+    CellKey current     = key;
+    bool    erase_child = false;
+    CellKey child;
+    while (true)
+    {
+        it = cells.find(current);
+        assert(it != cells.end());
+        if (erase_child)
+            it->second.child_mask &= ~child_bit(child);
+        erase_child = --it->second.subtree_components == 0;
+        if (erase_child)
+        {
+            cells.erase(it);
+            roots.erase(current);
+        }
+        if (current.level + 1 >= level_count)
+            break;
+        child   = current;
+        current = parent_key(current);
+    }
+}
+
+void ScenePartition::cell_bounds(const CellKey& key, glm::dvec3& out_min, glm::dvec3& out_max) const
+{
+    const double size = get_cell_size(key.level);
+    out_min           = glm::dvec3(key.x, key.y, key.z) * size - size * 0.5;
+    out_max           = out_min + size * 2.0;
+}
+
+void ScenePartition::traverse(const std::function<bool(const CellKey&, const Cell&)>& visitor) const
+{
+    std::vector<CellKey> stack(roots.begin(), roots.end());
+    while (!stack.empty())
+    {
+        const CellKey key = stack.back();
+        stack.pop_back();
+
+        const Cell& cell = cells.at(key);
+        if (!visitor(key, cell) || key.level == 0)
+            continue;
+        for (uint32_t i = 0; i < 8; ++i)
+            if (cell.child_mask & 1 << i)
+                stack.push_back({key.x * 2 + (i & 1), key.y * 2 + (i >> 1 & 1), key.z * 2 + (i >> 2 & 1), key.level - 1});
+    }
+}
+} // namespace Eng
@@ -0,0 +1,666 @@
+#include "scene/scene_serializer.hpp"
+
+#include "mapped_file.hpp"
+#include "profiler.hpp"
+#include "assets/asset_registry.hpp"
+#include "assets/material_asset.hpp"
+#include "assets/material_instance_asset.hpp"
+#include "assets/sampler_asset.hpp"
+#include "gfx/vulkan/buffer.hpp"
+#include "scene/scene.hpp"
+#include "scene/components/scene_component.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <ankerl/unordered_dense.h>
+
+namespace Eng
+{
+static constexpr char     scene_file_magic[4]  = {'E', 'S', 'C', 'N'};
+static constexpr uint32_t scene_file_version   = 2;
+static constexpr uint32_t scene_file_no_parent = UINT32_MAX;
+
+struct SceneFileHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t class_count;
+    uint32_t node_count;
+    uint32_t asset_count;
+    uint32_t padding;
+    uint64_t asset_data_size;
+    uint64_t string_table_size;
+};
+
+struct SceneFileNode
+{
+    uint32_t   parent; // Index of the parent node, always lower than the index of this node
+    uint32_t   class_index;
+    uint32_t   name_offset;
+    uint32_t   padding_0;
+    glm::dvec3 position;
+    glm::quat  rotation;
+    glm::vec3  scale;
+    uint32_t   padding_1;
+    uint64_t   asset_hash;
+};
+
+enum class SceneFileAssetType : uint32_t
+{
+    Texture,
+    Sampler,
+    Material,
+    MaterialInstance,
+    Mesh,
+};
+
+// The assets are stored after their dependencies, which are referenced by hash
+struct SceneFileAsset
+{
+    SceneFileAssetType type;
+    uint32_t           name_offset;
+    uint64_t           hash;
+    uint64_t           data_offset; // In the asset data section, 8 bytes aligned
+    uint64_t           data_size;
+};
+
+static_assert(sizeof(SceneFileHeader) == 40 && sizeof(SceneFileNode) == 80 && sizeof(SceneFileAsset) == 32, "The scene file layout must not depend on the compiler");
+
+static size_t align_asset_data(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+class AssetDataWriter
+{
+public:
+    template <typename T> void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write_string(const std::string& value)
+    {
+        write(static_cast<uint64_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+    }
+
+    // Arrays are aligned to be read in place from the mapped file
+    void write_array(const void* bytes, size_t size)
+    {
+        write(static_cast<uint64_t>(size));
+        data.resize(align_asset_data(data.size()));
+        data.insert(data.end(), static_cast<const uint8_t*>(bytes), static_cast<const uint8_t*>(bytes) + size);
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class AssetDataReader
+{
+public:
+    AssetDataReader(const uint8_t* in_data, size_t in_size) : data(in_data), size(in_size)
+    {
+    }
+
+    template <typename T> T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (check(sizeof(T)))
+            std::memcpy(&value, data + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    std::string read_string()
+    {
+        const auto  length = read<uint64_t>();
+        std::string value;
+        if (check(length))
+            value.assign(reinterpret_cast<const char*>(data + position), length);
+        position += length;
+        return value;
+    }
+
+    std::span<const uint8_t> read_array()
+    {
+        const auto length = read<uint64_t>();
+        position          = align_asset_data(position);
+        std::span<const uint8_t> value;
+        if (check(length))
+            value = {data + position, length};
+        position += length;
+        return value;
+    }
+
+    // False once a read went past the end of the data
+    bool valid() const
+    {
+        return b_valid;
+    }
+
+private:
+    bool check(uint64_t length)
+    {
+        b_valid = b_valid && position <= size && length <= size - position;
+        return b_valid;
+    }
+
+    const uint8_t* data;
+    size_t         size;
+    size_t         position = 0;
+    bool           b_valid  = true;
+};
+
+/**
+ * Asset section of the file being written. An asset is stored after its dependencies, and only if the payloads have the data to recreate it.
+ */
+class AssetTableWriter
+{
+public:
+    AssetTableWriter(const AssetPayloads& in_payloads, std::function<uint32_t(const char*)> in_add_string) : payloads(in_payloads), add_string(std::move(in_add_string))
+    {
+    }
+
+    // False if the asset cannot be restored from the file
+    bool add(const TObjectRef<AssetBase>& asset)
+    {
+        const uint64_t hash = asset ? asset->get_content_hash() : 0;
+        if (hash == 0)
+            return false;
+        if (auto found = stored.find(hash); found != stored.end())
+            return found->second;
+        stored.emplace(hash, false);
+
+        AssetDataWriter    writer;
+        SceneFileAssetType type     = SceneFileAssetType::Texture;
+        bool               b_stored = false;
+        if (const auto texture = asset.cast<TextureAsset>())
+        {
+            type     = SceneFileAssetType::Texture;
+            b_stored = write_texture(texture, writer);
+        }
+        else if (asset.cast<SamplerAsset>())
+        {
+            type     = SceneFileAssetType::Sampler;
+            b_stored = true;
+        }
+        else if (const auto material = asset.cast<MaterialAsset>())
+        {
+            type     = SceneFileAssetType::Material;
+            b_stored = write_material(material, writer);
+        }
+        else if (const auto material_instance = asset.cast<MaterialInstanceAsset>())
+        {
+            type     = SceneFileAssetType::MaterialInstance;
+            b_stored = write_material_instance(material_instance, writer);
+        }
+        else if (const auto mesh = asset.cast<MeshAsset>())
+        {
+            type     = SceneFileAssetType::Mesh;
+            b_stored = write_mesh(mesh, writer);
+        }
+        if (!b_stored)
+        {
+            ++missing_payloads;
+            return false;
+        }
+
+        records.emplace_back(SceneFileAsset{
+            .type        = type,
+            .name_offset = add_string(asset->get_name()),
+            .hash        = hash,
+            .data_offset = data.size(),
+            .data_size   = writer.data.size(),
+        });
+        data.insert(data.end(), writer.data.begin(), writer.data.end());
+        data.resize(align_asset_data(data.size()));
+        stored[hash] = true;
+        return true;
+    }
+
+    std::vector<SceneFileAsset> records;
+    std::vector<uint8_t>        data;
+    size_t                      missing_payloads = 0;
+
+private:
+    bool write_texture(const TObjectRef<TextureAsset>& texture, AssetDataWriter& writer) const
+    {
+        const AssetPayloads::Texture* payload = payloads.find_texture(texture->get_content_hash());
+        if (!payload)
+            return false;
+        writer.write(payload->infos.width);
+        writer.write(payload->infos.height);
+        writer.write(payload->infos.depth);
+        writer.write(static_cast<uint32_t>(payload->infos.format));
+        writer.write(payload->infos.array_size);
+        writer.write(static_cast<uint32_t>(payload->mips.size()));
+        for (const auto& mip : payload->mips)
+            writer.write_array(mip.data(), mip.size());
+        return true;
+    }
+
+    static bool write_material(const TObjectRef<MaterialAsset>& material, AssetDataWriter& writer)
+    {
+        const auto& vertex_inputs = material->get_vertex_inputs();
+        writer.write_string(material->get_shader_path().generic_string());
+        writer.write_array(vertex_inputs.data(), vertex_inputs.size() * sizeof(StageInputOutputDescription));
+        return true;
+    }
+
+    bool write_material_instance(const TObjectRef<MaterialInstanceAsset>& material_instance, AssetDataWriter& writer)
+    {
+        TObjectRef<AssetBase> base;
+        base = material_instance->get_base();
+        if (!add(base))
+            return false;
+
+        std::vector<std::pair<std::string, uint64_t>> textures, samplers;
+        for (const auto& [binding, texture] : material_instance->get_textures())
+        {
+            TObjectRef<AssetBase> asset;
+            asset = texture;
+            if (add(asset))
+                textures.emplace_back(binding, asset->get_content_hash());
+        }
+        for (const auto& [binding, sampler] : material_instance->get_samplers())
+        {
+            TObjectRef<AssetBase> asset;
+            asset = sampler;
+            if (add(asset))
+                samplers.emplace_back(binding, asset->get_content_hash());
+        }
+
+        writer.write(base->get_content_hash());
+        for (const auto& parameters : {&textures, &samplers})
+        {
+            writer.write(static_cast<uint32_t>(parameters->size()));
+            for (const auto& [binding, hash] : *parameters)
+            {
+                writer.write_string(binding);
+                writer.write(hash);
+            }
+        }
+        return true;
+    }
+
+    bool write_mesh(const TObjectRef<MeshAsset>& mesh, AssetDataWriter& writer)
+    {
+        const std::vector<AssetPayloads::MeshSection>* payload = payloads.find_mesh(mesh->get_content_hash());
+        if (!payload || payload->size() != mesh->get_sections().size())
+            return false;
+
+        writer.write(static_cast<uint32_t>(payload->size()));
+        for (size_t i = 0; i < payload->size(); ++i)
+        {
+            const MeshAsset::Section&         section      = mesh->get_sections()[i];
+            const AssetPayloads::MeshSection& section_data = (*payload)[i];
+            TObjectRef<AssetBase>             material;
+            material = section.material;
+
+            writer.write_string(section_data.name);
+            writer.write(add(material) ? material->get_content_hash() : uint64_t{0});
+            writer.write(section.bounds.min());
+            writer.write(section.bounds.max());
+            writer.write_array(section_data.vertices.data(), section_data.vertices.size() * sizeof(MeshAsset::Vertex));
+            writer.write(static_cast<uint32_t>(section_data.indices->get_stride()));
+            writer.write_array(section_data.indices->data(), section_data.indices->get_byte_size());
+            writer.write_array(section_data.lods.data(), section_data.lods.size() * sizeof(MeshLod));
+        }
+        return true;
+    }
+
+    const AssetPayloads&                         payloads;
+    std::function<uint32_t(const char*)>         add_string;
+    ankerl::unordered_dense::map<uint64_t, bool> stored; // False for the assets that could not be stored
+};
+
+template <typename T> static TObjectRef<T> find_asset(const ankerl::unordered_dense::map<uint64_t, TObjectRef<AssetBase>>& assets, uint64_t hash)
+{
+    const auto found = assets.find(hash);
+    return found != assets.end() ? found->second.cast<T>() : TObjectRef<T>{};
+}
+
+// Create the asset stored in the file. Its dependencies are already in the given map.
+static TObjectRef<AssetBase> create_asset(const SceneFileAsset& record, const std::string& name, AssetDataReader& reader, AssetRegistry& registry,
+                                          const ankerl::unordered_dense::map<uint64_t, TObjectRef<AssetBase>>& assets)
+{
+    switch (record.type)
+    {
+    case SceneFileAssetType::Texture:
+    {
+        const TextureAsset::CreateInfos infos{
+            .width      = reader.read<uint32_t>(),
+            .height     = reader.read<uint32_t>(),
+            .depth      = reader.read<uint32_t>(),
+            .format     = static_cast<Gfx::ColorFormat>(reader.read<uint32_t>()),
+            .array_size = reader.read<uint32_t>(),
+        };
+
+        // The mips point into the mapped file, the texture copies them to the staging memory
+        std::vector<Gfx::BufferData> mips;
+        for (uint32_t i = 0, count = reader.read<uint32_t>(); i < count && reader.valid(); ++i)
+        {
+            const auto bytes = reader.read_array();
+            mips.emplace_back(bytes.data(), 1, bytes.size());
+        }
+        if (!reader.valid())
+            return {};
+        return registry.create<TextureAsset>(name, mips, infos);
+    }
+    case SceneFileAssetType::Sampler:
+        return registry.create<SamplerAsset>(name);
+    case SceneFileAssetType::Material:
+    {
+        const std::string shader_path = reader.read_string();
+        const auto        inputs_data = reader.read_array();
+        if (!reader.valid() || inputs_data.size() % sizeof(StageInputOutputDescription) != 0)
+            return {};
+        std::vector<StageInputOutputDescription> vertex_inputs;
+        vertex_inputs.reserve(inputs_data.size() / sizeof(StageInputOutputDescription));
+        for (size_t offset = 0; offset < inputs_data.size(); offset += sizeof(StageInputOutputDescription))
+        {
+            StageInputOutputDescription input{0, 0, Gfx::ColorFormat::UNDEFINED};
+            std::memcpy(&input, inputs_data.data() + offset, sizeof(StageInputOutputDescription));
+            vertex_inputs.emplace_back(input);
+        }
+        auto material = registry.create<MaterialAsset>(name);
+        material->set_shader_code(shader_path, vertex_inputs);
+        return material;
+    }
+    case SceneFileAssetType::MaterialInstance:
+    {
+        const auto base = find_asset<MaterialAsset>(assets, reader.read<uint64_t>());
+        if (!base)
+            return {};
+        auto material_instance = registry.create<MaterialInstanceAsset>(name, base);
+        for (uint32_t i = 0, count = reader.read<uint32_t>(); i < count && reader.valid(); ++i)
+        {
+            const std::string binding = reader.read_string();
+            if (const auto texture = find_asset<TextureAsset>(assets, reader.read<uint64_t>()))
+                material_instance->set_texture(binding, texture);
+        }
+        for (uint32_t i = 0, count = reader.read<uint32_t>(); i < count && reader.valid(); ++i)
+        {
+            const std::string binding = reader.read_string();
+            if (const auto sampler = find_asset<SamplerAsset>(assets, reader.read<uint64_t>()))
+                material_instance->set_sampler(binding, sampler);
+        }
+        return material_instance;
+    }
+    case SceneFileAssetType::Mesh:
+    {
+        auto mesh = registry.create<MeshAsset>(name);
+        for (uint32_t i = 0, count = reader.read<uint32_t>(); i < count && reader.valid(); ++i)
+        {
+            const std::string section_name = reader.read_string();
+            const auto        material     = find_asset<MaterialInstanceAsset>(assets, reader.read<uint64_t>());
+            const auto        bounds_min   = reader.read<glm::vec3>();
+            const auto        bounds_max   = reader.read<glm::vec3>();
+            const auto        vertex_data  = reader.read_array();
+            const auto        index_stride = reader.read<uint32_t>();
+            const auto        index_data   = reader.read_array();
+            const auto        lod_data     = reader.read_array();
+            if (!reader.valid() || index_stride == 0 || index_data.size() % index_stride != 0)
+                break;
+
+            std::vector<MeshAsset::Vertex> vertices(vertex_data.size() / sizeof(MeshAsset::Vertex));
+            std::memcpy(vertices.data(), vertex_data.data(), vertices.size() * sizeof(MeshAsset::Vertex));
+            std::vector<MeshLod> lods(lod_data.size() / sizeof(MeshLod));
+            std::memcpy(lods.data(), lod_data.data(), lods.size() * sizeof(MeshLod));
+            mesh->add_section(section_name, vertices, Gfx::BufferData(index_data.data(), index_stride, index_data.size() / index_stride), material, Bounds(bounds_min, bounds_max), lods);
+        }
+        return mesh;
+    }
+    }
+    return {};
+}
+
+void AssetPayloads::add_texture(uint64_t hash, const std::vector<Gfx::BufferData>& mips, const TextureAsset::CreateInfos& infos)
+{
+    Texture& texture = textures.insert_or_assign(hash, Texture{.infos = infos}).first->second;
+    for (const auto& mip : mips)
+        texture.mips.emplace_back(static_cast<const uint8_t*>(mip.data()), static_cast<const uint8_t*>(mip.data()) + mip.get_byte_size());
+}
+
+void AssetPayloads::add_mesh(uint64_t hash, std::vector<MeshSection> sections)
+{
+    meshes.insert_or_assign(hash, std::move(sections));
+}
+
+const AssetPayloads::Texture* AssetPayloads::find_texture(uint64_t hash) const
+{
+    const auto found = textures.find(hash);
+    return found != textures.end() ? &found->second : nullptr;
+}
+
+const std::vector<AssetPayloads::MeshSection>* AssetPayloads::find_mesh(uint64_t hash) const
+{
+    const auto found = meshes.find(hash);
+    return found != meshes.end() ? &found->second : nullptr;
+}
+
+bool SceneSerializer::save(const Scene& scene, const std::filesystem::path& path, const AssetPayloads& payloads)
+{
+    PROFILER_SCOPE(SaveScene);
+
+    std::vector<uint64_t>                                            class_table;
+    std::vector<SceneFileNode>                                       nodes;
+    std::string                                                      strings;
+    ankerl::unordered_dense::map<const Reflection::Class*, uint32_t> class_indices;
+    std::vector<std::pair<const SceneComponent*, uint32_t>>          stack;
+    const auto                                                       add_string = [&](const char* string)
+    {
+        const auto offset = static_cast<uint32_t>(strings.size());
+        strings.append(string ? string : "");
+        strings.push_back('\0');
+        return offset;
+    };
+    AssetTableWriter asset_table(payloads, add_string);
+
+    for (auto it = scene.get_nodes().rbegin(); it != scene.get_nodes().rend(); ++it)
+        if (*it)
+            stack.emplace_back(it->operator->(), scene_file_no_parent);
+    while (!stack.empty())
+    {
+        const auto [component, parent] = stack.back();
+        stack.pop_back();
+
+        const Reflection::Class* component_class = component->get_class();
+        if (!component_class->can_construct())
+        {
+            LOG_WARNING("Component {} of class {} cannot be created from its class and will not be saved", component->get_name(), component_class->name());
+            continue;
+        }
+        auto [class_it, new_class] = class_indices.emplace(component_class, static_cast<uint32_t>(class_table.size()));
+        if (new_class)
+            class_table.emplace_back(add_string(component_class->name()));
+
+        const TObjectRef<AssetBase> asset = component->get_serialized_asset();
+        const auto                  index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back(SceneFileNode{
+            .parent      = parent,
+            .class_index = class_it->second,
+            .name_offset = add_string(component->get_name()),
+            .padding_0   = 0,
+            .position    = component->get_relative_position(),
+            .rotation    = component->get_relative_rotation(),
+            .scale       = component->get_relative_scale(),
+            .padding_1   = 0,
+            .asset_hash  = asset ? asset->get_content_hash() : 0,
+        });
+        if (asset && asset->get_content_hash() == 0)
+            LOG_WARNING("Asset {} used by {} has no content hash : it will not be restored", asset->get_name(), component->get_name());
+        else if (asset)
+            asset_table.add(asset);
+
+        for (auto it = component->get_nodes().rbegin(); it != component->get_nodes().rend(); ++it)
+            if (*it)
+                stack.emplace_back(it->operator->(), index);
+    }
+
+    const SceneFileHeader header{
+        .magic             = {scene_file_magic[0], scene_file_magic[1], scene_file_magic[2], scene_file_magic[3]},
+        .version           = scene_file_version,
+        .class_count       = static_cast<uint32_t>(class_table.size()),
+        .node_count        = static_cast<uint32_t>(nodes.size()),
+        .asset_count       = static_cast<uint32_t>(asset_table.records.size()),
+        .padding           = 0,
+        .asset_data_size   = asset_table.data.size(),
+        .string_table_size = strings.size(),
+    };
+    if (asset_table.missing_payloads > 0)
+        LOG_WARNING("{} assets of {} have no payload : they are only referenced by hash", asset_table.missing_payloads, path.string());
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        LOG_ERROR("Failed to open {} for writing", path.string());
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(class_table.data()), static_cast<std::streamsize>(class_table.size() * sizeof(uint64_t)));
+    file.write(reinterpret_cast<const char*>(nodes.data()), static_cast<std::streamsize>(nodes.size() * sizeof(SceneFileNode)));
+    file.write(reinterpret_cast<const char*>(asset_table.records.data()), static_cast<std::streamsize>(asset_table.records.size() * sizeof(SceneFileAsset)));
+    file.write(reinterpret_cast<const char*>(asset_table.data.data()), static_cast<std::streamsize>(asset_table.data.size()));
+    file.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+    if (!file)
+    {
+        LOG_ERROR("Failed to write scene file {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+bool SceneSerializer::load(Scene& scene, const std::filesystem::path& path, AssetRegistry& registry)
+{
+    PROFILER_SCOPE_NAMED(LoadScene, std::format("Load scene {}", path.filename().string()));
+    const auto start_time = std::chrono::steady_clock::now();
+
+    const MappedFile file(path);
+    if (!file)
+        return false;
+
+    SceneFileHeader header;
+    if (file.size() < sizeof(header))
+    {
+        LOG_ERROR("Invalid scene file {}", path.string());
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    const size_t class_table_offset  = sizeof(header);
+    const size_t node_offset         = class_table_offset + header.class_count * sizeof(uint64_t);
+    const size_t asset_offset        = node_offset + header.node_count * sizeof(SceneFileNode);
+    const size_t asset_data_offset   = asset_offset + header.asset_count * sizeof(SceneFileAsset);
+    const size_t string_table_offset = asset_data_offset + header.asset_data_size;
+    if (std::memcmp(header.magic, scene_file_magic, sizeof(scene_file_magic)) != 0 || header.version != scene_file_version || string_table_offset + header.string_table_size != file.size() ||
+        (header.string_table_size > 0 && file.data()[file.size() - 1] != '\0'))
+    {
+        LOG_ERROR("Invalid or outdated scene file {}", path.string());
+        return false;
+    }
+
+    // The mapping is page aligned and every section is 8 bytes aligned : the records are read in place
+    const auto* class_table = reinterpret_cast<const uint64_t*>(file.data() + class_table_offset);
+    const auto* nodes       = reinterpret_cast<const SceneFileNode*>(file.data() + node_offset);
+    const auto* asset_table = reinterpret_cast<const SceneFileAsset*>(file.data() + asset_offset);
+    const auto* asset_data  = file.data() + asset_data_offset;
+    const auto* strings     = reinterpret_cast<const char*>(file.data() + string_table_offset);
+
+    std::vector<const Reflection::Class*> classes(header.class_count, nullptr);
+    for (uint32_t i = 0; i < header.class_count; ++i)
+    {
+        if (class_table[i] >= header.string_table_size)
+        {
+            LOG_ERROR("Invalid scene file {}", path.string());
+            return false;
+        }
+        classes[i] = Reflection::Class::get(strings + class_table[i]);
+        if (!classes[i])
+            LOG_ERROR("Unknown component class {} in scene file {}", strings + class_table[i], path.string());
+    }
+
+    // Grow each component pool once for the whole file
+    std::vector<size_t> class_node_count(header.class_count, 0);
+    for (uint32_t i = 0; i < header.node_count; ++i)
+        if (nodes[i].class_index < header.class_count)
+            ++class_node_count[nodes[i].class_index];
+    for (uint32_t i = 0; i < header.class_count; ++i)
+        if (classes[i])
+            scene.reserve_components(classes[i], class_node_count[i]);
+
+    ankerl::unordered_dense::map<uint64_t, TObjectRef<AssetBase>> assets;
+    registry.for_each(
+        [&](const TObjectPtr<AssetBase>& asset)
+        {
+            if (asset->get_content_hash() != 0)
+                assets.emplace(asset->get_content_hash(), asset);
+        });
+
+    // Only the assets missing from the registry are created, the others are shared with the scenes already loaded
+    size_t created_assets = 0;
+    for (uint32_t i = 0; i < header.asset_count; ++i)
+    {
+        const SceneFileAsset& record = asset_table[i];
+        if (record.name_offset >= header.string_table_size || record.data_offset > header.asset_data_size || record.data_size > header.asset_data_size - record.data_offset)
+        {
+            LOG_ERROR("Invalid scene file {}", path.string());
+            return false;
+        }
+        if (assets.contains(record.hash))
+            continue;
+
+        AssetDataReader             reader(asset_data + record.data_offset, record.data_size);
+        const TObjectRef<AssetBase> asset = create_asset(record, strings + record.name_offset, reader, registry, assets);
+        if (!asset || !reader.valid())
+        {
+            LOG_ERROR("Failed to load asset {} from scene file {}", strings + record.name_offset, path.string());
+            continue;
+        }
+        asset->set_content_hash(record.hash);
+        assets.emplace(record.hash, asset);
+        ++created_assets;
+    }
+
+    std::vector<TObjectRef<SceneComponent>> components(header.node_count);
+    size_t                                  missing_assets = 0;
+    for (uint32_t i = 0; i < header.node_count; ++i)
+    {
+        const SceneFileNode& node = nodes[i];
+        if (node.class_index >= header.class_count || node.name_offset >= header.string_table_size || (node.parent != scene_file_no_parent && node.parent >= i))
+        {
+            LOG_ERROR("Invalid scene file {}", path.string());
+            return false;
+        }
+
+        // The children of the components that could not be created are attached to the root
+        const TObjectRef<SceneComponent> parent    = node.parent != scene_file_no_parent ? components[node.parent] : TObjectRef<SceneComponent>{};
+        TObjectRef<SceneComponent>       component = scene.add_component_of_class(classes[node.class_index], strings + node.name_offset, parent);
+        if (!component)
+            continue;
+        component->set_position(node.position);
+        component->set_rotation(node.rotation);
+        component->set_scale(node.scale);
+        if (node.asset_hash != 0)
+        {
+            if (auto asset = assets.find(node.asset_hash); asset != assets.end())
+                component->set_serialized_asset(asset->second);
+            else
+                ++missing_assets;
+        }
+        components[i] = component;
+    }
+
+    if (missing_assets > 0)
+        LOG_WARNING("{} assets referenced by scene file {} are not loaded", missing_assets, path.string());
+    LOG_INFO("Loaded {} components and {} assets from {} in {:.2f}ms", header.node_count, created_assets, path.string(),
+             std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+    return true;
+}
+} // namespace Eng
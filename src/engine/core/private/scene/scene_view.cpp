@@ -3,9 +3,20 @@
 #include "engine.hpp"
 #include "profiler.hpp"
 #include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "assets/material_instance_asset.hpp"
+#include "assets/mesh_asset.hpp"
 #include "gfx/vulkan/buffer.hpp"
-#include "scene/components/mesh_component.hpp"
+#include "gfx/vulkan/command_buffer.hpp"
+#include "gfx/vulkan/pipeline_layout.hpp"
+#include "jobsys/radix_sort.hpp"
+#include "scene/render_scene.hpp"
+#include "scene/scene.hpp"
+#include "scene/scene_visibility.hpp"
 
+#include <array>
+#include <cstring>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
 #include <glm/ext/matrix_float4x4.hpp>
 
 namespace Eng
@@ -21,44 +32,223 @@ struct SceneBufferData
     glm::mat4 inv_perspective_mat;
 };
 
-void SceneView::pre_draw(const Gfx::RenderPassInstanceBase& render_pass)
+// Start of the mesh push constants, the material writes the bindless indices of its textures after them
+struct Pc
+{
+    glm::mat4 model;
+    uint32_t  instance_offset;
+};
+
+// Spread a pointer over the given number of bits. Collisions only reduce the sort quality, binds are still compared on the real resources.
+static uint64_t key_bits(const void* ptr, uint32_t bits)
+{
+    return (reinterpret_cast<uintptr_t>(ptr) >> 4) * 0x9E3779B97F4A7C15ull >> (64 - bits);
+}
+
+// [63-56] pass layer | [55-40] pipeline | [39-20] material | [19-4] mesh | [3-0] lod
+// Materials without descriptors of their own share the descriptors of their pipeline, so sorting by pipeline first groups the descriptor binds too
+static uint64_t make_sort_key(const Gfx::Pipeline& pipeline, const MaterialInstanceAsset* material, const Gfx::Mesh* mesh, uint32_t lod)
+{
+    return static_cast<uint64_t>(pipeline.infos().options.alpha) << 56 | key_bits(&pipeline, 16) << 40 | key_bits(material, 20) << 20 | key_bits(mesh, 16) << 4 | std::min(lod, 15u);
+}
+
+void SceneView::pre_draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass)
 {
     PROFILER_SCOPE(ScenePreDraw);
 
+    render_scene = scene.get_render_scene();
+
+    // The proxies are rebased around the camera of the render scene : express the matrices in the same space so they stay precise in float
+    if (render_scene && render_scene->get_origin() != origin)
+    {
+        origin   = render_scene->get_origin();
+        outdated = true;
+    }
     update_matrices(render_pass.resolution(), render_pass.get_definition().reversed_logarithmic_depth);
 
     glm::mat4 inv_view             = inverse(view);
     glm::mat4 inv_perspective      = inverse(projection_view);
     glm::mat4 inv_perspective_view = inv_view * inv_perspective;
 
-    if (!view_buffer)
-        view_buffer = Gfx::Buffer::create("Scene_buffer", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(SceneBufferData), 1);
+    view_buffer = Engine::get().get_device().lock()->get_transient_allocator().write(Gfx::BufferData{SceneBufferData{.perspective_view_mat = projection_view,
+                                                                                                      .view_mat = view,
+                                                                                                      .perspective_mat = projection_view,
+                                                                                                      .inv_perspective_view_mat = inv_perspective_view,
+                                                                                                      .inv_view_mat = inv_view,
+                                                                                                      .inv_perspective_mat = inv_perspective}});
+
+    build_draw_packets(scene, render_pass);
+}
+
+void SceneView::build_draw_packets(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass)
+{
+    PROFILER_SCOPE(BuildDrawPackets);
+    draw_packets.clear();
+    sorted_packets.clear();
+    if (!render_scene)
+        return;
+
+    const auto&               proxies = render_scene->get_proxies();
+    const Gfx::RenderPassRef& pass    = render_pass.get_definition().render_pass_ref;
+
+    // Reuse the culling pass shared by every view of the scene when this view was part of it
+    uint64_t   view_bit = 0;
+    const auto masks    = scene.get_visibility().get_masks(*render_scene, *this, view_bit);
+
+    // Cull and resolve resources in parallel, each job writes its own packet list
+    const size_t                         job_count = std::clamp<size_t>(proxies.size() / 1024, 1, std::max<size_t>(1, JobSystem::get().get_workers().size()));
+    std::vector<std::vector<DrawPacket>> job_packets(job_count);
+    JobSys::parallel_for(job_count,
+                         [&](size_t job)
+                         {
+                             auto&        packets = job_packets[job];
+                             const size_t end     = proxies.size() * (job + 1) / job_count;
+                             for (size_t i = proxies.size() * job / job_count; i < end; ++i)
+                             {
+                                 const RenderProxy& proxy = proxies[i];
+                                 if (!proxy.material || (masks ? ((*masks)[i] & view_bit) == 0 : !frustum.test(proxy.bounds)))
+                                     continue;
+
+                                 // Skipped until its pipeline is compiled
+                                 auto pipeline = proxy.material->try_get_base_resource(pass);
+                                 if (!pipeline)
+                                     continue;
+                                 auto descriptors = proxy.material->get_descriptor_resource(pass);
+                                 assert(descriptors);
+                                 packets.emplace_back(&proxy, std::move(pipeline), std::move(descriptors), select_lod(proxy));
+                             }
+                         });
 
-    view_buffer->set_data(0, Gfx::BufferData{SceneBufferData{.perspective_view_mat = projection_view,
-                                                             .view_mat = view,
-                                                             .perspective_mat = projection_view,
-                                                             .inv_perspective_view_mat = inv_perspective_view,
-                                                             .inv_view_mat = inv_view,
-                                                             .inv_perspective_mat = inv_perspective}});
+    for (auto& packets : job_packets)
+        for (auto& packet : packets)
+        {
+            sorted_packets.emplace_back(make_sort_key(*packet.pipeline, packet.proxy->material.operator->(), packet.proxy->mesh.get(), packet.lod), static_cast<uint32_t>(draw_packets.size()));
+            draw_packets.emplace_back(std::move(packet));
+        }
+
+    JobSys::radix_sort(sorted_packets,
+                       [](const SortedPacket& packet)
+                       {
+                           return packet.key;
+                       });
+
+    build_draw_batches(render_pass);
 }
 
-void SceneView::pre_submit() const
+void SceneView::build_draw_batches(const Gfx::RenderPassInstanceBase& render_pass)
 {
-    view_buffer->wait_data_upload();
+    PROFILER_SCOPE(BuildDrawBatches);
+    draw_batches.clear();
+    instance_transforms.clear();
+
+    // Identical (pipeline, material, mesh, lod) have identical keys, so they are contiguous once sorted
+    for (uint32_t i = 0; i < sorted_packets.size(); ++i)
+    {
+        const DrawPacket& packet = draw_packets[sorted_packets[i].packet];
+        if (!draw_batches.empty() && draw_batches.back().instanced)
+        {
+            DrawBatch&        batch = draw_batches.back();
+            const DrawPacket& first = draw_packets[sorted_packets[batch.first_packet].packet];
+            if (first.pipeline == packet.pipeline && first.proxy->material == packet.proxy->material && first.proxy->mesh == packet.proxy->mesh && first.lod == packet.lod)
+            {
+                instance_transforms.emplace_back(packet.proxy->transform);
+                ++batch.instance_count;
+                continue;
+            }
+        }
+
+        // Materials compiled without FEAT_INSTANCED keep one draw per section with the transform in push constants
+        const bool instanced = packet.pipeline->get_layout()->has_binding("instance_transforms");
+        draw_batches.emplace_back(i, instanced ? static_cast<uint32_t>(instance_transforms.size()) : 0, 1, instanced);
+        if (instanced)
+            instance_transforms.emplace_back(packet.proxy->transform);
+    }
+
+    if (!instance_transforms.empty())
+        instance_buffer = Engine::get().get_device().lock()->get_transient_allocator().write(Gfx::BufferData(instance_transforms));
+
+    // The frame data only changes the dynamic offsets of the descriptors : bind it once per descriptor set instead of once per proxy
+    const Gfx::RenderPassRef& pass             = render_pass.get_definition().render_pass_ref;
+    const Gfx::DescriptorSet* last_descriptors = nullptr;
+    for (const auto& batch : draw_batches)
+    {
+        const DrawPacket& packet = draw_packets[sorted_packets[batch.first_packet].packet];
+        if (packet.descriptors.get() == last_descriptors)
+            continue;
+        last_descriptors = packet.descriptors.get();
+        packet.proxy->material->set_scene_data(pass, view_buffer);
+        if (batch.instanced)
+            packet.proxy->material->set_buffer(pass, "instance_transforms", instance_buffer);
+    }
+}
+
+void SceneView::pre_submit()
+{
+    draw_packets.clear();
+    sorted_packets.clear();
+    draw_batches.clear();
+    render_scene = nullptr;
 }
 
-void SceneView::draw(const Scene& scene, const Gfx::RenderPassInstanceBase&, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const
+void SceneView::draw(const Gfx::RenderPassInstanceBase& render_pass, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const
 {
     PROFILER_SCOPE(SceneDraw);
-    scene.for_each_part<MeshComponent>(
-        [&command_buffer, this](MeshComponent& object)
+    const Gfx::RenderPassRef& pass = render_pass.get_definition().render_pass_ref;
+
+    // Each recording thread gets a contiguous range of the sorted batches, so redundant binds are collapsed by the command buffer
+    const size_t parts = std::max(1llu, num_threads);
+    const size_t begin = draw_batches.size() * idx / parts;
+    const size_t end   = draw_batches.size() * (idx + 1) / parts;
+
+    for (size_t i = begin; i < end; ++i)
+    {
+        const DrawBatch&  batch  = draw_batches[i];
+        const DrawPacket& packet = draw_packets[sorted_packets[batch.first_packet].packet];
+        command_buffer.bind_pipeline(packet.pipeline);
+
+        // 128 bytes is the smallest push constant size the devices have to support
+        std::array<uint8_t, 128> push_constants{};
+        const Pc                 pc = {.model = packet.proxy->transform, .instance_offset = batch.instance_offset};
+        std::memcpy(push_constants.data(), &pc, sizeof(Pc));
+        packet.proxy->material->write_push_constants(pass, push_constants);
+        if (const uint32_t push_size = std::min(packet.pipeline->get_layout()->get_push_constant_size(), static_cast<uint32_t>(push_constants.size())); push_size > 0)
+            command_buffer.push_constant(Gfx::EShaderStage::Vertex, *packet.pipeline, Gfx::BufferData(push_constants.data(), 1, push_size));
+
+        command_buffer.bind_descriptors(*packet.descriptors, *packet.pipeline);
+        if (packet.proxy->lods)
         {
-            object.draw(command_buffer, *this);
-        },
-        idx, std::max(1llu, num_threads));
+            const MeshLod& lod = (*packet.proxy->lods)[packet.lod];
+            command_buffer.draw_mesh(*packet.proxy->mesh, lod.first_index, lod.vertex_offset, lod.index_count, batch.instance_count);
+        }
+        else
+            command_buffer.draw_mesh(*packet.proxy->mesh, batch.instance_count);
+    }
 }
 
-void SceneView::set_position(const glm::vec3& in_position)
+uint32_t SceneView::select_lod(const RenderProxy& proxy) const
+{
+    if (!proxy.lods || proxy.lods->size() < 2)
+        return 0;
+
+    // Lod errors are in object space, scale them by the largest axis of the transform
+    const float scale = std::sqrt(std::max({dot(glm::vec3(proxy.transform[0]), glm::vec3(proxy.transform[0])), dot(glm::vec3(proxy.transform[1]), glm::vec3(proxy.transform[1])),
+                                            dot(glm::vec3(proxy.transform[2]), glm::vec3(proxy.transform[2]))}));
+
+    float pixels_per_unit = lod_pixel_scale * scale;
+    if (!orthographic)
+    {
+        // Use the closest point of the bounds so large sections are refined as soon as the camera gets near any part of them
+        const glm::vec3 closest = clamp(render_position, min(proxy.bounds.min(), proxy.bounds.max()), max(proxy.bounds.min(), proxy.bounds.max()));
+        pixels_per_unit /= std::max(distance(render_position, closest), z_near);
+    }
+
+    uint32_t lod = 0;
+    for (uint32_t i = 1; i < proxy.lods->size() && (*proxy.lods)[i].error * pixels_per_unit <= lod_error_threshold; ++i)
+        lod = i;
+    return lod;
+}
+
+void SceneView::set_position(const glm::dvec3& in_position)
 {
     if (in_position == position)
         return;
@@ -74,20 +264,48 @@ void SceneView::set_rotation(const glm::quat& in_rotation)
     outdated = true;
 }
 
-void SceneView::update_matrices(const glm::uvec2& in_resolution, bool reversed_z)
+void SceneView::update_matrices(const glm::uvec2& in_resolution, bool in_reversed_z)
 {
-    if (!outdated && resolution == in_resolution)
+    if (!outdated && resolution == in_resolution && reversed_z == in_reversed_z)
         return;
-    if (orthographic && reversed_z)
+    if (orthographic && in_reversed_z)
         LOG_ERROR("Reversed_z with orthographic perspectives is not supported");
     outdated = false;
 
-    view       = translate(mat4_cast(inverse(rotation)), -position);
-    resolution = in_resolution;
+    view            = compute_view_matrix(origin);
+    render_position = glm::vec3(position - origin);
+    resolution      = in_resolution;
+    reversed_z      = in_reversed_z;
     if (resolution.x == 0 || resolution.y == 0)
         return;
 
-    float aspect = static_cast<float>(resolution.x) / static_cast<float>(resolution.y);
+    projection = compute_projection_matrix(resolution, reversed_z);
+    if (orthographic)
+        lod_pixel_scale = static_cast<float>(resolution.x) / (2.f * fov);
+    else
+        lod_pixel_scale = 0.5f * static_cast<float>(resolution.y) / std::tan(glm::radians(fov) * 0.5f);
+
+    projection_view = projection * view;
+
+    frustum = Frustum(projection_view);
+}
+
+glm::mat4 SceneView::predict_projection_view_matrix(const glm::dvec3& in_origin) const
+{
+    if (resolution.x == 0 || resolution.y == 0)
+        return projection_view;
+    return compute_projection_matrix(resolution, reversed_z) * compute_view_matrix(in_origin);
+}
+
+glm::mat4 SceneView::compute_view_matrix(const glm::dvec3& in_origin) const
+{
+    // Subtract in double precision first, only the small camera relative offset is converted to float
+    return translate(mat4_cast(inverse(rotation)), glm::vec3(in_origin - position));
+}
+
+glm::mat4 SceneView::compute_projection_matrix(const glm::uvec2& in_resolution, bool in_reversed_z) const
+{
+    float aspect = static_cast<float>(in_resolution.x) / static_cast<float>(in_resolution.y);
     assert(std::abs(aspect - std::numeric_limits<float>::epsilon()) > static_cast<float>(0));
 
     if (orthographic)
@@ -97,44 +315,36 @@ void SceneView::update_matrices(const glm::uvec2& in_resolution, bool reversed_z
         float top    = fov / aspect;
         float bottom = -fov / aspect;
 
-        float h    = 2.f / (top - bottom);
-        float w    = 2.f / (right - left);
-            
-        projection = {
+        float h = 2.f / (top - bottom);
+        float w = 2.f / (right - left);
+
+        return {
             {0, 0, 1.f / (z_far - z_near), 0},
             {-w, 0, 0, 0},
             {0, h, 0, 0},
-            { -(right + left) / (right - left), -(top + bottom) / (top - bottom), -z_near / (z_far - z_near), 1},
+            {-(right + left) / (right - left), -(top + bottom) / (top - bottom), -z_near / (z_far - z_near), 1},
         };
     }
-    else
+
+    if (in_reversed_z)
     {
-        if (reversed_z)
-        {
-            float h     = 1.f / std::tan(glm::radians(fov) * 0.5f);
-            float w     = h / aspect;
-            projection = {
-                {0, 0, 0, 1},
-                {-w, 0, 0, 0},
-                {0, h, 0, 0},
-                {0, 0, z_near, 0}};
-        }
-        else
-        {
-            float const tan_half_fov = tan(glm::radians(fov) * 0.5f);
-            float       h            = 1 / tan_half_fov;
-            float       w            = 1 / (aspect * tan_half_fov);
-            projection              = {
-                {0, 0, z_far / (z_far - z_near), 1},
-                {-w, 0, 0, 0},
-                {0, h, 0, 0},
-                {0, 0, -(z_far * z_near) / (z_far - z_near), 0}};
-        }
+        float h = 1.f / std::tan(glm::radians(fov) * 0.5f);
+        float w = h / aspect;
+        return {
+            {0, 0, 0, 1},
+            {-w, 0, 0, 0},
+            {0, h, 0, 0},
+            {0, 0, z_near, 0}};
     }
 
-    projection_view = projection * view;
-
-    frustum = Frustum(projection_view);
+    float const tan_half_fov = tan(glm::radians(fov) * 0.5f);
+    float       h            = 1 / tan_half_fov;
+    float       w            = 1 / (aspect * tan_half_fov);
+    return {
+        {0, 0, z_far / (z_far - z_near), 1},
+        {-w, 0, 0, 0},
+        {0, h, 0, 0},
+        {0, 0, -(z_far * z_near) / (z_far - z_near), 0}};
 }
 
 } // namespace Eng
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include "scene/scene_visibility.hpp"
+
+#include "profiler.hpp"
+#include "jobsys/parallel_for.hpp"
+#include "scene/render_scene.hpp"
+
+#include <bit>
+
+namespace Eng
+{
+std::shared_ptr<const std::vector<uint64_t>> SceneVisibility::get_masks(const RenderScene& render_scene, const SceneView& view, uint64_t& out_view_bit)
+{
+    std::lock_guard lk(mutex);
+
+    if (culled_scene != &render_scene || culled_frame != render_scene.get_frame())
+        cull(render_scene);
+
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        const ViewSlot& slot = views[i];
+        if (slot.view_ptr != &view || slot.view.expired())
+            continue;
+        // Registered after the shared pass, or the view matrices changed since (resized target for example)
+        if ((culled_views & 1ull << i) == 0 || slot.projection_view != view.get_projection_view_matrix())
+            return nullptr;
+        out_view_bit = 1ull << i;
+        return masks;
+    }
+
+    // Register the view for the next render scenes
+    ViewSlot new_slot{.view = view.weak_from_this(), .view_ptr = &view};
+    for (auto& slot : views)
+        if (slot.view.expired())
+        {
+            slot = new_slot;
+            return nullptr;
+        }
+    if (views.size() < max_views)
+        views.emplace_back(new_slot);
+    return nullptr;
+}
+
+void SceneVisibility::cull(const RenderScene& render_scene)
+{
+    PROFILER_SCOPE(SharedCulling);
+    culled_scene = &render_scene;
+    culled_frame = render_scene.get_frame();
+
+    culled_views = 0;
+    for (size_t i = 0; i < views.size(); ++i)
+    {
+        ViewSlot& slot = views[i];
+        if (auto view = slot.view.lock())
+        {
+            slot.projection_view = view->predict_projection_view_matrix(render_scene.get_origin());
+            slot.frustum         = Frustum(slot.projection_view);
+            culled_views |= 1ull << i;
+        }
+    }
+
+    // The views of the previous render scene may still read its masks : they are only reused once released (new references are only taken here)
+    if (!masks || masks.use_count() > 1)
+        masks = std::make_shared<std::vector<uint64_t>>();
+    const auto& proxies = render_scene.get_proxies();
+    masks->resize(proxies.size());
+
+    const size_t job_count = std::clamp<size_t>(proxies.size() / 1024, 1, std::max<size_t>(1, JobSystem::get().get_workers().size()));
+    JobSys::parallel_for(job_count,
+                         [&](size_t job)
+                         {
+                             const size_t end = proxies.size() * (job + 1) / job_count;
+                             for (size_t i = proxies.size() * job / job_count; i < end; ++i)
+                             {
+                                 uint64_t mask = 0;
+                                 for (uint64_t remaining = culled_views; remaining != 0; remaining &= remaining - 1)
+                                 {
+                                     const int view = std::countr_zero(remaining);
+                                     if (views[view].frustum.test(proxies[i].bounds))
+                                         mask |= 1ull << view;
+                                 }
+                                 (*masks)[i] = mask;
+                             }
+                         });
+}
+} // namespace Eng
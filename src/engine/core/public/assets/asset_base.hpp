@@ -2,6 +2,7 @@
 
 #include "object_ptr.hpp"
 
+#include <cstdint>
 #include <glm/vec3.hpp>
 #include "assets/asset_base.gen.hpp"
 
@@ -43,6 +44,19 @@ public:
         return {1, 1, 1};
     }
 
+    /**
+     * Hash of the data this asset was created from, used to reference it from serialized scenes. 0 if unknown.
+     */
+    uint64_t get_content_hash() const
+    {
+        return content_hash;
+    }
+
+    void set_content_hash(uint64_t in_hash)
+    {
+        content_hash = in_hash;
+    }
+
 protected:
     AssetBase() = default;
 
@@ -51,5 +65,6 @@ private:
     friend class AssetRegistry;
     char*          name;
     AssetRegistry* registry;
+    uint64_t       content_hash = 0;
 };
 } // namespace Eng
@@ -1,8 +1,10 @@
 #pragma once
 #include "asset_base.hpp"
+#include "gfx/renderer/definition/render_pass_id.hpp"
 #include "gfx/vulkan/pipeline.hpp"
 #include "gfx_types/pipeline.hpp"
 
+#include <condition_variable>
 #include <filesystem>
 
 #include <shared_mutex>
@@ -23,19 +25,54 @@ class Pipeline;
 
 namespace Eng
 {
-struct MaterialPermutation
+/**
+ * Pipelines of one permutation, compiled on the job system the first time a render pass needs them. Draws that can be skipped call
+ * try_get_resource() and never wait for the compiler, the other callers block until their pipeline is ready.
+ */
+struct MaterialPermutation : std::enable_shared_from_this<MaterialPermutation>
 {
     MaterialPermutation(MaterialAsset* owner, Gfx::PermutationDescription permutation_desc);
     ~MaterialPermutation();
+
+    // Wait for the pipeline, or compile it on the calling thread if no job started it yet. Null if the compilation failed.
     std::shared_ptr<Gfx::Pipeline> get_resource(const Gfx::RenderPassRef& render_pass);
 
+    // Null while the pipeline is being compiled in the background
+    std::shared_ptr<Gfx::Pipeline> try_get_resource(const Gfx::RenderPassRef& render_pass);
+
+    // Descriptors shared by the instances passing all their parameters through push constants (see MaterialInstanceAsset::get_descriptor_resource())
+    std::shared_ptr<Gfx::DescriptorSet> get_shared_descriptors(const Gfx::RenderPassRef& render_pass);
+
+    // Drop the queued compilations and wait for the running ones, which still use the owner. Called when the owner is destroyed.
+    void cancel_compilations();
+
 private:
+    // Material state captured when the compilation is requested, the job never reads the material itself
+    struct CompileTask
+    {
+        std::shared_ptr<ShaderCompiler::Session> session;
+        Gfx::PipelineOptions                     options;
+        std::vector<StageInputOutputDescription> vertex_inputs;
+        std::string                              name;
+
+        std::mutex              lock;
+        std::condition_variable finished_cond;
+        bool                    b_started  = false; // Whichever thread starts the task first compiles it
+        bool                    b_finished = false;
+    };
+
     struct PassInfos
     {
         ankerl::unordered_dense::map<Gfx::EShaderStage, std::vector<uint8_t>> per_stage_code;
         std::shared_ptr<Gfx::Pipeline>                                        pipeline;
+        std::shared_ptr<Gfx::DescriptorSet>                                   shared_descriptors;
+        std::shared_ptr<CompileTask>                                          compile_task; // Set until the pipeline is ready
     };
 
+    // The pending task of the pass, scheduling it on first use. Null once the pipeline is ready (written to out_pipeline).
+    std::shared_ptr<CompileTask> request_compilation(const Gfx::RenderPassRef& render_pass, std::shared_ptr<Gfx::Pipeline>& out_pipeline);
+    void                         compile(const Gfx::RenderPassRef& render_pass, const std::shared_ptr<CompileTask>& task);
+
     ankerl::unordered_dense::map<Gfx::RenderPassRef, PassInfos> passes;
     MaterialAsset*                                              owner = nullptr;
     Gfx::PermutationDescription                                 permutation_description;
@@ -47,9 +84,20 @@ class MaterialAsset : public AssetBase
 
 public:
     MaterialAsset();
+    ~MaterialAsset() override;
 
     void set_shader_code(const std::filesystem::path& code, const std::optional<std::vector<StageInputOutputDescription>>& vertex_input_override = {});
 
+    const std::filesystem::path& get_shader_path() const
+    {
+        return shader_virtual_path;
+    }
+
+    const std::vector<StageInputOutputDescription>& get_vertex_inputs() const
+    {
+        return vertex_inputs;
+    }
+
     Gfx::PermutationDescription get_default_permutation() const
     {
         return Gfx::PermutationDescription(default_permutation);
@@ -57,6 +105,12 @@ public:
 
     std::weak_ptr<MaterialPermutation> get_permutation(const Gfx::PermutationDescription& permutation);
 
+    /**
+     * Request the pipelines of every permutation for every render pass of the given types (all the registered ones if empty). They are compiled
+     * in parallel on the job system, and all share the shader module loaded by the compiler session. Does not wait for the results.
+     */
+    void precompile(const std::vector<Gfx::RenderPassGenericId>& render_pass_types = {});
+
     void update_options(const Gfx::PipelineOptions& options);
 
     void check_for_updates();
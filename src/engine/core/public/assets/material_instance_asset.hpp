@@ -6,6 +6,9 @@
 #include "assets/material_instance_asset.gen.hpp"
 #include "gfx/renderer/definition/render_pass_id.hpp"
 
+#include <functional>
+#include <span>
+
 namespace Eng
 {
 
@@ -21,6 +24,7 @@ class DescriptorSet;
 class RenderPassRef;
 class Buffer;
 class BufferData;
+struct TransientBuffer;
 } // namespace Gfx
 
 class MaterialInstanceAsset : public AssetBase
@@ -30,16 +34,46 @@ class MaterialInstanceAsset : public AssetBase
 public:
     MaterialInstanceAsset(const TObjectRef<MaterialAsset>& base_material);
 
-    std::shared_ptr<Gfx::Pipeline>      get_base_resource(const Gfx::RenderPassRef& render_pass_id);
+    std::shared_ptr<Gfx::Pipeline> get_base_resource(const Gfx::RenderPassRef& render_pass_id);
+
+    // Null while the pipeline is compiled in the background (see MaterialPermutation::try_get_resource())
+    std::shared_ptr<Gfx::Pipeline> try_get_base_resource(const Gfx::RenderPassRef& render_pass_id);
+
+    /**
+     * Textures and samplers matching a push constant member of the same name are passed as bindless indices (see write_push_constants()). When
+     * every parameter is, the descriptors are shared with the other instances of the permutation : drawing them needs no descriptor bind.
+     */
     std::shared_ptr<Gfx::DescriptorSet> get_descriptor_resource(const Gfx::RenderPassRef& render_pass_id);
 
+    // Write the bindless indices of the textures and samplers in the push constants. Requires get_descriptor_resource() for this pass.
+    void write_push_constants(const Gfx::RenderPassRef& render_pass_id, std::span<uint8_t> push_constants);
+
+    const TObjectRef<MaterialAsset>& get_base() const
+    {
+        return base;
+    }
+
+    const ankerl::unordered_dense::map<std::string, TObjectRef<SamplerAsset>>& get_samplers() const
+    {
+        return samplers;
+    }
+
+    const ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>& get_textures() const
+    {
+        return textures;
+    }
+
+    // Textures and samplers passed as bindless indices only update the push constants, the other parameters are written to the descriptors of the
+    // instance. The descriptors shared by the permutation are replaced by owned ones on next use.
     void set_sampler(const std::string& binding, const TObjectRef<SamplerAsset>& sampler);
     void set_texture(const std::string& binding, const TObjectRef<TextureAsset>& texture);
     void set_buffer(const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer);
     void set_buffer(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const std::weak_ptr<Gfx::Buffer>& buffer);
-    void set_scene_data(const Gfx::RenderPassRef& render_pass_id, const std::weak_ptr<Gfx::Buffer>& buffer);
+    // Bind memory of the current frame to the descriptors of the pass. It is not kept for the descriptors created later.
+    void set_buffer(const Gfx::RenderPassRef& render_pass_id, const std::string& binding, const Gfx::TransientBuffer& buffer);
+    void set_scene_data(const Gfx::RenderPassRef& render_pass_id, const Gfx::TransientBuffer& buffer);
 
-    // Compile shader for given pass if available (avoid lag spike later)
+    // Start compiling the shader for the given passes in the background (avoid lag spike later)
     void prepare_for_passes(const Gfx::RenderPassGenericId& render_pass_id);
 
     glm::vec3 asset_color() const override
@@ -48,15 +82,36 @@ public:
     }
 
 private:
-    TObjectRef<MaterialAsset>                                                             base;
-    std::shared_mutex                                                                     descriptor_lock;
-    ankerl::unordered_dense::map<Gfx::RenderPassRef, std::shared_ptr<Gfx::DescriptorSet>> descriptors;
+    struct BindlessParameter
+    {
+        uint32_t offset; // In the push constants
+        uint32_t index;
+    };
+
+    using BufferBindings = ankerl::unordered_dense::map<std::string, std::weak_ptr<Gfx::Buffer>>;
+
+    struct PassResources
+    {
+        std::shared_ptr<Gfx::DescriptorSet> descriptors;
+        bool                                b_shared_descriptors = false; // Owned by the permutation : they cannot be written
+        std::vector<BindlessParameter>      bindless_parameters;
+    };
+
+    std::shared_ptr<MaterialPermutation> resolve_permutation();
+
+    // Update the bindless index or the descriptor of a texture or a sampler in every pass, creating the descriptors again where they are shared
+    void set_pass_parameter(const std::string& binding, uint32_t bindless_index, const std::function<void(Gfx::DescriptorSet&)>& bind);
+
+    TObjectRef<MaterialAsset>                                        base;
+    std::shared_mutex                                                descriptor_lock;
+    ankerl::unordered_dense::map<Gfx::RenderPassRef, PassResources>  pass_resources;
+    ankerl::unordered_dense::map<Gfx::RenderPassRef, BufferBindings> pass_buffers; // Bound to the descriptors of a single pass
 
     Gfx::PermutationDescription        permutation_description;
     std::weak_ptr<MaterialPermutation> permutation;
 
-    ankerl::unordered_dense::map<std::string, TObjectRef<SamplerAsset>>   samplers;
-    ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>   textures;
-    ankerl::unordered_dense::map<std::string, std::weak_ptr<Gfx::Buffer>> buffers;
+    ankerl::unordered_dense::map<std::string, TObjectRef<SamplerAsset>> samplers;
+    ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>> textures;
+    BufferBindings                                                      buffers; // Bound to the descriptors of every pass
 };
 } // namespace Eng
\ No newline at end of file
@@ -29,6 +29,18 @@ class Mesh;
 class BufferData;
 } // namespace Gfx
 
+/**
+ * Index range of one level of detail inside a section's mesh.
+ * Error is the max object space distance between this lod and the full detail geometry, it is used to select the lod from its projected size.
+ */
+struct MeshLod
+{
+    uint32_t first_index   = 0;
+    uint32_t index_count   = 0;
+    uint32_t vertex_offset = 0;
+    float    error         = 0;
+};
+
 class MeshAsset : public AssetBase
 {
     REFLECT_BODY()
@@ -36,9 +48,10 @@ class MeshAsset : public AssetBase
 public:
     struct Section
     {
-        Bounds                            bounds;
-        std::shared_ptr<Gfx::Mesh>        mesh;
-        TObjectRef<MaterialInstanceAsset> material;
+        Bounds                                      bounds;
+        std::shared_ptr<Gfx::Mesh>                  mesh;
+        TObjectRef<MaterialInstanceAsset>           material;
+        std::shared_ptr<const std::vector<MeshLod>> lods; // Sorted from the most to the least detailed. Null if the whole mesh is always drawn.
     };
 
     struct Vertex
@@ -55,7 +68,8 @@ public:
     {
     }
 
-    void add_section(const std::string& section_name, const std::vector<Vertex>& vertices, const Gfx::BufferData& indices, const TObjectRef<MaterialInstanceAsset>& material, const Bounds& in_bounds = {});
+    void add_section(const std::string& section_name, const std::vector<Vertex>& vertices, const Gfx::BufferData& indices, const TObjectRef<MaterialInstanceAsset>& material, const Bounds& in_bounds = {},
+                     const std::vector<MeshLod>& lods = {});
 
     const std::vector<Section>& get_sections() const
     {
@@ -7,6 +7,7 @@ namespace Eng
 {
 namespace Gfx
 {
+class BindlessSlot;
 class Sampler;
 }
 
@@ -16,11 +17,16 @@ class SamplerAsset : public AssetBase
     friend AssetRegistry;
 
   public:
+    ~SamplerAsset() override;
+
     const std::shared_ptr<Gfx::Sampler>& get_resource()
     {
         return sampler;
     }
 
+    // Index of the sampler in the bindless table (see Gfx::BindlessTable)
+    uint32_t get_bindless_index() const;
+
     glm::vec3 asset_color() const override
     {
         return {1, 0.5, 0.7};
@@ -28,7 +34,8 @@ class SamplerAsset : public AssetBase
   private:
     SamplerAsset();
 
-    std::shared_ptr<Gfx::Sampler> sampler;
+    std::shared_ptr<Gfx::Sampler>      sampler;
+    std::shared_ptr<Gfx::BindlessSlot> bindless_slot;
 };
 
 } // namespace Eng
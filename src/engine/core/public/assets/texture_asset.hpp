@@ -13,6 +13,7 @@ namespace Eng
 {
 namespace Gfx
 {
+class BindlessSlot;
 class BufferData;
 class ImageView;
 class Image;
@@ -38,8 +39,13 @@ public:
         return view;
     }
 
+    ~TextureAsset() override;
+
     const Gfx::ColorFormat& get_format() const;
 
+    // Index of the texture in the bindless table (see Gfx::BindlessTable)
+    uint32_t get_bindless_index() const;
+
     static TObjectRef<TextureAsset> get_default_asset();
 
     std::shared_ptr<Gfx::ImageView> get_thumbnail() override
@@ -56,8 +62,9 @@ private:
     friend class AssetRegistry;
     TextureAsset(const std::vector<Gfx::BufferData>& mips, const CreateInfos& create_infos);
 
-    std::shared_ptr<Gfx::Image>     image;
-    std::shared_ptr<Gfx::ImageView> view;
+    std::shared_ptr<Gfx::Image>        image;
+    std::shared_ptr<Gfx::ImageView>    view;
+    std::shared_ptr<Gfx::BindlessSlot> bindless_slot;
 
     uint32_t    width    = 0;
     uint32_t    height   = 0;
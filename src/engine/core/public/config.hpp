@@ -19,6 +19,9 @@ public:
     uint32_t worker_threads = 0;
 
     bool auto_update_materials = false;
+
+    // Frames whose render scene may still be read while the game tick extracts the next one (see Scene::extract_render_scene())
+    uint32_t render_pipeline_depth = 1;
 private:
     std::filesystem::path config_path;
 };
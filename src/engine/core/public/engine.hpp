@@ -60,6 +60,11 @@ public:
 
     static Engine& get();
 
+    const Config& get_config() const
+    {
+        return app_config;
+    }
+
     double delta_second;
 
     AssetRegistry& asset_registry() const;
@@ -29,7 +29,7 @@ public:
 
 private:
 public:
-    void set_position(glm::vec3 in_position) override;
+    void set_position(glm::dvec3 in_position) override;
     void set_rotation(glm::quat in_rotation) override;
 
     void build_outliner(Gfx::ImGuiWrapper& ctx) override;
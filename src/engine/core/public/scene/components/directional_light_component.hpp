@@ -10,6 +10,31 @@ class DirectionalLightComponent : public LightComponent
     REFLECT_BODY()
 
     DirectionalLightComponent();
+
+    // Fit the shadow cascades to the active camera once it was moved by the tick phase
+    void post_tick(double delta_second) override;
+
+    /**
+     * Blend between uniform (0) and logarithmic (1) cascade splits
+     */
+    void set_cascade_split_lambda(float in_lambda)
+    {
+        cascade_split_lambda = in_lambda;
+    }
+
+    /**
+     * Camera distance covered by the shadow cascades
+     */
+    void set_shadow_distance(float in_distance)
+    {
+        shadow_distance = in_distance;
+    }
+
+    void build_outliner(Gfx::ImGuiWrapper& ctx) override;
+
+private:
+    float cascade_split_lambda = 0.8f;
+    float shadow_distance      = 10000.f;
+    float caster_distance      = 5000.f; // Extra depth toward the light, so casters outside of the cascade slice still cast shadows
 };
 }
-
@@ -2,6 +2,8 @@
 #include "macros.hpp"
 #include "scene_component.hpp"
 
+#include <cfloat>
+#include <vector>
 #include <glm/vec3.hpp>
 
 #include "scene/components/light_component.gen.hpp"
@@ -26,19 +28,36 @@ class LightComponent : public SceneComponent
     LightComponent();
 
 
+    static constexpr uint32_t max_cascades = 4;
+
     void enable_shadow(ELightType light_type = ELightType::Stationary, bool enabled = true);
 
-    const std::shared_ptr<Gfx::RenderPassInstanceBase>& get_shadow_pass() const
+    /**
+     * One shadow map rendered from its own view. Lights without cascades only have one, covering orthographic_width.
+     */
+    struct ShadowCascade
+    {
+        std::shared_ptr<SceneView>                   view;
+        std::shared_ptr<Gfx::RenderPassInstanceBase> pass;
+        float                                        far_distance = FLT_MAX; // Camera distance where the next cascade starts
+    };
+
+    const std::vector<ShadowCascade>& get_shadow_cascades() const
     {
-        return shadow_update_pass;
+        return shadow_cascades;
     }
 
-    const std::shared_ptr<SceneView>& get_shadow_view() const
+    /**
+     * Number of shadow maps covering the camera depth range (up to max_cascades). The shadow passes are recreated if shadows are already enabled.
+     */
+    void set_cascade_count(uint32_t in_cascade_count);
+
+    void set_color(const glm::vec3& in_color)
     {
-        return shadow_view;
+        color = in_color;
     }
 
-    void set_position(glm::vec3 in_position) override;
+    void set_position(glm::dvec3 in_position) override;
     void set_rotation(glm::quat in_rotation) override;
 
     void build_outliner(Gfx::ImGuiWrapper& ctx) override;
@@ -49,15 +68,14 @@ protected:
 
     }
 
-    glm::vec3                                    color              = glm::vec3(1, 1, 1);
-    uint32_t                                     shadow_resolution  = 2048;
-    float                                        orthographic_width = 5000;
-    float                                        z_far              = 5000;
-    float                                        z_near             = -5000;
-    bool                                         shadows            = false;
-    ELightType                                   light_type         = ELightType::Stationary;
-    std::shared_ptr<Gfx::RenderPassInstanceBase> shadow_update_pass;
-    std::shared_ptr<SceneView>                   shadow_view;
-    uint32_t                                     shadow_map_id = 0;
+    glm::vec3                  color              = glm::vec3(1, 1, 1);
+    uint32_t                   shadow_resolution  = 2048;
+    float                      orthographic_width = 5000;
+    float                      z_far              = 5000;
+    float                      z_near             = -5000;
+    bool                       shadows            = false;
+    ELightType                 light_type         = ELightType::Stationary;
+    uint32_t                   cascade_count      = 1;
+    std::vector<ShadowCascade> shadow_cascades;
 };
 }
\ No newline at end of file
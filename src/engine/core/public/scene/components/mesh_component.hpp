@@ -5,8 +5,7 @@
 
 namespace Eng
 {
-class SceneView;
-class CameraComponent;
+class RenderScene;
 }
 
 namespace Eng
@@ -29,7 +28,14 @@ class MeshComponent : public SceneComponent
   public:
     MeshComponent(const TObjectRef<MeshAsset>& in_mesh = {}) : mesh(in_mesh){};
 
-    void draw(Gfx::CommandBuffer& command_buffer, const SceneView& view);
+    /**
+     * Push one render proxy per mesh section to the given render scene
+     */
+    void extract(RenderScene& render_scene);
+
+    TObjectRef<AssetBase> get_serialized_asset() const override;
+    void                  set_serialized_asset(const TObjectRef<AssetBase>& asset) override;
+    std::optional<double> get_bounding_radius() override;
 
     TObjectRef<MeshAsset> mesh;
 };
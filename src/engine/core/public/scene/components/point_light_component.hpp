@@ -0,0 +1,39 @@
+#pragma once
+#include "light_component.hpp"
+#include "scene/components/point_light_component.gen.hpp"
+
+namespace Eng
+{
+class RenderScene;
+
+class PointLightComponent : public LightComponent
+{
+    REFLECT_BODY()
+
+    PointLightComponent();
+
+    /**
+     * Push this light to the given render scene, so it can be binned in the light clusters of the views
+     */
+    virtual void extract(RenderScene& render_scene);
+
+    /**
+     * Distance where the light contribution fades to zero
+     */
+    void set_range(float in_range)
+    {
+        range = in_range;
+    }
+
+    void set_intensity(float in_intensity)
+    {
+        intensity = in_intensity;
+    }
+
+    void build_outliner(Gfx::ImGuiWrapper& ctx) override;
+
+protected:
+    float range     = 1000.f;
+    float intensity = 100000.f;
+};
+}
@@ -1,9 +1,13 @@
 #pragma once
 #include "logger.hpp"
+#include "assets/asset_base.hpp"
 #include "macros.hpp"
 #include "object_ptr.hpp"
 #include "scene/scene.hpp"
+#include <optional>
 #include <glm/gtc/quaternion.hpp>
+#include <glm/ext/matrix_double4x4.hpp>
+#include <glm/ext/vector_double3.hpp>
 
 #include "scene/components/scene_component.gen.hpp"
 
@@ -21,12 +25,21 @@ class SceneComponent
     REFLECT_BODY();
 
     friend class Scene;
+    friend class Reflection::Class; // Default construct the components loaded from files
     SceneComponent(SceneComponent&)  = delete;
     SceneComponent(SceneComponent&&) = delete;
 
-    void internal_tick(double delta_second);
+    // Remove the destroyed children of this hierarchy
+    void prune_dead_nodes();
 
 public:
+    /**
+     * Flag for class_flags : the tick phases of this class only touch the component's own state, so its instances are ticked concurrently on the job
+     * system workers. They must not add or destroy components nor access other components (get_world_transform() updates the parents).
+     */
+    static constexpr uint32_t ParallelTick = 1 << 0;
+    static constexpr uint32_t class_flags  = 0;
+
     virtual ~SceneComponent()
     {
         assert(name);
@@ -34,10 +47,20 @@ public:
         name = nullptr;
     }
 
+    // Called on every component before the first tick() of the frame
+    virtual void pre_tick(double)
+    {
+    }
+
     virtual void tick(double)
     {
     }
 
+    // Called on every component after the last tick() of the frame
+    virtual void post_tick(double)
+    {
+    }
+
 
     template <typename T, typename... Args> TObjectRef<T> add_component(const std::string& name, Args&&... args)
     {
@@ -60,10 +83,11 @@ public:
         obj_ptr->parent   = this_ref_tmp;
         obj_ptr->this_ref = obj_ptr;
         this_ref_tmp->children.emplace_back(obj_ptr);
+        this_ref_tmp->scene->new_components.emplace_back(obj_ptr);
         return obj_ptr;
     }
 
-    virtual void set_position(glm::vec3 in_position)
+    virtual void set_position(glm::dvec3 in_position)
     {
         position = std::move(in_position);
         mark_transform_dirty();
@@ -81,7 +105,7 @@ public:
         mark_transform_dirty();
     }
 
-    const glm::vec3& get_relative_position() const
+    const glm::dvec3& get_relative_position() const
     {
         return position;
     }
@@ -96,18 +120,27 @@ public:
         return scale;
     }
 
-    const glm::mat4& get_world_transform()
+    /**
+     * World transforms are stored in double precision so components stay stable far from the origin. Render code should rebase them around the
+     * camera (see RenderScene::to_render_space()) before converting them to float.
+     */
+    const glm::dmat4& get_world_transform()
     {
         if (b_transform_dirty)
         {
             b_transform_dirty = false;
-            world_transform = translate(mat4_cast(rotation) * glm::scale({1}, scale), position);
+            world_transform   = translate(glm::dmat4(mat4_cast(rotation) * glm::scale(glm::mat4{1}, scale)), position);
             if (parent)
                 world_transform = parent->get_world_transform() * world_transform;
         }
         return world_transform;
     }
 
+    glm::dvec3 get_world_position()
+    {
+        return glm::dvec3(get_world_transform()[3]);
+    }
+
     const std::vector<TObjectPtr<SceneComponent>>& get_nodes() const
     {
         return children;
@@ -125,6 +158,22 @@ public:
 
     virtual void build_outliner(Gfx::ImGuiWrapper& ctx);
 
+    // Asset this component depends on. Serialized scenes store it by content hash (see SceneSerializer)
+    virtual TObjectRef<AssetBase> get_serialized_asset() const
+    {
+        return {};
+    }
+
+    virtual void set_serialized_asset(const TObjectRef<AssetBase>&)
+    {
+    }
+
+    // Radius of the bounding sphere around the world position, placing the component in the scene partition. Components without bounds are not tracked.
+    virtual std::optional<double> get_bounding_radius()
+    {
+        return {};
+    }
+
     TObjectRef<SceneComponent> as_ref() const
     {
         return this_ref;
@@ -150,11 +199,11 @@ private:
     std::vector<TObjectPtr<SceneComponent>> children{};
 
 
-    bool      b_transform_dirty = true;
-    glm::mat4 world_transform{1};
+    bool       b_transform_dirty = true;
+    glm::dmat4 world_transform{1};
 
-    glm::vec3 position{0};
-    glm::quat rotation = glm::identity<glm::quat>();
-    glm::vec3 scale{1};
+    glm::dvec3 position{0};
+    glm::quat  rotation = glm::identity<glm::quat>();
+    glm::vec3  scale{1};
 };
 } // namespace Eng
@@ -0,0 +1,37 @@
+#pragma once
+#include "point_light_component.hpp"
+
+#include <algorithm>
+
+#include "scene/components/spot_light_component.gen.hpp"
+
+namespace Eng
+{
+
+/**
+ * Point light restricted to a cone along the component's forward axis
+ */
+class SpotLightComponent : public PointLightComponent
+{
+    REFLECT_BODY()
+
+    SpotLightComponent();
+
+    void extract(RenderScene& render_scene) override;
+
+    /**
+     * Half angles in degrees : the light is attenuated between the inner and the outer cone
+     */
+    void set_cone_angles(float in_inner_angle, float in_outer_angle)
+    {
+        outer_angle = in_outer_angle;
+        inner_angle = std::min(in_inner_angle, in_outer_angle);
+    }
+
+    void build_outliner(Gfx::ImGuiWrapper& ctx) override;
+
+private:
+    float inner_angle = 30.f;
+    float outer_angle = 45.f;
+};
+}
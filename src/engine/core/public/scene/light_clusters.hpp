@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <glm/vec3.hpp>
+
+#include "gfx/vulkan/transient_allocator.hpp"
+
+namespace Eng
+{
+class RenderScene;
+class SceneView;
+
+/**
+ * Assigns the point and spot lights of a render scene to the clusters (froxels) of a view, so the lighting passes only evaluate the lights
+ * touching the shaded pixel.
+ * The view frustum is split in grid_x * grid_y screen tiles and grid_z depth slices growing exponentially from the near plane. Each cluster
+ * references a range of the light index list, whose entries point into the light buffer.
+ */
+class LightClusters
+{
+public:
+    // Must match the CLUSTER_GRID_* defines of the shaders
+    static constexpr uint32_t grid_x                 = 16;
+    static constexpr uint32_t grid_y                 = 9;
+    static constexpr uint32_t grid_z                 = 24;
+    static constexpr uint32_t cluster_count          = grid_x * grid_y * grid_z;
+    static constexpr uint32_t max_lights_per_cluster = 256;
+
+    // Layout of one light in the light buffer (std430)
+    struct GpuLight
+    {
+        glm::vec3 position;
+        float     range;
+        glm::vec3 color;
+        float     spot_offset;
+        glm::vec3 direction;
+        float     spot_scale; // Spot attenuation is saturate(dot(direction, -L) * spot_scale + spot_offset)
+    };
+
+    // Range of the light index list used by one cluster
+    struct ClusterRange
+    {
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    static std::shared_ptr<LightClusters> create()
+    {
+        return std::shared_ptr<LightClusters>(new LightClusters());
+    }
+
+    /**
+     * Bin the lights of the render scene into the clusters of the view, then write the light, cluster and index buffers for the current frame.
+     * The view matrices must be up to date (call it after SceneView::pre_draw())
+     */
+    void update(const RenderScene& render_scene, const SceneView& view);
+
+    const Gfx::TransientBuffer& get_light_buffer() const
+    {
+        return light_buffer;
+    }
+
+    const Gfx::TransientBuffer& get_cluster_buffer() const
+    {
+        return cluster_buffer;
+    }
+
+    const Gfx::TransientBuffer& get_index_buffer() const
+    {
+        return index_buffer;
+    }
+
+    // The depth slice of a view space depth is floor(log(depth / z_near) * z_scale)
+    float get_z_near() const
+    {
+        return z_near;
+    }
+
+    float get_z_scale() const
+    {
+        return z_scale;
+    }
+
+private:
+    LightClusters();
+
+    // Inclusive cluster coordinates covered by one light
+    struct LightExtent
+    {
+        glm::uvec3 min;
+        glm::uvec3 max;
+        bool       visible;
+    };
+
+    float z_near  = 1;
+    float z_scale = 1;
+
+    std::vector<GpuLight>              lights;
+    std::vector<LightExtent>           light_extents;
+    std::vector<std::vector<uint32_t>> cluster_lights;
+    std::vector<ClusterRange>          cluster_ranges;
+    std::vector<uint32_t>              light_indices;
+
+    Gfx::TransientBuffer light_buffer;
+    Gfx::TransientBuffer cluster_buffer;
+    Gfx::TransientBuffer index_buffer;
+};
+} // namespace Eng
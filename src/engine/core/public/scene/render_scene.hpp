@@ -0,0 +1,115 @@
+#pragma once
+#include "bounds.hpp"
+#include "object_ptr.hpp"
+
+#include <memory>
+#include <vector>
+#include <glm/ext/matrix_float4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/ext/matrix_double4x4.hpp>
+#include <glm/ext/vector_double3.hpp>
+
+namespace Eng
+{
+namespace Gfx
+{
+class Mesh;
+}
+
+class MaterialInstanceAsset;
+struct MeshLod;
+
+/**
+ * Render relevant state of a single mesh section, copied from the scene during the extract phase.
+ */
+struct RenderProxy
+{
+    glm::mat4                                   transform;
+    Bounds                                      bounds;
+    std::shared_ptr<Gfx::Mesh>                  mesh;
+    TObjectRef<MaterialInstanceAsset>           material;
+    std::shared_ptr<const std::vector<MeshLod>> lods;
+};
+
+/**
+ * Point or spot light copied from the scene during the extract phase. Point lights use a cone covering the whole sphere.
+ */
+struct RenderLight
+{
+    glm::vec3 position;
+    float     range;
+    glm::vec3 color; // Premultiplied by the intensity
+    glm::vec3 direction;
+    float     cos_inner_angle = -1;
+    float     cos_outer_angle = -1;
+};
+
+/**
+ * Read-only snapshot of a scene for one frame.
+ * It is written by Scene::extract_render_scene() on the game thread, then only read by the render passes, so the game tick of the next frame can
+ * safely run while this one is being recorded.
+ * Everything it contains is expressed in float relative to a double precision origin (the active camera position), so objects near the camera
+ * keep their precision wherever they are in the world.
+ */
+class RenderScene
+{
+public:
+    void reset(uint64_t in_frame, const glm::dvec3& in_origin)
+    {
+        frame  = in_frame;
+        origin = in_origin;
+        proxies.clear();
+        lights.clear();
+    }
+
+    void add_proxy(const glm::mat4& transform, const Bounds& bounds, const std::shared_ptr<Gfx::Mesh>& mesh, const TObjectRef<MaterialInstanceAsset>& material,
+                   const std::shared_ptr<const std::vector<MeshLod>>& lods = nullptr)
+    {
+        proxies.emplace_back(transform, bounds, mesh, material, lods);
+    }
+
+    const std::vector<RenderProxy>& get_proxies() const
+    {
+        return proxies;
+    }
+
+    void add_light(const RenderLight& light)
+    {
+        lights.emplace_back(light);
+    }
+
+    const std::vector<RenderLight>& get_lights() const
+    {
+        return lights;
+    }
+
+    uint64_t get_frame() const
+    {
+        return frame;
+    }
+
+    const glm::dvec3& get_origin() const
+    {
+        return origin;
+    }
+
+    // Convert a world transform to the render space of this scene
+    glm::mat4 to_render_space(const glm::dmat4& world_transform) const
+    {
+        glm::dmat4 relative = world_transform;
+        relative[3] -= glm::dvec4(origin, 0);
+        return glm::mat4(relative);
+    }
+
+    glm::vec3 to_render_space(const glm::dvec3& world_position) const
+    {
+        return glm::vec3(world_position - origin);
+    }
+
+private:
+    uint64_t                 frame  = 0;
+    glm::dvec3               origin = {0, 0, 0};
+    std::vector<RenderProxy> proxies;
+    std::vector<RenderLight> lights;
+};
+} // namespace Eng
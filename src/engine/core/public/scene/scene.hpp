@@ -3,6 +3,8 @@
 #include "macros.hpp"
 #include "object_allocator.hpp"
 #include "object_ptr.hpp"
+#include "scene/scene_partition.hpp"
+#include "scene/scene_visibility.hpp"
 
 #include <vector>
 #include <glm/ext/matrix_float4x4.hpp>
@@ -26,6 +28,7 @@ class Buffer;
 namespace Eng
 {
 class CameraComponent;
+class RenderScene;
 }
 
 class ContiguousObjectAllocator;
@@ -45,7 +48,8 @@ class Scene final
     friend class SceneComponent;
 
 public:
-    Scene();
+    // Keeps render_pipeline_depth + 1 render scenes (see extract_render_scene())
+    explicit Scene(uint32_t render_pipeline_depth = 1);
     Scene(Scene&& other) = default;
 
     ~Scene()
@@ -69,11 +73,56 @@ public:
         TObjectPtr<T> obj_ptr(alloc);
         obj_ptr->this_ref = obj_ptr;
         root_nodes.emplace_back(obj_ptr);
+        new_components.emplace_back(obj_ptr);
         return obj_ptr;
     }
 
+    /**
+     * Create a component from its reflected class, as a root node or as a child of parent. The class must be default constructible (see
+     * Reflection::Class::can_construct())
+     */
+    TObjectRef<SceneComponent> add_component_of_class(const Reflection::Class* component_class, const std::string& name, const TObjectRef<SceneComponent>& parent = {});
+
+    /**
+     * Grow the storage of the given component class once before adding many components of it
+     */
+    void reserve_components(const Reflection::Class* component_class, size_t additional_count) const;
+
+    /**
+     * Run the pre_tick, tick and post_tick phases. Each phase completes on every component before the next one starts.
+     */
     void tick(double delta_second);
 
+    /**
+     * Copy the render relevant state of the scene into the oldest render scene of the ring, then publish it.
+     * Blocks until the views of the frames in flight released it (see get_render_scene() and Config::render_pipeline_depth)
+     */
+    void extract_render_scene();
+
+    /**
+     * Get the last extracted render scene. The returned snapshot will not be modified as long as it is referenced, releasing the last reference
+     * lets the next extract reuse it.
+     */
+    std::shared_ptr<const RenderScene> get_render_scene() const;
+
+    /**
+     * Culling results shared by every view rendering this scene
+     */
+    SceneVisibility& get_visibility() const
+    {
+        return *visibility;
+    }
+
+    /**
+     * Spatial partition of the components with bounds (see SceneComponent::get_bounding_radius()). Components created or merged into the scene
+     * are tracked on the next tick, once their caller has finished setting them up. It is updated after the tick phases, and its cells are
+     * activated around the active camera.
+     */
+    ScenePartition& get_partition() const
+    {
+        return *partition;
+    }
+
     template <typename T> void for_each(const std::function<void(T&)>& callback) const
     {
         allocator->for_each(callback);
@@ -113,6 +162,22 @@ public:
     void remove_custom_pass(const std::shared_ptr<Gfx::RenderPassInstanceBase>& pass) const;
 
 private:
+    enum class ETickPhase
+    {
+        PreTick,
+        Tick,
+        PostTick
+    };
+
+    // Tick the regular components on this thread, then spread the SceneComponent::ParallelTick ones across the workers
+    void tick_phase(ETickPhase phase, double delta_second) const;
+
+    // Remove the destroyed nodes from the whole hierarchy in one pass. Skipped if no component was freed since the last one.
+    void prune_dead_nodes();
+
+    // Track the components created since the last tick that have bounds in the partition
+    void track_new_components();
+
     std::weak_ptr<Gfx::CustomPassList> custom_passes;
 
     TObjectRef<CameraComponent> active_camera;
@@ -122,7 +187,16 @@ private:
     std::unique_ptr<std::mutex> merge_queue_mtx;
     std::vector<Scene>          scenes_to_merge;
 
+    // Shared with the acquired snapshots, which may outlive the scene
+    struct RenderSceneSlots;
+    std::shared_ptr<RenderSceneSlots> render_scene_slots;
+    uint64_t                          extracted_frames = 0;
+    std::unique_ptr<SceneVisibility>  visibility;
+
     std::vector<TObjectPtr<SceneComponent>>    root_nodes;
     std::unique_ptr<ContiguousObjectAllocator> allocator;
+    size_t                                     pruned_free_count = 0;
+    std::vector<TObjectRef<SceneComponent>>    new_components; // Not tracked by the partition yet
+    std::unique_ptr<ScenePartition>            partition;      // After the allocator : it references components
 };
 } // namespace Eng
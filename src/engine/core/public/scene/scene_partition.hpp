@@ -0,0 +1,152 @@
+#pragma once
+#include "object_ptr.hpp"
+
+#include <ankerl/unordered_dense.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/ext/vector_double3.hpp>
+
+namespace Eng
+{
+class Frustum;
+class SceneComponent;
+
+/**
+ * Cell of the scene partition : a cube of cell_size * 2^level units starting at coordinates * size.
+ */
+struct CellKey
+{
+    int64_t  x     = 0;
+    int64_t  y     = 0;
+    int64_t  z     = 0;
+    uint32_t level = 0;
+
+    bool operator==(const CellKey& other) const = default;
+};
+
+struct CellKeyHash
+{
+    using is_avalanching = void;
+
+    uint64_t operator()(const CellKey& key) const noexcept
+    {
+        const uint64_t values[4] = {static_cast<uint64_t>(key.x), static_cast<uint64_t>(key.y), static_cast<uint64_t>(key.z), key.level};
+        return ankerl::unordered_dense::detail::wyhash::hash(values, sizeof(values));
+    }
+};
+
+/**
+ * Sparse loose octree splitting the scene in cells that can be streamed, activated and deactivated independently.
+ * Only the cells containing components (and their ancestors) exist. A component is stored in the smallest level whose cells are at least twice as
+ * large as its bounding sphere, in the cell containing its center. Cells are loose : their bounds are extended by half their size on every side, so
+ * a component never overlaps more than one cell of its level.
+ * Coordinates are in double precision, so the partition covers worlds much larger than what a float can address.
+ */
+class ScenePartition
+{
+public:
+    using ComponentCallback = std::function<void(const TObjectRef<SceneComponent>&)>;
+    using CellCallback      = std::function<void(const CellKey&, const std::vector<TObjectRef<SceneComponent>>&)>;
+
+    ScenePartition(double in_cell_size = 1000.0, uint32_t in_level_count = 32);
+
+    /**
+     * Track the component in the partition. Radius is the radius of its bounding sphere around its world position
+     */
+    void track(const TObjectRef<SceneComponent>& component, double radius);
+    void untrack(const TObjectRef<SceneComponent>& component);
+
+    /**
+     * Move the tracked components that left their cell, and forget the destroyed ones
+     */
+    void update();
+
+    /**
+     * Activate the cells closer than the activation distance to the given position. Active cells are only deactivated once they are further than
+     * activation_distance * (1 + hysteresis), so cells don't flicker when the camera moves around a boundary.
+     */
+    void update_activation(const glm::dvec3& position);
+
+    void set_activation_distance(double in_distance, double in_hysteresis = 0.25)
+    {
+        activation_distance = in_distance;
+        hysteresis          = in_hysteresis;
+    }
+
+    /**
+     * Called when a cell becomes active (or inactive) with the components it contains, and when a component enters (or leaves) an active cell with
+     * this component only. A component leaving because it was destroyed is already invalid.
+     */
+    void set_activation_callbacks(CellCallback in_on_activate, CellCallback in_on_deactivate)
+    {
+        on_activate   = std::move(in_on_activate);
+        on_deactivate = std::move(in_on_deactivate);
+    }
+
+    bool is_active(const CellKey& key) const
+    {
+        return active_cells.contains(key);
+    }
+
+    /**
+     * Cell containing the given component, or false if it is not tracked
+     */
+    bool find_cell(const TObjectRef<SceneComponent>& component, CellKey& out_key) const;
+
+    /**
+     * Call the callback for every component whose bounding sphere may intersect the sphere (broad phase : the test is done on the cells)
+     */
+    void query_radius(const glm::dvec3& center, double radius, const ComponentCallback& callback) const;
+
+    /**
+     * Call the callback for every component whose cell intersects the frustum. The frustum is expressed in a space relative to origin (see
+     * RenderScene::get_origin()).
+     */
+    void query_frustum(const Frustum& frustum, const glm::dvec3& origin, const ComponentCallback& callback) const;
+
+    /**
+     * Move the components tracked by another partition to this one (see Scene::merge())
+     */
+    void merge_with(ScenePartition& other);
+
+    double get_cell_size(uint32_t level) const;
+
+private:
+    struct Cell
+    {
+        std::vector<TObjectRef<SceneComponent>> components;
+        uint32_t                                subtree_components = 0; // Components of this cell and all its children
+        uint8_t                                 child_mask         = 0;
+    };
+
+    struct TrackedComponent
+    {
+        CellKey    cell;
+        glm::dvec3 position;
+        double     radius;
+    };
+
+    CellKey make_key(const glm::dvec3& position, double radius) const;
+    void    insert(const TObjectRef<SceneComponent>& component, const CellKey& key);
+    void    remove(const TObjectRef<SceneComponent>& component, const CellKey& key);
+
+    // Loose bounds of a cell
+    void cell_bounds(const CellKey& key, glm::dvec3& out_min, glm::dvec3& out_max) const;
+
+    // Visit the cells top-down, skipping the subtrees rejected by the filter
+    void traverse(const std::function<bool(const CellKey&, const Cell&)>& visitor) const;
+
+    double   cell_size;
+    uint32_t level_count;
+    double   activation_distance = 10000.0;
+    double   hysteresis          = 0.25;
+
+    ankerl::unordered_dense::map<CellKey, Cell, CellKeyHash>                   cells;
+    ankerl::unordered_dense::set<CellKey, CellKeyHash>                         roots;
+    ankerl::unordered_dense::set<CellKey, CellKeyHash>                         active_cells;
+    ankerl::unordered_dense::map<TObjectRef<SceneComponent>, TrackedComponent> tracked;
+    CellCallback                                                               on_activate;
+    CellCallback                                                               on_deactivate;
+};
+} // namespace Eng
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "assets/mesh_asset.hpp"
+#include "assets/texture_asset.hpp"
+
+#include <filesystem>
+#include <ankerl/unordered_dense.h>
+
+namespace Eng
+{
+class AssetRegistry;
+class Scene;
+
+/**
+ * CPU data of the imported textures and meshes, keyed by content hash. The assets only keep their GPU resources : the importers record here what
+ * they upload so SceneSerializer::save() can store it in the scene file.
+ */
+class AssetPayloads
+{
+public:
+    struct Texture
+    {
+        TextureAsset::CreateInfos         infos;
+        std::vector<std::vector<uint8_t>> mips;
+    };
+
+    // One per section of the mesh asset, in the same order
+    struct MeshSection
+    {
+        std::string                            name;
+        std::vector<MeshAsset::Vertex>         vertices;
+        std::shared_ptr<const Gfx::BufferData> indices;
+        std::vector<MeshLod>                   lods;
+    };
+
+    void add_texture(uint64_t hash, const std::vector<Gfx::BufferData>& mips, const TextureAsset::CreateInfos& infos);
+    void add_mesh(uint64_t hash, std::vector<MeshSection> sections);
+
+    const Texture*                  find_texture(uint64_t hash) const;
+    const std::vector<MeshSection>* find_mesh(uint64_t hash) const;
+
+private:
+    ankerl::unordered_dense::map<uint64_t, Texture>                  textures;
+    ankerl::unordered_dense::map<uint64_t, std::vector<MeshSection>> meshes;
+};
+
+/**
+ * Compact binary scene format : the component hierarchy with the reflected class, the name and the relative transform of each component, and the
+ * assets they use. Assets are referenced by content hash (see AssetBase::get_content_hash()) : the ones already in the registry are reused, the
+ * others are created from the data stored in the file, so loading a scene does not need the source files nor the importers.
+ *
+ * The file is a header, the class name table, the node records in depth first order (parents before children), the asset records with their data
+ * (dependencies before their users) and a string table. It is memory-mapped on load and the components are created in pools reserved once per class.
+ */
+class SceneSerializer
+{
+public:
+    // The textures and meshes missing from the payloads are only referenced by hash
+    static bool save(const Scene& scene, const std::filesystem::path& path, const AssetPayloads& payloads);
+
+    // Append the components stored in the file to the given scene, and create the assets that are not in the registry yet
+    static bool load(Scene& scene, const std::filesystem::path& path, AssetRegistry& registry);
+};
+} // namespace Eng
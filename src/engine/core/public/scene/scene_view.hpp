@@ -1,9 +1,12 @@
 #pragma once
 #include "bounds.hpp"
+#include "gfx/vulkan/transient_allocator.hpp"
 
 #include <memory>
+#include <vector>
 #include <glm/ext/matrix_float4x4.hpp>
 #include <glm/ext/quaternion_float.hpp>
+#include <glm/ext/vector_double3.hpp>
 
 namespace Eng
 {
@@ -12,9 +15,13 @@ namespace Gfx
 class Buffer;
 class RenderPassInstanceBase;
 class CommandBuffer;
+class Pipeline;
+class DescriptorSet;
 }
 
 class Scene;
+class RenderScene;
+struct RenderProxy;
 
 // Quickly grabbed from https://gist.github.com/podgorskiy/e698d18879588ada9014768e3e82a644
 class Frustum
@@ -123,7 +130,7 @@ public:
     }
 };
 
-class SceneView
+class SceneView : public std::enable_shared_from_this<SceneView>
 {
 public:
     static std::shared_ptr<SceneView> create()
@@ -131,9 +138,12 @@ public:
         return std::shared_ptr<SceneView>(new SceneView());
     }
 
-    void pre_draw(const Gfx::RenderPassInstanceBase& render_pass);
-    void pre_submit() const;
-    void draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const;
+    /**
+     * Acquire the last render scene extracted from the given scene. It is kept until pre_submit()
+     */
+    void pre_draw(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass);
+    void pre_submit();
+    void draw(const Gfx::RenderPassInstanceBase& render_pass, Gfx::CommandBuffer& command_buffer, size_t idx, size_t num_threads) const;
 
     const glm::uvec2& get_resolution() const
     {
@@ -141,9 +151,53 @@ public:
     }
 
     void set_rotation(const glm::quat& in_rotation);
-    void set_position(const glm::vec3& in_position);
+    void set_position(const glm::dvec3& in_position);
 
-    const std::shared_ptr<Gfx::Buffer>& get_view_buffer() const
+    const glm::quat& get_rotation() const
+    {
+        return rotation;
+    }
+
+    const glm::dvec3& get_position() const
+    {
+        return position;
+    }
+
+    // Origin of the last drawn render scene : the matrices of this view are relative to it
+    const glm::dvec3& get_origin() const
+    {
+        return origin;
+    }
+
+    // Position relative to get_origin(), in the space of the view matrices
+    const glm::vec3& get_render_position() const
+    {
+        return render_position;
+    }
+
+    // Vertical fov in degrees, or half width for orthographic views
+    float get_fov() const
+    {
+        return fov;
+    }
+
+    float get_z_near() const
+    {
+        return z_near;
+    }
+
+    float get_z_far() const
+    {
+        return z_far;
+    }
+
+    bool is_orthographic() const
+    {
+        return orthographic;
+    }
+
+    // Scene constants of the current frame
+    const Gfx::TransientBuffer& get_view_buffer() const
     {
         return view_buffer;
     }
@@ -188,11 +242,22 @@ public:
         z_near = in_z_near;
     }
 
+    /**
+     * Max error of the selected mesh lods, in pixels. Higher values switch to coarser lods closer to the camera.
+     */
+    void set_lod_error_threshold(float in_pixels)
+    {
+        lod_error_threshold = in_pixels;
+    }
+
     const glm::mat4& get_projection_view_matrix() const
     {
         return projection_view;
     }
 
+    // Projection view matrix the next pre_draw() will use for a render scene rebased on in_origin, if the render target resolution doesn't change
+    glm::mat4 predict_projection_view_matrix(const glm::dvec3& in_origin) const;
+
     const glm::mat4& get_projection_matrix() const
     {
         return projection;
@@ -208,10 +273,45 @@ public:
     {
     }
 
-    void update_matrices(const glm::uvec2& in_resolution, bool reversed_z);
+    struct DrawPacket
+    {
+        const RenderProxy*                  proxy;
+        std::shared_ptr<Gfx::Pipeline>      pipeline;
+        std::shared_ptr<Gfx::DescriptorSet> descriptors;
+        uint32_t                            lod;
+    };
+
+    struct SortedPacket
+    {
+        uint64_t key;
+        uint32_t packet;
+    };
+
+    struct DrawBatch
+    {
+        uint32_t first_packet; // Index in sorted_packets
+        uint32_t instance_offset;
+        uint32_t instance_count;
+        bool     instanced;
+    };
+
+    void      update_matrices(const glm::uvec2& in_resolution, bool in_reversed_z);
+    glm::mat4 compute_view_matrix(const glm::dvec3& in_origin) const;
+    glm::mat4 compute_projection_matrix(const glm::uvec2& in_resolution, bool in_reversed_z) const;
+
+    // Coarsest lod of the proxy whose projected error stays under lod_error_threshold
+    uint32_t select_lod(const RenderProxy& proxy) const;
+
+    // Cull the current render scene then sort the visible sections to minimize state changes while recording
+    void build_draw_packets(const Scene& scene, const Gfx::RenderPassInstanceBase& render_pass);
+
+    // Merge the sorted packets sharing the same mesh and material into instanced draws
+    void build_draw_batches(const Gfx::RenderPassInstanceBase& render_pass);
 
-    glm::quat rotation = glm::identity<glm::quat>();
-    glm::vec3 position = {0, 0, 0};
+    glm::quat  rotation        = glm::identity<glm::quat>();
+    glm::dvec3 position        = {0, 0, 0};
+    glm::dvec3 origin          = {0, 0, 0}; // Origin of the render scene the matrices are relative to
+    glm::vec3  render_position = {0, 0, 0};
 
     glm::mat4  view;
     glm::mat4  projection;
@@ -221,11 +321,20 @@ public:
     float      z_near   = 0.01f;
     float      z_far   = 1000.f;
     glm::uvec2 resolution;
-    bool       orthographic = false;
+    bool       reversed_z          = false;
+    bool       orthographic        = false;
+    float      lod_error_threshold = 1.f;
+    float      lod_pixel_scale     = 0; // Pixels covered by one world unit (at a distance of one unit for perspective views)
 
     Frustum frustum;
 
-    std::shared_ptr<Gfx::Buffer> view_buffer;
+    Gfx::TransientBuffer               view_buffer;
+    std::shared_ptr<const RenderScene> render_scene;
+    std::vector<DrawPacket>            draw_packets;
+    std::vector<SortedPacket>          sorted_packets;
+    std::vector<DrawBatch>             draw_batches;
+    std::vector<glm::mat4>             instance_transforms;
+    Gfx::TransientBuffer               instance_buffer;
 };
 
 
@@ -0,0 +1,50 @@
+#pragma once
+#include "scene/scene_view.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/ext/matrix_float4x4.hpp>
+
+namespace Eng
+{
+class RenderScene;
+
+/**
+ * Culls a render scene once for every view drawing it.
+ * The first view requesting a render scene triggers a single traversal testing each proxy against the frustum of all the registered views, and
+ * writing one bit per view in the proxy visibility mask. The other views of the frame then only read their bit.
+ */
+class SceneVisibility
+{
+public:
+    static constexpr size_t max_views = 64;
+
+    /**
+     * Get the visibility masks of the given render scene for this view (indexed like RenderScene::get_proxies()). The returned masks are never
+     * modified : culling another render scene writes new ones.
+     * Views are registered on their first request and culled by the shared pass from the next render scene. Returns null when the masks can't be
+     * used for this view (not registered yet, too many views, or the view moved since the shared pass) : the view should cull the scene itself.
+     */
+    std::shared_ptr<const std::vector<uint64_t>> get_masks(const RenderScene& render_scene, const SceneView& view, uint64_t& out_view_bit);
+
+private:
+    struct ViewSlot
+    {
+        std::weak_ptr<const SceneView> view;
+        const SceneView*               view_ptr = nullptr;
+        glm::mat4                      projection_view;
+        Frustum                        frustum;
+    };
+
+    void cull(const RenderScene& render_scene);
+
+    std::mutex                             mutex;
+    std::vector<ViewSlot>                  views;
+    std::shared_ptr<std::vector<uint64_t>> masks;
+    const RenderScene*                     culled_scene = nullptr;
+    uint64_t                               culled_frame = 0;
+    uint64_t                               culled_views = 0; // Views tested by the last shared pass
+};
+} // namespace Eng
@@ -1,11 +1,16 @@
 #include "gfx/mesh.hpp"
 
+#include "gfx/vulkan/buffer_arena.hpp"
+
 namespace Eng::Gfx
 {
 Mesh::Mesh(std::string in_name, const std::weak_ptr<Device>& in_device, size_t in_vertex_structure_size, EBufferType in_buffer_type, const BufferData* vertices, const BufferData* indices)
     : buffer_type(in_buffer_type), vertex_structure_size(in_vertex_structure_size), index_type(IndexBufferType::Uint32), device(in_device), name(std::move(in_name))
 {
-    if (indices)
+    // An empty index list draws nothing : don't upload the vertices either
+    if (indices && indices->get_element_count() == 0)
+        vertices = nullptr;
+    if (indices && indices->get_element_count() > 0)
     {
         switch (indices->get_stride())
         {
@@ -21,27 +26,44 @@ Mesh::Mesh(std::string in_name, const std::weak_ptr<Device>& in_device, size_t i
         default:
             LOG_FATAL("Unhandled index buffer size : {}", indices->get_stride())
         }
-        index_buffer = Buffer::create(name + "_buff_idx", device,
+        if (buffer_type == EBufferType::IMMUTABLE)
+            index_allocation = device.lock()->get_buffer_arena(EBufferUsage::INDEX_DATA, indices->get_stride()).allocate(name + "_idx", *indices);
+        else
+            index_buffer = Buffer::create(name + "_buff_idx", device,
                                       Buffer::CreateInfos{
                                           .usage = EBufferUsage::INDEX_DATA,
                                           .type  = buffer_type,
                                       },
                                       *indices);
     }
-    if (vertices)
+    if (vertices && vertices->get_element_count() > 0)
     {
         vertex_structure_size = vertices->get_stride();
-        vertex_buffer         = Buffer::create(name + "_buff_vtx", device,
-                                               Buffer::CreateInfos{
-                                                   .usage = EBufferUsage::VERTEX_DATA,
-                                                   .type  = buffer_type,
-                                       },
-                                               *vertices);
+        if (buffer_type == EBufferType::IMMUTABLE)
+            vertex_allocation = device.lock()->get_buffer_arena(EBufferUsage::VERTEX_DATA, vertex_structure_size).allocate(name + "_vtx", *vertices);
+        else
+            vertex_buffer = Buffer::create(name + "_buff_vtx", device,
+                                           Buffer::CreateInfos{
+                                               .usage = EBufferUsage::VERTEX_DATA,
+                                               .type  = buffer_type,
+                                           },
+                                           *vertices);
     }
 }
 
+Mesh::~Mesh()
+{
+    // The GPU may still draw the mesh : its ranges are released once the current frame completed
+    if (vertex_allocation)
+        device.lock()->drop_resource(vertex_allocation);
+    if (index_allocation)
+        device.lock()->drop_resource(index_allocation);
+}
+
 void Mesh::reserve_vertices(size_t vertex_count)
 {
+    if (buffer_type == EBufferType::IMMUTABLE)
+        LOG_FATAL("Cannot reserve vertices of immutable mesh {}", name)
     if (!vertex_buffer)
     {
         vertex_buffer = Buffer::create(name + "_buff_vtx", device,
@@ -59,6 +81,8 @@ void Mesh::reserve_vertices(size_t vertex_count)
 
 void Mesh::reserve_indices(size_t index_count, IndexBufferType in_index_buffer_type)
 {
+    if (buffer_type == EBufferType::IMMUTABLE)
+        LOG_FATAL("Cannot reserve indices of immutable mesh {}", name)
     index_type = in_index_buffer_type;
 
     size_t size = 0;
@@ -95,7 +119,7 @@ void Mesh::reserve_indices(size_t index_count, IndexBufferType in_index_buffer_t
 void Mesh::set_vertices(size_t start_vertex, const BufferData& vertex_data)
 {
     reserve_vertices(start_vertex + vertex_data.get_element_count());
-    vertex_buffer->set_data_and_wait(start_vertex, vertex_data);
+    vertex_buffer->set_data(start_vertex, vertex_data);
 }
 
 void Mesh::set_indexed_vertices(size_t start_vertex, const BufferData& vertex_data, size_t start_index, const BufferData& index_data)
@@ -119,6 +143,6 @@ void Mesh::set_indexed_vertices(size_t start_vertex, const BufferData& vertex_da
     }
 
     reserve_indices(start_index + index_data.get_element_count(), type);
-    index_buffer->set_data_and_wait(start_index, index_data);
+    index_buffer->set_data(start_index, index_data);
 }
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "gfx/renderer/instance/attachment_aliasing.hpp"
+
+#include "profiler.hpp"
+#include "gfx/renderer/instance/render_pass_instance_base.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/image.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+#include "gfx/vulkan/vk_wrap.hpp"
+
+#include <atomic>
+#include <cassert>
+#include <functional>
+#include <vk_mem_alloc.h>
+
+namespace Eng::Gfx
+{
+// Memory bound to several images. It is released with the last of them.
+class SharedImageMemory : public DeviceResource
+{
+public:
+    SharedImageMemory(std::string name, std::weak_ptr<Device> device, VmaAllocation in_allocation) : DeviceResource(std::move(name), std::move(device)), allocation(in_allocation)
+    {
+    }
+
+    ~SharedImageMemory() override
+    {
+        vmaFreeMemory(device().lock()->get_allocator().allocator, allocation);
+    }
+
+    VmaAllocation allocation;
+};
+
+static thread_local AttachmentAliasing* current_aliasing = nullptr;
+static std::atomic<uint32_t>            disable_count    = 0;
+
+std::unique_ptr<AttachmentAliasing> AttachmentAliasing::begin(std::weak_ptr<Device> device, const RenderPassInstanceBase& entry_pass)
+{
+    if (current_aliasing || disable_count > 0)
+        return nullptr;
+    auto aliasing    = std::unique_ptr<AttachmentAliasing>(new AttachmentAliasing(std::move(device), entry_pass));
+    current_aliasing = aliasing.get();
+    return aliasing;
+}
+
+AttachmentAliasing* AttachmentAliasing::current()
+{
+    return current_aliasing;
+}
+
+void AttachmentAliasing::disable()
+{
+    ++disable_count;
+}
+
+void AttachmentAliasing::enable()
+{
+    assert(disable_count > 0);
+    --disable_count;
+}
+
+AttachmentAliasing::AttachmentAliasing(std::weak_ptr<Device> in_device, const RenderPassInstanceBase& entry_pass) : device(std::move(in_device))
+{
+    // Index the graph in post-order : every pass after its dependencies
+    std::vector<std::vector<size_t>>                           dependencies;
+    const std::function<size_t(const RenderPassInstanceBase&)> visit = [&](const RenderPassInstanceBase& pass)
+    {
+        if (auto found = pass_indices.find(&pass); found != pass_indices.end())
+            return found->second;
+        std::vector<size_t> pass_dependencies;
+        pass.for_each_dependency(
+            [&](const std::shared_ptr<RenderPassInstanceBase>& dependency)
+            {
+                pass_dependencies.emplace_back(visit(*dependency));
+            });
+        const size_t index = dependencies.size();
+        pass_indices.emplace(&pass, index);
+        dependencies.emplace_back(std::move(pass_dependencies));
+        return index;
+    };
+    entry_index = visit(entry_pass);
+
+    readers.resize(dependencies.size());
+    ancestors.resize(dependencies.size(), std::vector<bool>(dependencies.size(), false));
+    for (size_t pass = 0; pass < dependencies.size(); ++pass)
+        for (const size_t dependency : dependencies[pass])
+        {
+            readers[dependency].emplace_back(pass);
+            ancestors[pass][dependency] = true;
+            for (size_t other = 0; other < dependencies.size(); ++other)
+                if (ancestors[dependency][other])
+                    ancestors[pass][other] = true;
+        }
+}
+
+AttachmentAliasing::~AttachmentAliasing()
+{
+    current_aliasing = nullptr;
+    if (requested_size == 0)
+        return;
+
+    // Attachment memory of the last graph created, and what it would take without aliasing
+    PROFILER_COUNTER(RenderGraphAttachmentBytes, allocated_size);
+    PROFILER_COUNTER(RenderGraphRequestedAttachmentBytes, requested_size - lazy_size);
+    PROFILER_COUNTER(RenderGraphLazyAttachmentBytes, lazy_size);
+}
+
+bool AttachmentAliasing::can_alias(const RenderPassInstanceBase& pass) const
+{
+    const auto found = pass_indices.find(&pass);
+    return found != pass_indices.end() && found->second != entry_index && !pass.get_definition().b_is_compute_pass;
+}
+
+void AttachmentAliasing::bind(const RenderPassInstanceBase& pass, const Image& image)
+{
+    const auto   device_ptr = device.lock();
+    VmaAllocator allocator  = device_ptr->get_allocator().allocator;
+    const size_t pass_index = pass_indices.at(&pass);
+    for (size_t device_image = 0; device_image < image.get_resource().size(); ++device_image)
+    {
+        Image::ImageResource& resource = *image.get_resource()[device_image];
+        VkMemoryRequirements  requirements;
+        vkGetImageMemoryRequirements(device_ptr->raw(), resource.ptr, &requirements);
+        requested_size += requirements.size;
+
+        // Lazily allocated memory is only committed by the GPUs that need it (tile based ones), there is no need to share it
+        if (image.get_params().transient_attachment)
+        {
+            constexpr VmaAllocationCreateInfo lazy_infos{.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED};
+            VmaAllocation                     lazy_allocation;
+            if (vmaAllocateMemoryForImage(allocator, resource.ptr, &lazy_infos, &lazy_allocation, nullptr) == VK_SUCCESS)
+            {
+                VK_CHECK(vmaBindImageMemory(allocator, lazy_allocation, resource.ptr), "Failed to bind lazily allocated memory to {}", resource.name())
+                resource.bound_memory = std::make_shared<SharedImageMemory>(resource.name() + "_memory", device, lazy_allocation);
+                lazy_size += requirements.size;
+                continue;
+            }
+        }
+
+        MemoryBlock* block = nullptr;
+        for (auto& candidate : blocks)
+            if (candidate.device_image == device_image && candidate.size >= requirements.size && candidate.offset % requirements.alignment == 0 && requirements.memoryTypeBits & 1u << candidate.memory_type &&
+                is_free_for(candidate, pass_index))
+            {
+                block = &candidate;
+                break;
+            }
+        if (!block)
+        {
+            constexpr VmaAllocationCreateInfo block_infos{.usage = VMA_MEMORY_USAGE_GPU_ONLY};
+            VmaAllocation                     block_allocation;
+            VmaAllocationInfo                 allocation_infos;
+            VK_CHECK(vmaAllocateMemory(allocator, &requirements, &block_infos, &block_allocation, &allocation_infos), "Failed to allocate attachment memory for {}", resource.name())
+            block = &blocks.emplace_back(MemoryBlock{
+                .memory = std::make_shared<SharedImageMemory>(std::format("attachment_memory_#{}", blocks.size()), device, block_allocation),
+                .size = requirements.size,
+                .offset = allocation_infos.offset,
+                .memory_type = allocation_infos.memoryType,
+                .device_image = device_image,
+            });
+            allocated_size += requirements.size;
+        }
+        VK_CHECK(vmaBindImageMemory(allocator, block->memory->allocation, resource.ptr), "Failed to bind attachment memory to {}", resource.name())
+        resource.bound_memory = block->memory;
+        block->producers.emplace_back(pass_index);
+    }
+}
+
+bool AttachmentAliasing::is_free_for(const MemoryBlock& block, size_t pass) const
+{
+    for (const size_t producer : block.producers)
+    {
+        if (!ancestors[pass][producer])
+            return false;
+        for (const size_t reader : readers[producer])
+            if (!ancestors[pass][reader])
+                return false;
+    }
+    return true;
+}
+} // namespace Eng::Gfx
@@ -33,13 +33,21 @@ RenderPassInstance::RenderPassInstance(std::weak_ptr<Device> in_device, const Re
     }
 }
 
+void RenderPassInstance::pre_draw_internal(SwapchainImageId swapchain_image)
+{
+    if (!render_pass_interface || !get_current_framebuffer(swapchain_image))
+        return;
+    PROFILER_SCOPE(PreDraw);
+    render_pass_interface->pre_draw(*this);
+}
+
 void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image)
 {
     const auto* framebuffer = get_current_framebuffer(swapchain_image);
     if (!framebuffer)
         return;
     const FrameCommandBuffers& frame_cmds = get_this_frame_command_buffer(device_image);
-    CommandBuffer&             global_cmd = *frame_cmds.command_buffer;
+    CommandBuffer&             global_cmd = frame_cmds.get_primary_command_buffer();
     global_cmd.begin(false);
     global_cmd.begin_debug_marker("BeginRenderPass_" + get_definition().render_pass_ref.to_string(), {1, 0, 0, 1});
 
@@ -76,12 +84,6 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
     };
     global_cmd.begin_render_pass(get_definition().render_pass_ref, begin_infos, enable_parallel_rendering());
 
-    if (render_pass_interface)
-    {
-        PROFILER_SCOPE(PreDraw);
-        render_pass_interface->pre_draw(*this);
-    }
-
     if (enable_parallel_rendering())
     {
         PROFILER_SCOPE(BuildCommandBufferAsync);
@@ -121,25 +123,9 @@ void RenderPassInstance::render_internal(SwapchainImageId swapchain_image, Devic
         PROFILER_SCOPE(PreSubmit);
         render_pass_interface->pre_submit(*this);
     }
-    {
-        PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Submit command buffer for draw pass {}", get_definition().render_pass_ref));
-        // Submit current_thread (wait children completion using children_semaphores)
-        std::vector<VkSemaphore>          children_semaphores = get_semaphores_to_wait(device_image);
-        std::vector<VkPipelineStageFlags> wait_stage(children_semaphores.size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
-        const auto                        command_buffer_ptr            = global_cmd.raw();
-        const auto                        render_finished_semaphore_ptr = get_render_finished_semaphore();
-        const VkSubmitInfo                submit_infos{
-            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-            .waitSemaphoreCount = static_cast<uint32_t>(children_semaphores.size()),
-            .pWaitSemaphores = children_semaphores.data(),
-            .pWaitDstStageMask = wait_stage.data(),
-            .commandBufferCount = 1,
-            .pCommandBuffers = &command_buffer_ptr,
-            .signalSemaphoreCount = 1,
-            .pSignalSemaphores = &render_finished_semaphore_ptr,
-        };
-        global_cmd.submit(submit_infos, get_render_finished_fence(device_image));
-    }
+
+    // Submitted with the rest of the frame, once it waited for the children completion
+    queue_submission(global_cmd, get_semaphores_to_wait(device_image));
 }
 
 void RenderPassInstance::fill_command_buffer(CommandBuffer& cmd, size_t group_index) const
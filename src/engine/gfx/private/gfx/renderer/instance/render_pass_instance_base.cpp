@@ -1,17 +1,24 @@
 #include "gfx/renderer/instance/render_pass_instance_base.hpp"
 
 #include "profiler.hpp"
+#include "gfx/renderer/instance/attachment_aliasing.hpp"
 #include "gfx/renderer/instance/compute_pass_instance.hpp"
+#include "gfx/renderer/instance/pass_dependencies.hpp"
 #include "gfx/renderer/instance/render_pass_instance.hpp"
 #include "gfx/vulkan/command_buffer.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
 #include "gfx/vulkan/framebuffer.hpp"
 #include "gfx/vulkan/image.hpp"
 #include "gfx/vulkan/image_view.hpp"
 #include "gfx/vulkan/semaphore.hpp"
+#include "gfx/vulkan/upload_queue.hpp"
 #include "jobsys/job_sys.hpp"
 
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+
 namespace Eng::Gfx
 {
 
@@ -38,10 +45,14 @@ void RenderPassInstanceBase::init()
     command_buffers.resize(device().lock()->get_image_count());
     for (auto& cmd : command_buffers)
     {
-        cmd.command_buffer = CommandBuffer::create(name() + "_cmd", device(), QueueSpecialization::Graphic);
+        const auto primary = CommandBuffer::create(name() + "_cmd", device(), QueueSpecialization::Graphic);
+        cmd.command_buffers.emplace(std::this_thread::get_id(), primary);
         if (enable_parallel_rendering())
             for (const auto& worker : JobSystem::get().get_workers())
-                cmd.secondary_command_buffers.emplace(worker->thread_id(), SecondaryCommandBuffer::create(get_definition().render_pass_ref.to_string() + "_sec_cmd", cmd.command_buffer, worker->thread_id()));
+                cmd.secondary_command_buffers.emplace(worker->thread_id(), SecondaryCommandBuffer::create(get_definition().render_pass_ref.to_string() + "_sec_cmd", primary, worker->thread_id()));
+        else // The other passes can be recorded by any worker (see render())
+            for (const auto& worker : JobSystem::get().get_workers())
+                cmd.command_buffers.emplace(worker->thread_id(), CommandBuffer::create(name() + "_cmd", device(), QueueSpecialization::Graphic, worker->thread_id()));
     }
 }
 
@@ -58,24 +69,143 @@ RenderPassInstanceBase::RenderPassInstanceBase(std::weak_ptr<Device> in_device,
     }
 }
 
-void RenderPassInstanceBase::render(SwapchainImageId swapchain_image, DeviceImageId device_image)
+uint64_t RenderPassInstanceBase::render(SwapchainImageId swapchain_image, DeviceImageId device_image)
 {
     // Ensure our pass is not called twice. Use reset_for_next_frame() before each frame
     if (prepared)
-        return;
-    PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Prepare command buffer for draw pass {}", definition.render_pass_ref));
+        return 0;
+    PROFILER_SCOPE(RenderGraph);
+
+    std::vector<RenderPassInstanceBase*> passes;
+    collect_passes(passes);
+
+    const std::vector<std::vector<size_t>> pass_dependencies = find_pass_dependencies(passes,
+                                                                                      [](const RenderPassInstanceBase& pass, const auto& callback)
+                                                                                      {
+                                                                                          pass.for_each_dependency(
+                                                                                              [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
+                                                                                              {
+                                                                                                  callback(dep.get());
+                                                                                              });
+                                                                                      });
+
+    const auto record_pass = [this, swapchain_image, device_image](RenderPassInstanceBase& pass)
+    {
+        PROFILER_SCOPE_NAMED(RenderPass_Draw, std::format("Prepare command buffer for draw pass {}", pass.definition.render_pass_ref));
+        // Only the root pass draws to the swapchain images, its dependencies use the device images
+        pass.current_swapchain_image = &pass == this ? swapchain_image : device_image;
+        pass.render_internal(pass.current_swapchain_image, device_image);
+    };
+
+    // The interfaces prepare their pass on this thread first : pre_draw() may schedule and await jobs, which would block a worker recording a pass
+    for (RenderPassInstanceBase* pass : passes)
+        pass->pre_draw_internal(pass == this ? swapchain_image : device_image);
+
+    // A pass is recorded once all its dependencies are recorded. The passes splitting their draws across the workers and the root pass are recorded
+    // on this thread, the others are recorded by the workers. The recordings on the workers only draw, without waiting for other jobs.
+    enum class EPassState
+    {
+        Pending,
+        Recording,
+        Recorded
+    };
+    std::vector<EPassState>  states(passes.size(), EPassState::Pending);
+    size_t                   recorded_count = 0;
+    std::vector<size_t>      finished_passes;
+    std::mutex               finished_mutex;
+    std::condition_variable  pass_finished;
+    const bool               use_workers = !JobSystem::get().get_workers().empty();
+    while (recorded_count < passes.size())
+    {
+        std::optional<size_t> local_pass;
+        for (size_t i = 0; i < passes.size(); ++i)
+        {
+            if (states[i] != EPassState::Pending || !std::ranges::all_of(pass_dependencies[i],
+                                                                          [&](size_t dependency)
+                                                                          {
+                                                                              return states[dependency] == EPassState::Recorded;
+                                                                          }))
+                continue;
+
+            if (!use_workers || passes[i] == this || passes[i]->enable_parallel_rendering())
+            {
+                if (!local_pass)
+                    local_pass = i;
+                continue;
+            }
+
+            states[i] = EPassState::Recording;
+            JobSystem::get().schedule(
+                [&, i]
+                {
+                    record_pass(*passes[i]);
+                    std::lock_guard lk(finished_mutex);
+                    finished_passes.emplace_back(i);
+                    pass_finished.notify_one();
+                });
+        }
+
+        if (local_pass)
+        {
+            record_pass(*passes[*local_pass]);
+            states[*local_pass] = EPassState::Recorded;
+            ++recorded_count;
+        }
+
+        std::unique_lock lk(finished_mutex);
+        if (!local_pass)
+            pass_finished.wait(lk,
+                               [&]
+                               {
+                                   return !finished_passes.empty();
+                               });
+        for (const size_t pass : finished_passes)
+            states[pass] = EPassState::Recorded;
+        recorded_count += finished_passes.size();
+        finished_passes.clear();
+    }
 
-    prepared                = true;
-    current_swapchain_image = swapchain_image;
+    // Submit the whole frame in the graph order, so every semaphore wait comes after its signal. The last batch signals the queue timeline.
+    // Passes reusing the memory of another attachment wait for their dependencies before any stage, as depth writes happen before the color output.
+    PROFILER_SCOPE(SubmitRenderGraph);
+    device().lock()->get_upload_queue().flush(); // The uploads of this frame go in one transfer submission, before the frame
+    std::vector<std::vector<VkPipelineStageFlags>> wait_stages(passes.size());
+    std::vector<CommandBuffer*>                    batch_command_buffers;
+    std::vector<VkSubmitInfo>                      batch_submit_infos;
+    for (size_t i = 0; i < passes.size(); ++i)
+    {
+        const PendingSubmission& submission = passes[i]->pending_submission;
+        if (!submission.command_buffer)
+            continue;
+        const bool aliased_memory = passes[i]->frame_resources && passes[i]->frame_resources->aliased_memory;
+        wait_stages[i].resize(submission.wait_semaphores.size(), aliased_memory ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        batch_command_buffers.emplace_back(submission.command_buffer);
+        batch_submit_infos.emplace_back(VkSubmitInfo{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .waitSemaphoreCount = static_cast<uint32_t>(submission.wait_semaphores.size()),
+            .pWaitSemaphores = submission.wait_semaphores.data(),
+            .pWaitDstStageMask = wait_stages[i].data(),
+            .signalSemaphoreCount = 1,
+            .pSignalSemaphores = &submission.signal_semaphore,
+        });
+    }
+    const uint64_t frame_value = CommandBuffer::submit(batch_command_buffers, batch_submit_infos);
+    for (const auto& pass : passes)
+        pass->pending_submission = {};
+    return frame_value;
+}
 
-    // @TODO : parallelize
+void RenderPassInstanceBase::collect_passes(std::vector<RenderPassInstanceBase*>& passes)
+{
+    if (prepared)
+        return;
+    prepared = true;
     for_each_dependency(
         [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
         {
-            dep->render(device_image, device_image);
+            dep->collect_passes(passes);
         });
-
-    render_internal(swapchain_image, device_image);
+    passes.emplace_back(this);
 }
 
 void RenderPassInstanceBase::for_each_dependency(const std::function<void(const std::shared_ptr<RenderPassInstanceBase>&)>& callback) const
@@ -147,19 +277,37 @@ VkSemaphore RenderPassInstanceBase::get_render_finished_semaphore() const
     return render_finished_semaphores[current_swapchain_image]->raw();
 }
 
+void RenderPassInstanceBase::queue_submission(CommandBuffer& cmd, std::vector<VkSemaphore> wait_semaphores)
+{
+    pending_submission = {
+        .command_buffer = &cmd,
+        .wait_semaphores = std::move(wait_semaphores),
+        .signal_semaphore = get_render_finished_semaphore(),
+    };
+}
+
 std::shared_ptr<ImageView> RenderPassInstanceBase::create_view_for_attachment(const std::string& attachment_name)
 {
     auto attachment = definition.find_attachment_by_name(attachment_name);
     if (!attachment)
         LOG_FATAL("Attachment {} not found", attachment_name);
-    return ImageView::create(attachment_name, Image::create(attachment_name, device(),
-                                                            ImageParameter{
-                                                                .format = attachment->color_format,
-                                                                .gpu_write_capabilities = ETextureGPUWriteCapabilities::Enabled,
-                                                                .buffer_type = EBufferType::IMMEDIATE,
-                                                                .width = resolution().x,
-                                                                .height = resolution().y,
-                                                            }));
+    AttachmentAliasing* aliasing = AttachmentAliasing::current();
+    if (aliasing && (!aliasing->can_alias(*this) || attachment->b_read_outside_graph))
+        aliasing = nullptr;
+    const auto image = Image::create(attachment_name, device(),
+                                     ImageParameter{
+                                         .format = attachment->color_format,
+                                         .gpu_write_capabilities = ETextureGPUWriteCapabilities::Enabled,
+                                         .gpu_read_capabilities = attachment->b_transient ? ETextureGPUReadCapabilities::None : ETextureGPUReadCapabilities::Sampling,
+                                         .buffer_type = EBufferType::IMMEDIATE,
+                                         .width = resolution().x,
+                                         .height = resolution().y,
+                                         .transient_attachment = attachment->b_transient,
+                                         .bind_memory = !aliasing,
+                                     });
+    if (aliasing)
+        aliasing->bind(*this, *image);
+    return ImageView::create(attachment_name, image);
 }
 
 uint8_t RenderPassInstanceBase::get_image_count() const
@@ -181,6 +329,14 @@ const FrameCommandBuffers& RenderPassInstanceBase::get_this_frame_command_buffer
     return command_buffers[device_image];
 }
 
+CommandBuffer& FrameCommandBuffers::get_primary_command_buffer() const
+{
+    auto found = command_buffers.find(std::this_thread::get_id());
+    if (found == command_buffers.end())
+        LOG_FATAL("This pass cannot be recorded from the current thread");
+    return *found->second;
+}
+
 CommandBuffer& FrameCommandBuffers::get_this_thread_command_buffer(const Framebuffer& framebuffer) const
 {
     if (auto found = secondary_command_buffers.find(std::this_thread::get_id()); found != secondary_command_buffers.end())
@@ -188,7 +344,7 @@ CommandBuffer& FrameCommandBuffers::get_this_thread_command_buffer(const Framebu
         found->second->set_framebuffer(&framebuffer);
         return *found->second;
     }
-    return *command_buffer;
+    return get_primary_command_buffer();
 }
 
 std::shared_ptr<RenderPassInstanceBase> RenderPassInstanceBase::create(std::weak_ptr<Device> device, const Renderer& renderer, const RenderPassGenericId& rp_ref)
@@ -233,6 +389,9 @@ FrameResources* RenderPassInstanceBase::create_or_resize(const glm::uvec2& viewp
 
     viewport_res = viewport;
 
+    // The outermost call shares the attachment memory of all the passes it creates
+    const auto aliasing_scope = AttachmentAliasing::begin(device(), *this);
+
     for_each_dependency(
         [&](const std::shared_ptr<RenderPassInstanceBase>& dep)
         {
@@ -261,6 +420,8 @@ FrameResources* RenderPassInstanceBase::create_or_resize(const glm::uvec2& viewp
 
     current_resolution = desired_resolution;
 
+    const AttachmentAliasing* aliasing   = AttachmentAliasing::current();
+    next_frame_resources->aliased_memory = aliasing && aliasing->can_alias(*this);
     for (const auto& attachment : get_definition().attachments_sorted)
         next_frame_resources->images.emplace(attachment.name, create_view_for_attachment(attachment.name));
     return &*next_frame_resources;
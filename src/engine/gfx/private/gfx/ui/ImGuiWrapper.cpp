@@ -14,9 +14,11 @@
 #include "gfx/vulkan/pipeline.hpp"
 #include "gfx/vulkan/sampler.hpp"
 #include "gfx/vulkan/shader_module.hpp"
+#include "gfx/vulkan/transient_allocator.hpp"
 #include "gfx/window.hpp"
 
 #include <GLFW/glfw3.h>
+#include <ranges>
 
 namespace Eng::Gfx
 {
@@ -482,8 +484,6 @@ ImGuiWrapper::ImGuiWrapper(std::string in_name, const std::string& render_pass,
     //bd->PrevUserCallbackCursorEnter = glfwSetCursorEnterCallback(window, ImGui_ImplGlfw_CursorEnterCallback);
     //bd->PrevUserCallbackMonitor     = glfwSetMonitorCallback(ImGui_ImplGlfw_MonitorCallback);
 
-    mesh = Mesh::create(name + "_mesh", device, sizeof(ImDrawVert), EBufferType::IMMEDIATE);
-
     image_sampler = Sampler::create(name + "_generic_sampler", device, Sampler::CreateInfos{});
 
     auto compilation_result = ShaderCompiler::Compiler::get().create_session("internal/imgui")->compile(render_pass, PermutationDescription{});
@@ -710,16 +710,18 @@ void ImGuiWrapper::end(CommandBuffer& cmd)
         vtx_size += cmd_list->VtxBuffer.Size;
         idx_size += cmd_list->IdxBuffer.Size;
     }
-    mesh->reserve_indices(idx_size, IndexBufferType::Uint16);
-    mesh->reserve_vertices(vtx_size);
+    // Rewritten every frame : copied straight to the transient memory of the frame
+    auto&                 transient_allocator = device.lock()->get_transient_allocator();
+    const TransientBuffer vertices            = transient_allocator.allocate(vtx_size * sizeof(ImDrawVert));
+    const TransientBuffer indices             = transient_allocator.allocate(idx_size * sizeof(ImDrawIdx));
 
     size_t vtx_offset = 0;
     size_t idx_offset = 0;
     for (int n = 0; n < draw_data->CmdListsCount; n++)
     {
         const ImDrawList* cmd_list = draw_data->CmdLists[n];
-        mesh->set_indexed_vertices(vtx_offset, BufferData(cmd_list->VtxBuffer.Data, sizeof(ImDrawVert), cmd_list->VtxBuffer.Size), idx_offset,
-                                   BufferData(cmd_list->IdxBuffer.Data, sizeof(ImDrawIdx), cmd_list->IdxBuffer.Size));
+        std::memcpy(vertices.data + vtx_offset * sizeof(ImDrawVert), cmd_list->VtxBuffer.Data, cmd_list->VtxBuffer.Size * sizeof(ImDrawVert));
+        std::memcpy(indices.data + idx_offset * sizeof(ImDrawIdx), cmd_list->IdxBuffer.Data, cmd_list->IdxBuffer.Size * sizeof(ImDrawIdx));
         vtx_offset += cmd_list->VtxBuffer.Size;
         idx_offset += cmd_list->IdxBuffer.Size;
     }
@@ -759,6 +761,8 @@ void ImGuiWrapper::end(CommandBuffer& cmd)
     int global_idx_offset = 0;
 
     cmd.bind_pipeline(imgui_material);
+    cmd.bind_vertex_buffer(vertices);
+    cmd.bind_index_buffer(indices, sizeof(ImDrawIdx) == 2 ? IndexBufferType::Uint16 : IndexBufferType::Uint32);
 
     bool used_other_image = true;
 
@@ -811,9 +815,10 @@ void ImGuiWrapper::end(CommandBuffer& cmd)
                             unused_image.erase(pcmd->TextureId);
                             if (const auto found_descriptors = per_image_descriptor.find(found_image_view->second); found_descriptors != per_image_descriptor.end())
                             {
+                                // The views shown change from one frame to the other : their sets come from the per-frame pools
                                 if (!found_descriptors->second.second)
                                 {
-                                    const auto descriptors = DescriptorSet::create(name + "_descriptor:" + found_image_view->second->get_name(), device, imgui_material->get_layout(), found_image_view->second->raw().size() <= 1);
+                                    const auto descriptors = DescriptorSet::create_transient(name + "_descriptor:" + found_image_view->second->get_name(), device, imgui_material->get_layout());
                                     descriptors->bind_image("sTexture", found_image_view->second);
                                     descriptors->bind_sampler("sSampler", image_sampler);
                                     found_descriptors->second.second = descriptors;
@@ -825,7 +830,7 @@ void ImGuiWrapper::end(CommandBuffer& cmd)
                     else if (used_other_image)
                         cmd.bind_descriptors(*imgui_font_descriptor, *imgui_material);
 
-                    cmd.draw_mesh(*mesh, pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, pcmd->ElemCount);
+                    cmd.draw_indexed(pcmd->IdxOffset + global_idx_offset, pcmd->VtxOffset + global_vtx_offset, pcmd->ElemCount);
                 }
             }
         }
@@ -833,13 +838,15 @@ void ImGuiWrapper::end(CommandBuffer& cmd)
         global_vtx_offset += cmd_list->VtxBuffer.Size;
     }
 
-    // Clear unused descriptors
+    // Clear unused images, the transient descriptors are only valid during this frame
     for (const auto& image_id : unused_image)
         if (const auto image = per_image_ids.find(image_id); image != per_image_ids.end())
         {
             per_image_descriptor.erase(image->second);
             per_image_ids.erase(image_id);
         }
+    for (auto& descriptors : per_image_descriptor | std::views::values)
+        descriptors.second = nullptr;
 }
 
 ImTextureID ImGuiWrapper::add_image(const std::shared_ptr<ImageView>& image_view)
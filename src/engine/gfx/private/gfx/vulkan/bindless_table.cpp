@@ -0,0 +1,153 @@
+#include "gfx/vulkan/bindless_table.hpp"
+
+#include "logger.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/image_view.hpp"
+#include "gfx/vulkan/sampler.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+
+namespace Eng::Gfx
+{
+BindlessSlot::BindlessSlot(std::string in_name, std::weak_ptr<Device> in_device, std::weak_ptr<BindlessTable> in_table, uint32_t in_binding, uint32_t in_index)
+    : DeviceResource(std::move(in_name), std::move(in_device)), table(std::move(in_table)), binding(in_binding), index(in_index)
+{
+}
+
+BindlessSlot::~BindlessSlot()
+{
+    if (const auto table_ptr = table.lock())
+        table_ptr->free(binding, index);
+}
+
+BindlessTable::BindlessTable(std::weak_ptr<Device> in_device, uint32_t texture_count, uint32_t sampler_count) : device(std::move(in_device))
+{
+    bindings[texture_binding].capacity = texture_count;
+    bindings[sampler_binding].capacity = sampler_count;
+
+    const VkDescriptorSetLayoutBinding layout_bindings[] = {
+        VkDescriptorSetLayoutBinding{
+            .binding = texture_binding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = texture_count,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+        },
+        VkDescriptorSetLayoutBinding{
+            .binding = sampler_binding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = sampler_count,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+        },
+    };
+
+    // Unused slots are never written, and a slot is only written while the frames in flight don't use it
+    constexpr VkDescriptorBindingFlags binding_flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    const VkDescriptorBindingFlags     flags[]       = {binding_flags, binding_flags};
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo flags_infos{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = 2,
+        .pBindingFlags = flags,
+    };
+    const VkDescriptorSetLayoutCreateInfo layout_infos{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = &flags_infos,
+        .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        .bindingCount = 2,
+        .pBindings = layout_bindings,
+    };
+    const auto device_ptr = device.lock();
+    VK_CHECK(vkCreateDescriptorSetLayout(device_ptr->raw(), &layout_infos, nullptr, &layout), "Failed to create bindless descriptor set layout")
+    device_ptr->debug_set_object_name("bindless_set_layout", layout);
+
+    const VkDescriptorPoolSize pool_sizes[] = {
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, .descriptorCount = texture_count},
+        VkDescriptorPoolSize{.type = VK_DESCRIPTOR_TYPE_SAMPLER, .descriptorCount = sampler_count},
+    };
+    const VkDescriptorPoolCreateInfo pool_infos{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+        .maxSets = 1,
+        .poolSizeCount = 2,
+        .pPoolSizes = pool_sizes,
+    };
+    VK_CHECK(vkCreateDescriptorPool(device_ptr->raw(), &pool_infos, nullptr, &pool), "Failed to create bindless descriptor pool")
+    device_ptr->debug_set_object_name("bindless_pool", pool);
+
+    const VkDescriptorSetAllocateInfo allocate_infos{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &layout,
+    };
+    VK_CHECK(vkAllocateDescriptorSets(device_ptr->raw(), &allocate_infos, &descriptor_set), "Failed to allocate bindless descriptor set")
+    device_ptr->debug_set_object_name("bindless_descriptors", descriptor_set);
+}
+
+BindlessTable::~BindlessTable()
+{
+    const auto device_ptr = device.lock();
+    vkDestroyDescriptorPool(device_ptr->raw(), pool, nullptr);
+    vkDestroyDescriptorSetLayout(device_ptr->raw(), layout, nullptr);
+}
+
+std::shared_ptr<BindlessSlot> BindlessTable::add_texture(const std::shared_ptr<ImageView>& view)
+{
+    if (view->raw().size() > 1)
+        LOG_FATAL("Cannot add '{}' to the bindless table : images with one view per swapchain image are not supported", view->get_name());
+
+    std::lock_guard lock(table_mutex);
+    auto            slot = std::make_shared<BindlessSlot>(view->get_name() + "_bindless", device, weak_from_this(), texture_binding, allocate(texture_binding));
+    slot->view           = view;
+
+    const VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptor_set,
+        .dstBinding = texture_binding,
+        .dstArrayElement = slot->get_index(),
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+        .pImageInfo = &view->get_descriptor_infos_current(),
+    };
+    vkUpdateDescriptorSets(device.lock()->raw(), 1, &write, 0, nullptr);
+    return slot;
+}
+
+std::shared_ptr<BindlessSlot> BindlessTable::add_sampler(const std::shared_ptr<Sampler>& sampler)
+{
+    std::lock_guard lock(table_mutex);
+    auto            slot = std::make_shared<BindlessSlot>("sampler_bindless", device, weak_from_this(), sampler_binding, allocate(sampler_binding));
+    slot->sampler        = sampler;
+
+    const VkWriteDescriptorSet write{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = descriptor_set,
+        .dstBinding = sampler_binding,
+        .dstArrayElement = slot->get_index(),
+        .descriptorCount = 1,
+        .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+        .pImageInfo = &sampler->get_descriptor_infos(),
+    };
+    vkUpdateDescriptorSets(device.lock()->raw(), 1, &write, 0, nullptr);
+    return slot;
+}
+
+uint32_t BindlessTable::allocate(uint32_t binding)
+{
+    Binding& table_binding = bindings[binding];
+    if (!table_binding.free_indices.empty())
+    {
+        const uint32_t index = table_binding.free_indices.back();
+        table_binding.free_indices.pop_back();
+        return index;
+    }
+    if (table_binding.next == table_binding.capacity)
+        LOG_FATAL("Bindless table is full : {} {} are in use", table_binding.capacity, binding == texture_binding ? "textures" : "samplers");
+    return table_binding.next++;
+}
+
+void BindlessTable::free(uint32_t binding, uint32_t index)
+{
+    std::lock_guard lock(table_mutex);
+    bindings[binding].free_indices.push_back(index);
+}
+} // namespace Eng::Gfx
@@ -2,8 +2,7 @@
 
 #include "gfx/vulkan/buffer.hpp"
 
-#include "gfx/vulkan/command_buffer.hpp"
-#include "gfx/vulkan/fence.hpp"
+#include "gfx/vulkan/upload_queue.hpp"
 #include "profiler.hpp"
 #include "gfx/vulkan/vk_wrap.hpp"
 
@@ -83,8 +82,7 @@ void Buffer::set_data(size_t start_index, const BufferData& data)
     case EBufferType::IMMUTABLE:
         LOG_FATAL("Cannot resize immutable buffer !!")
     case EBufferType::STATIC:
-        device.lock()->wait();
-        buffers[0]->set_data_and_wait(start_index, data);
+        buffers[0]->set_data(start_index, data, true);
         break;
     case EBufferType::DYNAMIC:
         if (start_index != 0)
@@ -111,6 +109,7 @@ void Buffer::wait_data_upload() const
     {
     case EBufferType::IMMUTABLE:
     case EBufferType::STATIC:
+        buffers[0]->wait_data_upload();
         break;
     case EBufferType::DYNAMIC:
         buffers[device.lock()->get_current_image()]->wait_data_upload();
@@ -146,7 +145,7 @@ VkBuffer Buffer::raw_current()
     case EBufferType::DYNAMIC:
         if (buffers[device.lock()->get_current_image()]->outdated)
         {
-            buffers[device.lock()->get_current_image()]->set_data_and_wait(0, temp_buffer_data);
+            buffers[device.lock()->get_current_image()]->set_data(0, temp_buffer_data);
         }
         for (const auto& buffer : buffers)
             if (!buffer->outdated)
@@ -269,7 +268,7 @@ void Buffer::Resource::set_data_and_wait(size_t start_index, const BufferData& d
     wait_data_upload();
 }
 
-void Buffer::Resource::set_data(size_t start_index, const BufferData& data)
+void Buffer::Resource::set_data(size_t start_index, const BufferData& data, bool b_wait_frames_in_flight)
 {
     if (host_visible)
     {
@@ -287,42 +286,39 @@ void Buffer::Resource::set_data(size_t start_index, const BufferData& data)
     {
         PROFILER_SCOPE_NAMED(CopyBufferIndirect, std::format("Transfer buffer indirect : {}", name()));
 
-        if (data_update_fence)
-            data_update_fence->wait();
-        else
-            data_update_fence = Fence::create("fence", device());
-        Profiler::EventRecorder* transfer_profiler_event = new Profiler::EventRecorder("Create transfer buffer");
-        transfer_buffer                                  = create("transfer_buffer", device(), CreateInfos{.usage = EBufferUsage::TRANSFER_MEMORY}, data);
-        delete transfer_profiler_event;
-
-        Profiler::EventRecorder* transfer_profiler_event2 = new Profiler::EventRecorder("Create command buffer");
-        data_update_cmd                                   = CommandBuffer::create("transfer_cmd_" + name(), device(), QueueSpecialization::Transfer);
-        delete transfer_profiler_event2;
-
-        data_update_cmd->begin(true);
-
-        const VkBufferCopy region = {
-            .srcOffset = 0,
-            .dstOffset = start_index,
-            .size      = data.get_byte_size(),
-        };
-
-        vkCmdCopyBuffer(data_update_cmd->raw(), transfer_buffer->raw_current(), ptr, 1, &region);
-        data_update_cmd->end();
-
-        data_update_cmd->submit({}, &*data_update_fence);
+        // The written range was released to the graphic queue by the previous upload : it is acquired back before being overwritten
+        const UploadToken previous_upload = data_update_token;
+        data_update_token                 = device().lock()->get_upload_queue().upload(
+            {data},
+            [&](const UploadQueue::Commands& commands)
+            {
+                const VkBufferCopy region = {
+                    .srcOffset = commands.offsets[0],
+                    .dstOffset = start_index * data.get_stride(),
+                    .size      = data.get_byte_size(),
+                };
+                const VkBufferMemoryBarrier barrier{
+                    .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                    .buffer = ptr,
+                    .offset = region.dstOffset,
+                    .size = region.size,
+                };
+
+                if (previous_upload)
+                    commands.acquire_from_graphic(barrier, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+                vkCmdCopyBuffer(commands.transfer(), commands.staging_buffer, ptr, 1, &region);
+                commands.release_to_graphic(barrier, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT);
+            },
+            b_wait_frames_in_flight, previous_upload);
     }
 }
 
 void Buffer::Resource::wait_data_upload()
 {
-    if (data_update_fence)
+    if (data_update_token)
     {
         PROFILER_SCOPE_NAMED(WaitBufferCopyIndirect, std::format("Wait buffer indirect transfer : {}", name()));
-        data_update_fence->wait();
+        device().lock()->get_upload_queue().wait(data_update_token);
     }
-    data_update_cmd   = nullptr;
-    data_update_fence = nullptr;
-    transfer_buffer   = nullptr;
 }
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -0,0 +1,130 @@
+#include "gfx/vulkan/buffer_arena.hpp"
+
+#include "profiler.hpp"
+#include "gfx/vulkan/upload_queue.hpp"
+
+namespace Eng::Gfx
+{
+BufferArena::Allocation::Allocation(std::string in_name, std::weak_ptr<Device> in_device, std::weak_ptr<BufferArena> in_arena, size_t in_block, uint32_t in_first_element, uint32_t in_element_count)
+    : DeviceResource(std::move(in_name), std::move(in_device)), arena(std::move(in_arena)), block(in_block), first_element(in_first_element), element_count(in_element_count)
+{
+    const auto arena_ptr = arena.lock();
+    std::lock_guard lock(arena_ptr->arena_mutex);
+    buffer = arena_ptr->blocks[block].buffer;
+}
+
+BufferArena::Allocation::~Allocation()
+{
+    if (const auto arena_ptr = arena.lock())
+        arena_ptr->free(block, first_element, element_count);
+}
+
+Buffer& BufferArena::Allocation::get_buffer() const
+{
+    return *buffer;
+}
+
+BufferArena::BufferArena(std::string in_name, std::weak_ptr<Device> in_device, EBufferUsage in_usage, size_t in_stride, uint32_t in_block_element_count)
+    : name(std::move(in_name)), device(std::move(in_device)), usage(in_usage), stride(in_stride), block_element_count(in_block_element_count)
+{
+}
+
+std::shared_ptr<BufferArena::Allocation> BufferArena::allocate(const std::string& allocation_name, const BufferData& data)
+{
+    PROFILER_SCOPE(BufferArenaAllocate);
+    if (data.get_stride() != stride)
+        LOG_FATAL("Cannot allocate {} in {} : stride {} differs from {}", allocation_name, name, data.get_stride(), stride)
+    const auto element_count = static_cast<uint32_t>(data.get_element_count());
+    if (element_count == 0)
+        return nullptr;
+
+    size_t   block_index   = 0;
+    uint32_t first_element = 0;
+    {
+        std::lock_guard lock(arena_mutex);
+        while (block_index < blocks.size() && !allocate_in_block(blocks[block_index], element_count, first_element))
+            ++block_index;
+        if (block_index == blocks.size())
+        {
+            // Data larger than a block gets a block of its own
+            const uint32_t new_block_size = std::max(block_element_count, element_count);
+            Block&         new_block      = blocks.emplace_back();
+            new_block.buffer              = Buffer::create(std::format("{}_block_#{}", name, block_index), device, Buffer::CreateInfos{.usage = usage, .type = EBufferType::IMMUTABLE}, stride, new_block_size);
+            new_block.free_by_offset.emplace(0, new_block_size);
+            new_block.free_by_size.emplace(new_block_size, 0);
+            LOG_INFO("Created {} block #{} : {:.1f}MB", name, block_index, static_cast<double>(new_block_size * stride) / 1048576.0);
+            allocate_in_block(new_block, element_count, first_element);
+        }
+    }
+
+    auto allocation = std::make_shared<Allocation>(allocation_name, device, weak_from_this(), block_index, first_element, element_count);
+
+    // The range was either never used or released once the GPU was done with it : there is nothing to wait for
+    const VkBuffer block_buffer = allocation->get_buffer().raw_current();
+    device.lock()->get_upload_queue().upload({data},
+                                             [&](const UploadQueue::Commands& commands)
+                                             {
+                                                 const VkBufferCopy region = {
+                                                     .srcOffset = commands.offsets[0],
+                                                     .dstOffset = first_element * stride,
+                                                     .size      = data.get_byte_size(),
+                                                 };
+                                                 vkCmdCopyBuffer(commands.transfer(), commands.staging_buffer, block_buffer, 1, &region);
+                                                 commands.release_to_graphic(
+                                                     VkBufferMemoryBarrier{
+                                                         .sType  = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+                                                         .buffer = block_buffer,
+                                                         .offset = region.dstOffset,
+                                                         .size   = region.size,
+                                                     },
+                                                     VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT);
+                                             });
+    return allocation;
+}
+
+bool BufferArena::allocate_in_block(Block& block, uint32_t element_count, uint32_t& out_first_element)
+{
+    // Smallest free range that fits
+    const auto best_fit = block.free_by_size.lower_bound({element_count, 0});
+    if (best_fit == block.free_by_size.end())
+        return false;
+    const auto [range_size, range_offset] = *best_fit;
+    block.free_by_size.erase(best_fit);
+    block.free_by_offset.erase(range_offset);
+    if (range_size > element_count)
+    {
+        block.free_by_offset.emplace(range_offset + element_count, range_size - element_count);
+        block.free_by_size.emplace(range_size - element_count, range_offset + element_count);
+    }
+    out_first_element = range_offset;
+    return true;
+}
+
+void BufferArena::free(size_t block_index, uint32_t first_element, uint32_t element_count)
+{
+    std::lock_guard lock(arena_mutex);
+    Block&          block = blocks[block_index];
+
+    // Merge with the free neighbours
+    auto next = block.free_by_offset.lower_bound(first_element);
+    if (next != block.free_by_offset.begin())
+    {
+        const auto previous = std::prev(next);
+        if (previous->first + previous->second == first_element)
+        {
+            first_element = previous->first;
+            element_count += previous->second;
+            block.free_by_size.erase({previous->second, previous->first});
+            block.free_by_offset.erase(previous);
+        }
+    }
+    if (next != block.free_by_offset.end() && first_element + element_count == next->first)
+    {
+        element_count += next->second;
+        block.free_by_size.erase({next->second, next->first});
+        block.free_by_offset.erase(next);
+    }
+    block.free_by_offset.emplace(first_element, element_count);
+    block.free_by_size.emplace(element_count, first_element);
+}
+} // namespace Eng::Gfx
@@ -3,11 +3,11 @@
 #include "gfx/vulkan/command_buffer.hpp"
 
 #include "gfx/mesh.hpp"
+#include "gfx/vulkan/bindless_table.hpp"
 #include "gfx/vulkan/buffer.hpp"
 #include "gfx/vulkan/command_pool.hpp"
 #include "gfx/vulkan/descriptor_sets.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
 #include "gfx/vulkan/pipeline.hpp"
 #include "gfx/vulkan/vk_render_pass.hpp"
 #include "jobsys/job_sys.hpp"
@@ -15,10 +15,24 @@
 #include "gfx/vulkan/compute_pipeline.hpp"
 #include "gfx/vulkan/framebuffer.hpp"
 #include "gfx/vulkan/pipeline_layout.hpp"
+#include "gfx/vulkan/transient_allocator.hpp"
 
 namespace Eng::Gfx
 {
-class Fence;
+static VkIndexType vk_index_type(IndexBufferType type)
+{
+    switch (type)
+    {
+    case IndexBufferType::Uint8:
+        return VK_INDEX_TYPE_UINT8_KHR;
+    case IndexBufferType::Uint16:
+        return VK_INDEX_TYPE_UINT16;
+    case IndexBufferType::Uint32:
+        return VK_INDEX_TYPE_UINT32;
+    default:
+        LOG_FATAL("Unhandled index type")
+    }
+}
 
 CommandBuffer::CommandBuffer(std::string in_name, std::weak_ptr<Device> in_device, QueueSpecialization in_type, std::thread::id thread_id, bool secondary)
     : type(in_type), device(std::move(in_device)), thread_id(thread_id), name(std::move(in_name))
@@ -64,18 +78,41 @@ void CommandBuffer::end()
     is_recording = false;
     vkEndCommandBuffer(ptr);
     pool_lock = nullptr;
+
+    PROFILER_COUNTER_ADD(PipelineBinds, current_stats.pipeline_binds);
+    PROFILER_COUNTER_ADD(DescriptorBinds, current_stats.descriptor_binds);
+    PROFILER_COUNTER_ADD(VertexBufferBinds, current_stats.vertex_buffer_binds);
+    PROFILER_COUNTER_ADD(IndexBufferBinds, current_stats.index_buffer_binds);
+    PROFILER_COUNTER_ADD(DrawCalls, current_stats.draw_calls);
 }
 
-void CommandBuffer::submit(VkSubmitInfo submit_infos = {}, const Fence* optional_fence)
+uint64_t CommandBuffer::submit(VkSubmitInfo submit_infos = {})
 {
     b_wait_submission = false;
-    if (optional_fence)
-        optional_fence->reset();
     submit_infos.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_infos.commandBufferCount = 1;
     submit_infos.pCommandBuffers    = &ptr;
     PoolLockGuard lk(pool_mtx);
-    VK_CHECK(device.lock()->get_queues().get_queue(type)->submit(*this, submit_infos, optional_fence), "Failed to submit queue");
+    return device.lock()->get_queues().get_queue(type)->submit(*this, submit_infos);
+}
+
+uint64_t CommandBuffer::submit(const std::vector<CommandBuffer*>& command_buffers, std::vector<VkSubmitInfo> submit_infos)
+{
+    assert(command_buffers.size() == submit_infos.size());
+    if (command_buffers.empty())
+        return 0;
+    std::vector<VkCommandBuffer> raw_command_buffers(command_buffers.size());
+    for (size_t i = 0; i < command_buffers.size(); ++i)
+    {
+        assert(command_buffers[i]->type == command_buffers[0]->type);
+        command_buffers[i]->b_wait_submission = false;
+        raw_command_buffers[i]                = command_buffers[i]->ptr;
+        submit_infos[i].sType                 = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_infos[i].commandBufferCount    = 1;
+        submit_infos[i].pCommandBuffers       = &raw_command_buffers[i];
+    }
+    const CommandBuffer& first = *command_buffers[0];
+    return first.device.lock()->get_queues().get_queue(first.type)->submit(submit_infos);
 }
 
 void CommandBuffer::begin_debug_marker(const std::string& in_name, const std::array<float, 4>& color) const
@@ -94,6 +131,7 @@ void CommandBuffer::draw_procedural(uint32_t vertex_count, uint32_t first_vertex
 {
     assert(std::this_thread::get_id() == thread_id);
     vkCmdDraw(ptr, vertex_count, instance_count, first_vertex, first_instance);
+    ++current_stats.draw_calls;
 }
 
 void CommandBuffer::bind_pipeline(const std::shared_ptr<Pipeline>& pipeline)
@@ -105,80 +143,111 @@ void CommandBuffer::bind_pipeline(const std::shared_ptr<Pipeline>& pipeline)
     if (pipeline->infos().options.line_width != 1.0f)
         vkCmdSetLineWidth(ptr, pipeline->infos().options.line_width);
     vkCmdBindPipeline(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->raw());
+    ++current_stats.pipeline_binds;
 }
 
-void CommandBuffer::bind_descriptors(const DescriptorSet& descriptors, const Pipeline& pipeline) const
+void CommandBuffer::bind_descriptors(const DescriptorSet& descriptors, const Pipeline& pipeline)
 {
     assert(std::this_thread::get_id() == thread_id);
-    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.get_layout()->raw(), 0, 1, &descriptors.raw_current(), 0, nullptr);
+    const VkDescriptorSet  descriptor_set = descriptors.raw_current();
+    const VkPipelineLayout layout         = pipeline.get_layout()->raw();
+    descriptors.get_dynamic_offsets(dynamic_offsets);
+    if (descriptor_set == last_descriptor_set && layout == last_layout && dynamic_offsets == last_dynamic_offsets)
+        return;
+    last_descriptor_set = descriptor_set;
+    last_layout         = layout;
+    last_dynamic_offsets.assign(dynamic_offsets.begin(), dynamic_offsets.end());
+    const VkDescriptorSet sets[] = {descriptor_set, device.lock()->get_bindless_table().raw()};
+    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, pipeline.get_layout()->uses_bindless_table() ? 2 : 1, sets, static_cast<uint32_t>(dynamic_offsets.size()), dynamic_offsets.data());
+    ++current_stats.descriptor_binds;
 }
 
-void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t instance_count, uint32_t first_instance) const
+void CommandBuffer::bind_vertex_buffer(const TransientBuffer& vertices)
+{
+    assert(std::this_thread::get_id() == thread_id);
+    vkCmdBindVertexBuffers(ptr, 0, 1, &vertices.buffer, &vertices.offset);
+    last_vertex_buffer = VK_NULL_HANDLE; // The next mesh binds at offset 0
+    ++current_stats.vertex_buffer_binds;
+}
+
+void CommandBuffer::bind_index_buffer(const TransientBuffer& indices, IndexBufferType index_type)
+{
+    assert(std::this_thread::get_id() == thread_id);
+    vkCmdBindIndexBuffer(ptr, indices.buffer, indices.offset, vk_index_type(index_type));
+    last_index_buffer = VK_NULL_HANDLE;
+    ++current_stats.index_buffer_binds;
+}
+
+void CommandBuffer::draw_indexed(uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count, uint32_t first_instance)
+{
+    assert(std::this_thread::get_id() == thread_id);
+    vkCmdDrawIndexed(ptr, index_count, instance_count, first_index, static_cast<int32_t>(vertex_offset), first_instance);
+    ++current_stats.draw_calls;
+}
+
+void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t instance_count, uint32_t first_instance)
 {
     assert(std::this_thread::get_id() == thread_id);
     if (const auto& vertices = in_mesh.get_vertices())
     {
         constexpr VkDeviceSize offsets[]     = {0};
         const auto             vertex_buffer = vertices->raw_current();
-        vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
+        if (vertex_buffer != last_vertex_buffer)
+        {
+            last_vertex_buffer = vertex_buffer;
+            vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
+            ++current_stats.vertex_buffer_binds;
+        }
+        ++current_stats.draw_calls;
         if (const auto& indices = in_mesh.get_indices())
         {
-            VkIndexType index_buffer_type;
-            switch (in_mesh.get_index_buffer_type())
+            const VkIndexType index_buffer_type = vk_index_type(in_mesh.get_index_buffer_type());
+            const auto index_buffer = indices->raw_current();
+            if (index_buffer != last_index_buffer)
             {
-            case IndexBufferType::Uint8:
-                index_buffer_type = VK_INDEX_TYPE_UINT8_KHR;
-                break;
-            case IndexBufferType::Uint16:
-                index_buffer_type = VK_INDEX_TYPE_UINT16;
-                break;
-            case IndexBufferType::Uint32:
-                index_buffer_type = VK_INDEX_TYPE_UINT32;
-                break;
-            default:
-                LOG_FATAL("Unhandled index type")
+                last_index_buffer = index_buffer;
+                vkCmdBindIndexBuffer(ptr, index_buffer, 0, index_buffer_type);
+                ++current_stats.index_buffer_binds;
             }
-            vkCmdBindIndexBuffer(ptr, indices->raw_current(), 0, index_buffer_type);
-            vkCmdDrawIndexed(ptr, static_cast<uint32_t>(indices->get_element_count()), instance_count, 0, 0, first_instance);
+            vkCmdDrawIndexed(ptr, in_mesh.get_index_count(), instance_count, in_mesh.get_first_index(), static_cast<int32_t>(in_mesh.get_first_vertex()), first_instance);
         }
         else
         {
-            vkCmdDraw(ptr, static_cast<uint32_t>(vertices->get_element_count()), instance_count, 0, first_instance);
+            vkCmdDraw(ptr, in_mesh.get_vertex_count(), instance_count, in_mesh.get_first_vertex(), first_instance);
         }
     }
 }
 
-void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count, uint32_t first_instance) const
+void CommandBuffer::draw_mesh(const Mesh& in_mesh, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count, uint32_t first_instance)
 {
     assert(std::this_thread::get_id() == thread_id);
     if (const auto& vertices = in_mesh.get_vertices())
     {
         constexpr VkDeviceSize offsets[]     = {0};
         const auto             vertex_buffer = vertices->raw_current();
-        vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
+        if (vertex_buffer != last_vertex_buffer)
+        {
+            last_vertex_buffer = vertex_buffer;
+            vkCmdBindVertexBuffers(ptr, 0, 1, &vertex_buffer, offsets);
+            ++current_stats.vertex_buffer_binds;
+        }
+        ++current_stats.draw_calls;
         if (const auto& indices = in_mesh.get_indices())
         {
-            VkIndexType index_buffer_type;
-            switch (in_mesh.get_index_buffer_type())
+            const VkIndexType index_buffer_type = vk_index_type(in_mesh.get_index_buffer_type());
+            const auto index_buffer = indices->raw_current();
+            if (index_buffer != last_index_buffer)
             {
-            case IndexBufferType::Uint8:
-                index_buffer_type = VK_INDEX_TYPE_UINT8_KHR;
-                break;
-            case IndexBufferType::Uint16:
-                index_buffer_type = VK_INDEX_TYPE_UINT16;
-                break;
-            case IndexBufferType::Uint32:
-                index_buffer_type = VK_INDEX_TYPE_UINT32;
-                break;
-            default:
-                LOG_FATAL("Unhandled index type")
+                last_index_buffer = index_buffer;
+                vkCmdBindIndexBuffer(ptr, index_buffer, 0, index_buffer_type);
+                ++current_stats.index_buffer_binds;
             }
-            vkCmdBindIndexBuffer(ptr, indices->raw_current(), 0, index_buffer_type);
-            vkCmdDrawIndexed(ptr, index_count, instance_count, first_index, static_cast<int32_t>(vertex_offset), first_instance);
+            // The offsets are relative to the mesh range in the shared buffers
+            vkCmdDrawIndexed(ptr, index_count, instance_count, in_mesh.get_first_index() + first_index, static_cast<int32_t>(in_mesh.get_first_vertex() + vertex_offset), first_instance);
         }
         else
         {
-            vkCmdDraw(ptr, static_cast<uint32_t>(vertices->get_element_count()), instance_count, vertex_offset, first_instance);
+            vkCmdDraw(ptr, in_mesh.get_vertex_count(), instance_count, in_mesh.get_first_vertex() + vertex_offset, first_instance);
         }
     }
 }
@@ -234,7 +303,10 @@ void CommandBuffer::bind_compute_pipeline(const ComputePipeline& pipeline) const
 
 void CommandBuffer::bind_descriptors(const DescriptorSet& descriptors, const ComputePipeline& pipeline) const
 {
-    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get_layout()->raw(), 0, 1, &descriptors.raw_current(), 0, 0);
+    std::vector<uint32_t> offsets;
+    descriptors.get_dynamic_offsets(offsets);
+    const VkDescriptorSet sets[] = {descriptors.raw_current(), device.lock()->get_bindless_table().raw()};
+    vkCmdBindDescriptorSets(ptr, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.get_layout()->raw(), 0, pipeline.get_layout()->uses_bindless_table() ? 2 : 1, sets, static_cast<uint32_t>(offsets.size()), offsets.data());
 }
 
 void CommandBuffer::dispatch_compute(uint32_t x, uint32_t y, uint32_t z) const
@@ -260,7 +332,13 @@ void CommandBuffer::end_render_pass()
 
 void CommandBuffer::reset_stats()
 {
-    last_pipeline = nullptr;
+    last_pipeline       = nullptr;
+    last_descriptor_set = VK_NULL_HANDLE;
+    last_layout         = VK_NULL_HANDLE;
+    last_dynamic_offsets.clear();
+    last_vertex_buffer  = VK_NULL_HANDLE;
+    last_index_buffer   = VK_NULL_HANDLE;
+    current_stats       = {};
 }
 
 void SecondaryCommandBuffer::begin(bool)
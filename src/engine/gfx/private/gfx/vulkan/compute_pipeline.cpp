@@ -1,6 +1,7 @@
 #include "gfx/vulkan/compute_pipeline.hpp"
 
 #include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/pipeline_cache.hpp"
 #include "gfx/vulkan/pipeline_layout.hpp"
 #include "gfx/vulkan/shader_module.hpp"
 
@@ -22,6 +23,6 @@ ComputePipeline::ComputePipeline(std::string in_name, std::weak_ptr<Device> in_d
         .stage = computeShaderStageInfo,
         .layout = layout->raw(),
     };
-    vkCreateComputePipelines(device().lock()->raw(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &ptr);
+    vkCreateComputePipelines(device().lock()->raw(), device().lock()->get_pipeline_cache().raw(), 1, &pipelineInfo, nullptr, &ptr);
 }
 }
\ No newline at end of file
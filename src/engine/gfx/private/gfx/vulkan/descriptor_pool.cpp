@@ -1,176 +1,222 @@
 #include "gfx/vulkan/descriptor_pool.hpp"
 
+#include "profiler.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/pipeline.hpp"
-#include "gfx/vulkan/pipeline_layout.hpp"
+#include "gfx/vulkan/queue_family.hpp"
 #include "gfx/vulkan/vk_check.hpp"
-#include "shader_compiler/shader_compiler.hpp"
 
-static constexpr uint32_t DESCRIPTOR_PER_POOL = 200;
+#include <algorithm>
+#include <ranges>
+
+// Sets in the first pool of a chain, the next pools are twice as large up to the maximum
+static constexpr uint32_t INITIAL_SETS_PER_POOL = 32;
+static constexpr uint32_t MAX_SETS_PER_POOL     = 1024;
 
 namespace Eng::Gfx
 {
-DescriptorPool::DescriptorPool(std::weak_ptr<Device> in_device) : device(std::move(in_device))
+DescriptorPool::SharedSet::SharedSet(std::string in_name, std::weak_ptr<Device> in_device, std::shared_ptr<PipelineLayout> in_pipeline, std::vector<uint64_t> in_content)
+    : DeviceResource(std::move(in_name), std::move(in_device)), pipeline(std::move(in_pipeline)), content(std::move(in_content))
 {
+    ptr = device().lock()->get_descriptor_pool().allocate(*pipeline);
+    device().lock()->debug_set_object_name(name(), ptr);
 }
 
-PoolDescription::PoolDescription(const PipelineLayout& pipeline)
+DescriptorPool::SharedSet::~SharedSet()
 {
-    ankerl::unordered_dense::map<VkDescriptorType, uint32_t> sizes;
+    device().lock()->get_descriptor_pool().release_shared(*this);
+}
+
+DescriptorPool::DescriptorPool(std::weak_ptr<Device> in_device) : device(std::move(in_device))
+{
+}
 
-    for (const auto& binding : pipeline.get_bindings())
+DescriptorPool::~DescriptorPool()
+{
+    const auto device_ptr = device.lock();
+    for (const auto& thread_pools : threads | std::views::values)
     {
-        VkDescriptorType type;
-        switch (binding.type)
+        for (const auto& chains : thread_pools->layouts | std::views::values)
         {
-        case EBindingType::SAMPLER:
-            type = VK_DESCRIPTOR_TYPE_SAMPLER;
-            break;
-        case EBindingType::COMBINED_IMAGE_SAMPLER:
-            type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            break;
-        case EBindingType::SAMPLED_IMAGE:
-            type = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-            break;
-        case EBindingType::STORAGE_IMAGE:
-            type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-            break;
-        case EBindingType::UNIFORM_TEXEL_BUFFER:
-            type = VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
-            break;
-        case EBindingType::STORAGE_TEXEL_BUFFER:
-            type = VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER;
-            break;
-        case EBindingType::UNIFORM_BUFFER:
-            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            break;
-        case EBindingType::STORAGE_BUFFER:
-            type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            break;
-        case EBindingType::UNIFORM_BUFFER_DYNAMIC:
-            type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-            break;
-        case EBindingType::STORAGE_BUFFER_DYNAMIC:
-            type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-            break;
-        case EBindingType::INPUT_ATTACHMENT:
-            type = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
-            break;
-        default:
-            LOG_FATAL("Unhandled binding type")
+            for (const auto& pool : chains.persistent.pools)
+                vkDestroyDescriptorPool(device_ptr->raw(), pool.ptr, nullptr);
+            for (const auto& chain : chains.transient)
+                for (const auto& pool : chain.pools)
+                    vkDestroyDescriptorPool(device_ptr->raw(), pool.ptr, nullptr);
         }
-
-        auto found = sizes.find(type);
-        if (found != sizes.end())
-            found->second += binding.array_elements > 0 ? binding.array_elements == UINT32_MAX ? 0 : binding.array_elements : 1;
-        else
-            sizes.emplace(type, 1);
     }
-
-    for (const auto& entry : sizes)
-        pool_sizes.emplace_back(entry.first, entry.second);
-    std::ranges::sort(pool_sizes,
-                      [](const VkDescriptorPoolSize& a, const VkDescriptorPoolSize& b)
-                      {
-                          return a.type > b.type;
-                      });
 }
 
-VkDescriptorSet DescriptorPool::allocate(const PipelineLayout& pipeline, size_t& pool_index)
+DescriptorPool::LayoutPools& DescriptorPool::get_layout_pools(const DescriptorLayoutKey& key)
 {
-    PoolDescription description(pipeline);
-
-    std::lock_guard lock(pool_lock);
-    auto            found = pools.find(description);
-    if (found == pools.end())
-        found = pools.emplace(description, std::pair{0, std::vector<std::shared_ptr<Pool>>{}}).first;
-    auto& found_pool = found->second;
+    {
+        std::shared_lock lock(layouts_lock);
+        if (const auto found = layouts.find(key); found != layouts.end())
+            return *found->second;
+    }
+    std::unique_lock lock(layouts_lock);
+    auto&            layout_pools = layouts[key];
+    if (!layout_pools)
+        layout_pools = std::make_unique<LayoutPools>();
+    return *layout_pools;
+}
 
-    for (size_t i = found_pool.first; i < found_pool.second.size(); ++i)
+DescriptorPool::ThreadPools& DescriptorPool::get_thread_pools()
+{
+    const auto thread_id = std::this_thread::get_id();
     {
-        if (const auto handle = found_pool.second[i]->allocate(pipeline.get_descriptor_layout()))
-        {
-            pool_index = i;
-            return handle;
-        }
+        std::shared_lock lock(threads_lock);
+        if (const auto found = threads.find(thread_id); found != threads.end())
+            return *found->second;
     }
-    const auto new_pool = std::make_shared<Pool>(device, description);
-    pool_index          = found_pool.second.size();
-    found_pool.first    = pool_index;
-    const auto handle   = new_pool->allocate(pipeline.get_descriptor_layout());
-    found_pool.second.push_back(new_pool);
-    return handle;
+    std::unique_lock lock(threads_lock);
+    auto&            thread_pools = threads[thread_id];
+    if (!thread_pools)
+        thread_pools = std::make_unique<ThreadPools>();
+    return *thread_pools;
 }
 
-void DescriptorPool::free(const VkDescriptorSet& desc_set, const PipelineLayout& pipeline, size_t pool_index)
+VkDescriptorSet DescriptorPool::allocate_from(PoolChain& chain, const PipelineLayout& pipeline) const
 {
-    PoolDescription description(pipeline);
+    while (chain.current < chain.pools.size() && chain.pools[chain.current].allocated == chain.pools[chain.current].capacity)
+        ++chain.current;
 
-    std::lock_guard lock(pool_lock);
-    auto            found = pools.find(description);
-    if (found == pools.end())
+    if (chain.current == chain.pools.size())
     {
-        LOG_FATAL("Cannot free descriptors : pool not found")
+        PROFILER_SCOPE(CreateDescriptorPool);
+        PoolChain::Pool pool{.capacity = chain.pools.empty() ? INITIAL_SETS_PER_POOL : std::min(chain.pools.back().capacity * 2, MAX_SETS_PER_POOL)};
+        auto            pool_sizes = pipeline.get_descriptor_key().pool_sizes;
+        for (auto& pool_size : pool_sizes)
+            pool_size.descriptorCount *= pool.capacity;
+        const VkDescriptorPoolCreateInfo pool_infos{
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+            .maxSets = pool.capacity,
+            .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
+            .pPoolSizes = pool_sizes.data(),
+        };
+        VK_CHECK(vkCreateDescriptorPool(device.lock()->raw(), &pool_infos, nullptr, &pool.ptr), "Failed to create descriptor pool")
+        chain.pools.emplace_back(pool);
     }
-    auto& found_pool = found->second;
-    if (pool_index < found_pool.first)
-        found_pool.first = pool_index;
 
-    if (found_pool.second[pool_index]->free(desc_set))
+    PoolChain::Pool&                  pool = chain.pools[chain.current];
+    const VkDescriptorSetAllocateInfo descriptor_info{
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = pool.ptr,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &pipeline.get_descriptor_layout(),
+    };
+    VkDescriptorSet descriptor_set;
+    VK_CHECK(vkAllocateDescriptorSets(device.lock()->raw(), &descriptor_info, &descriptor_set), "failed to allocate descriptor sets")
+    ++pool.allocated;
+    return descriptor_set;
+}
+
+VkDescriptorSet DescriptorPool::allocate(const PipelineLayout& pipeline)
+{
     {
-        while (!found_pool.second.empty() && found_pool.second.back()->is_empty())
-            found_pool.second.pop_back();
-        if (found_pool.second.empty())
-            found_pool.first = 0;
-        else if (found_pool.second.size() - 1 < found_pool.first)
-            found_pool.first = found_pool.second.size() - 1;
+        LayoutPools&    layout_pools = get_layout_pools(pipeline.get_descriptor_key());
+        std::lock_guard lock(layout_pools.lock);
+        if (!layout_pools.free_sets.empty())
+        {
+            const VkDescriptorSet descriptor_set = layout_pools.free_sets.back();
+            layout_pools.free_sets.pop_back();
+            return descriptor_set;
+        }
     }
+    ThreadPools&    thread_pools = get_thread_pools();
+    std::lock_guard lock(thread_pools.lock);
+    return allocate_from(thread_pools.layouts[pipeline.get_descriptor_key()].persistent, pipeline);
 }
 
-DescriptorPool::Pool::Pool(std::weak_ptr<Device> in_device, const PoolDescription& description) : initial_space(DESCRIPTOR_PER_POOL), device(std::move(in_device))
+void DescriptorPool::free(VkDescriptorSet desc_set, const PipelineLayout& pipeline)
 {
-    auto pool_sizes = description.pool_sizes;
-    for (auto& pool_size : pool_sizes)
-        pool_size.descriptorCount *= DESCRIPTOR_PER_POOL;
-    space_left = initial_space;
-    const VkDescriptorPoolCreateInfo poolInfo{
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-        .pNext = nullptr,
-        .flags = static_cast<VkDescriptorPoolCreateFlags>(VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT),
-        .maxSets = space_left,
-        .poolSizeCount = static_cast<uint32_t>(pool_sizes.size()),
-        .pPoolSizes = pool_sizes.data(),
-    };
-
-    VK_CHECK(vkCreateDescriptorPool(device.lock()->raw(), &poolInfo, nullptr, &ptr), "Failed to create descriptor pool")
+    LayoutPools&    layout_pools = get_layout_pools(pipeline.get_descriptor_key());
+    std::lock_guard lock(layout_pools.lock);
+    layout_pools.free_sets.emplace_back(desc_set);
 }
 
-DescriptorPool::Pool::~Pool()
+VkDescriptorSet DescriptorPool::allocate_transient(const PipelineLayout& pipeline)
 {
-    vkDestroyDescriptorPool(device.lock()->raw(), ptr, nullptr);
+    ThreadPools&    thread_pools = get_thread_pools();
+    std::lock_guard lock(thread_pools.lock);
+    auto&           transient = thread_pools.layouts[pipeline.get_descriptor_key()].transient;
+    transient.resize(device.lock()->get_image_count());
+    return allocate_from(transient[current_image], pipeline);
 }
 
-VkDescriptorSet DescriptorPool::Pool::allocate(const VkDescriptorSetLayout& layout)
+std::shared_ptr<DescriptorPool::SharedSet> DescriptorPool::acquire_shared(const std::string& name, const std::shared_ptr<PipelineLayout>& pipeline, std::vector<VkWriteDescriptorSet>& writes)
 {
-    if (space_left == 0)
-        return VK_NULL_HANDLE;
+    // The content is what the writes store in the set, in binding order
+    std::ranges::sort(writes, {}, &VkWriteDescriptorSet::dstBinding);
+    std::vector<uint64_t> content;
+    for (const auto& write : writes)
+    {
+        content.insert(content.end(), {write.dstBinding, static_cast<uint64_t>(write.descriptorType), write.descriptorCount});
+        for (uint32_t i = 0; i < write.descriptorCount; ++i)
+            if (write.pImageInfo)
+                content.insert(content.end(), {reinterpret_cast<uint64_t>(write.pImageInfo[i].sampler), reinterpret_cast<uint64_t>(write.pImageInfo[i].imageView), static_cast<uint64_t>(write.pImageInfo[i].imageLayout)});
+            else if (write.pBufferInfo)
+                content.insert(content.end(), {reinterpret_cast<uint64_t>(write.pBufferInfo[i].buffer), write.pBufferInfo[i].offset, write.pBufferInfo[i].range});
+    }
 
-    --space_left;
-    const VkDescriptorSetAllocateInfo descriptor_info{
-        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
-        .descriptorPool = ptr,
-        .descriptorSetCount = 1,
-        .pSetLayouts = &layout,
-    };
-    VkDescriptorSet descriptor_set;
-    VK_CHECK(vkAllocateDescriptorSets(device.lock()->raw(), &descriptor_info, &descriptor_set), "failed to allocate descriptor sets")
-    return descriptor_set;
+    // Written under the lock : the other users never get a set before its descriptors
+    LayoutPools&    layout_pools = get_layout_pools(pipeline->get_descriptor_key());
+    std::lock_guard lock(layout_pools.shared_lock);
+    auto&           shared_set = layout_pools.shared_sets[content];
+    if (auto existing = shared_set.lock())
+        return existing;
+
+    auto new_set = std::make_shared<SharedSet>(name, device, pipeline, std::move(content));
+    for (auto& write : writes)
+        write.dstSet = new_set->ptr;
+    vkUpdateDescriptorSets(device.lock()->raw(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+    shared_set = new_set;
+    return new_set;
 }
 
-bool DescriptorPool::Pool::free(const VkDescriptorSet& desc_set)
+void DescriptorPool::release_shared(const SharedSet& shared_set)
 {
-    vkFreeDescriptorSets(device.lock()->raw(), ptr, 1, &desc_set);
-    space_left++;
-    return is_empty();
+    {
+        LayoutPools&    layout_pools = get_layout_pools(shared_set.pipeline->get_descriptor_key());
+        std::lock_guard lock(layout_pools.shared_lock);
+        // The entry may already point to a new set with the same content
+        if (const auto found = layout_pools.shared_sets.find(shared_set.content); found != layout_pools.shared_sets.end() && found->second.expired())
+            layout_pools.shared_sets.erase(found);
+    }
+    free(shared_set.ptr, *shared_set.pipeline);
+}
+
+void DescriptorPool::next_frame(uint8_t image)
+{
+    PROFILER_SCOPE(ResetTransientDescriptors);
+    const auto device_ptr    = device.lock();
+    const auto graphic_queue = device_ptr->get_queues().get_queue(QueueSpecialization::Graphic);
+
+    // The sets of the image are reset once the last frame that used them completed, which the swapchain would wait for later anyway
+    frame_values.resize(device_ptr->get_image_count(), 0);
+    frame_values[current_image] = graphic_queue->get_submitted_value();
+    {
+        PROFILER_SCOPE(WaitTransientDescriptors);
+        graphic_queue->wait(frame_values[image]);
+    }
+
+    std::shared_lock lock(threads_lock);
+    for (const auto& thread_pools : threads | std::views::values)
+    {
+        std::lock_guard thread_lock(thread_pools->lock);
+        for (auto& chains : thread_pools->layouts | std::views::values)
+        {
+            if (image >= chains.transient.size())
+                continue;
+            PoolChain& chain = chains.transient[image];
+            for (auto& pool : chain.pools)
+            {
+                if (pool.allocated > 0)
+                    vkResetDescriptorPool(device_ptr->raw(), pool.ptr, 0);
+                pool.allocated = 0;
+            }
+            chain.current = 0;
+        }
+    }
+    current_image = image;
 }
-} // namespace Eng::Gfx
\ No newline at end of file
+} // namespace Eng::Gfx
@@ -2,6 +2,7 @@
 
 #include "profiler.hpp"
 
+#include <algorithm>
 #include <ranges>
 #include <utility>
 
@@ -15,23 +16,33 @@
 
 namespace Eng::Gfx
 {
-DescriptorSet::DescriptorSet(const std::string& in_name, const std::weak_ptr<Device>& in_device, const std::shared_ptr<PipelineLayout>& in_pipeline, bool b_in_static) : device(in_device), b_static(b_in_static),
-    name(in_name)
+DescriptorSet::DescriptorSet(const std::string& in_name, const std::weak_ptr<Device>& in_device, const std::shared_ptr<PipelineLayout>& in_pipeline, bool b_in_static, bool b_in_transient)
+    : device(in_device), b_static(b_in_static), b_transient(b_in_transient), name(in_name)
 {
+    std::vector<std::pair<uint32_t, std::string>> dynamic_bindings;
     for (const auto& binding : in_pipeline->get_bindings())
+    {
         descriptor_bindings.insert_or_assign(binding.name, binding.binding);
+        if (binding.type == EBindingType::STORAGE_BUFFER_DYNAMIC || binding.type == EBindingType::UNIFORM_BUFFER_DYNAMIC)
+            dynamic_bindings.emplace_back(binding.binding, binding.name);
+    }
+    // One slot per binding number, in the order vkCmdBindDescriptorSets expects the offsets
+    std::ranges::sort(dynamic_bindings);
+    dynamic_bindings.erase(std::ranges::unique(dynamic_bindings, {}, &std::pair<uint32_t, std::string>::first).begin(), dynamic_bindings.end());
+    for (const auto& binding_name : dynamic_bindings | std::views::values)
+        dynamic_slots.insert_or_assign(binding_name, static_cast<uint32_t>(dynamic_slots.size()));
+    dynamic_offsets = std::vector<std::atomic<uint32_t>>(dynamic_slots.size());
 }
 
-DescriptorSet::Resource::Resource(std::string in_name, const std::weak_ptr<Device>& in_device, const std::weak_ptr<DescriptorSet>& in_parent, const std::shared_ptr<PipelineLayout>& in_pipeline)
-    : DeviceResource(std::move(in_name), in_device), pipeline(in_pipeline), parent(in_parent.lock())
-{
-    ptr = device().lock()->get_descriptor_pool().allocate(*pipeline, pool_index);
-    device().lock()->debug_set_object_name(name(), ptr);
-}
-
-DescriptorSet::Resource::~Resource()
+DescriptorSet::Resource::Resource(std::string in_name, const std::weak_ptr<Device>& in_device, const std::weak_ptr<DescriptorSet>& in_parent, const std::shared_ptr<PipelineLayout>& in_pipeline, bool b_in_transient)
+    : DeviceResource(std::move(in_name), in_device), b_transient(b_in_transient), pipeline(in_pipeline), parent(in_parent.lock())
 {
-    device().lock()->get_descriptor_pool().free(ptr, *pipeline, pool_index);
+    // The other sets get theirs on the first update, once their descriptors are known
+    if (b_transient)
+    {
+        ptr = device().lock()->get_descriptor_pool().allocate_transient(*pipeline);
+        device().lock()->debug_set_object_name(name(), raw());
+    }
 }
 
 DescriptorSet::~DescriptorSet()
@@ -44,38 +55,45 @@ DescriptorSet::~DescriptorSet()
 
 std::shared_ptr<DescriptorSet> DescriptorSet::create(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline, bool b_static)
 {
-    const auto descriptors = std::shared_ptr<DescriptorSet>(new DescriptorSet(name, device, pipeline, b_static));
+    const auto descriptors = std::shared_ptr<DescriptorSet>(new DescriptorSet(name, device, pipeline, b_static, false));
 
     if (b_static)
-        descriptors->resources = std::vector{std::make_shared<Resource>(name, device, descriptors, pipeline)};
+        descriptors->resources = std::vector{std::make_shared<Resource>(name, device, descriptors, pipeline, false)};
     else
         for (size_t i = 0; i < device.lock()->get_image_count(); ++i)
-            descriptors->resources.push_back(std::make_shared<Resource>(name + "_#" + std::to_string(i), device, descriptors, pipeline));
+            descriptors->resources.push_back(std::make_shared<Resource>(name + "_#" + std::to_string(i), device, descriptors, pipeline, false));
 
     return descriptors;
 }
 
-const VkDescriptorSet& DescriptorSet::raw_current() const
+std::shared_ptr<DescriptorSet> DescriptorSet::create_transient(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline)
 {
-    std::lock_guard lk(update_lock);
-    if (b_static)
+    const auto descriptors = std::shared_ptr<DescriptorSet>(new DescriptorSet(name, device, pipeline, false, true));
+    descriptors->resources = std::vector{std::make_shared<Resource>(name, device, descriptors, pipeline, true)};
+    return descriptors;
+}
+
+VkDescriptorSet DescriptorSet::raw_current() const
+{
+    const auto& resource = b_static || b_transient ? resources[0] : resources[device.lock()->get_current_image()];
+    // The version is only marked as written once vkUpdateDescriptorSets() returned : until then, the readers wait for the update under the lock
+    if (resource->is_outdated(binding_version.load(std::memory_order_acquire)))
     {
-        resources[0]->update();
-        return resources[0]->raw();
+        std::lock_guard lk(update_lock);
+        resource->update();
     }
-    auto& resource = resources[device.lock()->get_current_image()];
-    resource->update();
     return resource->raw();
 }
 
 void DescriptorSet::Resource::update()
 {
-    if (!outdated)
+    auto           parent_ptr = parent.lock();
+    const uint64_t version    = parent_ptr->binding_version.load(std::memory_order_relaxed);
+    if (!is_outdated(version))
         return;
 
     PROFILER_SCOPE(UpdateDescriptorSets);
 
-    auto     parent_ptr   = parent.lock();
     uint32_t image_count  = 0;
     uint32_t buffer_count = 0;
     for (const auto& val : parent_ptr->write_descriptors)
@@ -90,10 +108,20 @@ void DescriptorSet::Resource::update()
     std::vector<VkWriteDescriptorSet> desc_sets;
     for (const auto& val : parent_ptr->write_descriptors)
         if (auto found = parent_ptr->descriptor_bindings.find(val.first); found != parent_ptr->descriptor_bindings.end())
-            val.second->fill(desc_sets, ptr, found->second, image_descs, buffer_descs);
+            val.second->fill(desc_sets, raw(), found->second, image_descs, buffer_descs);
 
-    vkUpdateDescriptorSets(device().lock()->raw(), static_cast<uint32_t>(desc_sets.size()), desc_sets.data(), 0, nullptr);
-    outdated = false;
+    if (b_transient)
+        vkUpdateDescriptorSets(device().lock()->raw(), static_cast<uint32_t>(desc_sets.size()), desc_sets.data(), 0, nullptr);
+    else
+    {
+        // The frames in flight may still use the previous set
+        auto previous_set = std::move(shared_set);
+        shared_set        = device().lock()->get_descriptor_pool().acquire_shared(name(), pipeline, desc_sets);
+        ptr.store(shared_set->raw(), std::memory_order_relaxed);
+        if (previous_set)
+            device().lock()->drop_resource(previous_set);
+    }
+    written_version.store(version, std::memory_order_release);
 }
 
 void DescriptorSet::bind_images(const std::string& binding_name, const std::vector<std::shared_ptr<ImageView>>& in_images)
@@ -143,7 +171,28 @@ void DescriptorSet::bind_buffers(const std::string& binding_name, const std::vec
         if (b_static && buffer->raw().size() > 1)
             LOG_ERROR("Cannot bind dynamic buffer '{}' to static descriptors '{}::{}'", buffer->get_name(), name, binding_name);
     }
-    try_insert(binding_name, std::make_shared<BufferDescriptor>(in_buffers));
+    const auto slot = dynamic_slots.find(binding_name);
+    if (slot != dynamic_slots.end())
+        dynamic_offsets[slot->second].store(0, std::memory_order_relaxed);
+    try_insert(binding_name, std::make_shared<BufferDescriptor>(in_buffers, slot != dynamic_slots.end() ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER));
+}
+
+void DescriptorSet::bind_buffer(const std::string& binding_name, const TransientBuffer& in_buffer)
+{
+    if (!in_buffer)
+        LOG_FATAL("Invalid transient buffer provided to descriptors");
+
+    const auto slot = dynamic_slots.find(binding_name);
+    if (slot != dynamic_slots.end())
+        dynamic_offsets[slot->second].store(static_cast<uint32_t>(in_buffer.offset), std::memory_order_relaxed);
+    try_insert(binding_name, std::make_shared<TransientBufferDescriptor>(in_buffer, slot != dynamic_slots.end()));
+}
+
+void DescriptorSet::get_dynamic_offsets(std::vector<uint32_t>& out_offsets) const
+{
+    out_offsets.resize(dynamic_offsets.size());
+    for (size_t i = 0; i < dynamic_offsets.size(); ++i)
+        out_offsets[i] = dynamic_offsets[i].load(std::memory_order_relaxed);
 }
 
 void DescriptorSet::ImagesDescriptor::fill(std::vector<VkWriteDescriptorSet>& out_sets, VkDescriptorSet dst_set, uint32_t binding, std::vector<VkDescriptorImageInfo>& image_descs,
@@ -216,7 +265,7 @@ void DescriptorSet::BufferDescriptor::fill(std::vector<VkWriteDescriptorSet>&
         .dstBinding = binding,
         .dstArrayElement = 0,
         .descriptorCount = static_cast<uint32_t>(buffers.size()),
-        .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .descriptorType = type,
         .pBufferInfo = &buffer_descs[start],
     });
 }
@@ -224,7 +273,7 @@ void DescriptorSet::BufferDescriptor::fill(std::vector<VkWriteDescriptorSet>&
 bool DescriptorSet::BufferDescriptor::equals(const Descriptor& other) const
 {
     const auto* other_ptr = static_cast<const BufferDescriptor*>(&other);
-    if (buffers.size() != other_ptr->buffers.size())
+    if (buffers.size() != other_ptr->buffers.size() || type != other_ptr->type)
         return false;
     for (size_t i = 0; i < buffers.size(); ++i)
         if (buffers[i] != other_ptr->buffers[i])
@@ -232,6 +281,27 @@ bool DescriptorSet::BufferDescriptor::equals(const Descriptor& other) const
     return true;
 }
 
+void DescriptorSet::TransientBufferDescriptor::fill(std::vector<VkWriteDescriptorSet>& out_sets, VkDescriptorSet dst_set, uint32_t binding, std::vector<VkDescriptorImageInfo>&,
+                                                    std::vector<VkDescriptorBufferInfo>& buffer_descs)
+{
+    buffer_descs.emplace_back(infos);
+    out_sets.emplace_back(VkWriteDescriptorSet{
+        .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+        .dstSet = dst_set,
+        .dstBinding = binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = b_dynamic ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+        .pBufferInfo = &buffer_descs.back(),
+    });
+}
+
+bool DescriptorSet::TransientBufferDescriptor::equals(const Descriptor& other) const
+{
+    const auto* other_ptr = static_cast<const TransientBufferDescriptor*>(&other);
+    return infos.buffer == other_ptr->infos.buffer && infos.offset == other_ptr->infos.offset && infos.range == other_ptr->infos.range && b_dynamic == other_ptr->b_dynamic;
+}
+
 bool DescriptorSet::try_insert(const std::string& binding_name, const std::shared_ptr<Descriptor>& descriptor)
 {
     std::lock_guard lk(update_lock);
@@ -243,8 +313,7 @@ bool DescriptorSet::try_insert(const std::string& binding_name, const std::share
     }
     else
         write_descriptors.emplace(binding_name, descriptor);
-    for (const auto& resource : resources)
-        resource->mark_as_dirty();
+    binding_version.fetch_add(1, std::memory_order_release);
     return true;
 }
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -6,9 +6,14 @@
 #include <vk_mem_alloc.h>
 
 #include "gfx/gfx.hpp"
+#include "gfx/vulkan/buffer_arena.hpp"
+#include "gfx/vulkan/bindless_table.hpp"
 #include "gfx/vulkan/descriptor_pool.hpp"
 #include "gfx/vulkan/instance.hpp"
+#include "gfx/vulkan/pipeline_cache.hpp"
 #include "gfx/vulkan/queue_family.hpp"
+#include "gfx/vulkan/transient_allocator.hpp"
+#include "gfx/vulkan/upload_queue.hpp"
 #include "gfx/vulkan/vk_render_pass.hpp"
 #include "gfx/vulkan/vk_wrap.hpp"
 
@@ -22,6 +27,19 @@ void Device::next_frame()
 {
     glfwPollEvents();
     current_image = (current_image + 1) % image_count;
+    upload_queue->flush();
+    transient_allocator->next_frame(current_image);
+    descriptor_pool->next_frame(current_image);
+    pipeline_cache->next_frame();
+
+    std::lock_guard lock(resource_mutex);
+    if (dropped_resources.empty())
+        return;
+    PendingRelease release{.resources = std::move(dropped_resources)};
+    for (const auto& queue : queues->all_families())
+        release.queue_values.emplace_back(queue->get_submitted_value());
+    pending_kill_resources.emplace_back(std::move(release));
+    dropped_resources.clear();
 }
 
 void Device::wait() const
@@ -34,13 +52,22 @@ void Device::wait() const
 void Device::flush_resources()
 {
     PROFILER_SCOPE(FlushResources);
-    while (!pending_kill_resources[current_image].empty())
+    const auto families = queues->all_families();
+    while (true)
     {
         std::vector<std::shared_ptr<DeviceResource>> resources_copy;
         {
             std::lock_guard lock(resource_mutex);
-            resources_copy = std::move(pending_kill_resources[current_image]);
+            if (pending_kill_resources.empty())
+                return;
+            const PendingRelease& oldest = pending_kill_resources.front();
+            for (size_t i = 0; i < families.size(); ++i)
+                if (!families[i]->is_complete(oldest.queue_values[i]))
+                    return;
+            resources_copy = std::move(pending_kill_resources.front().resources);
+            pending_kill_resources.pop_front();
         }
+        // Destroyed outside of the lock : resources can drop other resources
         resources_copy.clear();
     }
 }
@@ -88,15 +115,19 @@ Device::Device(const GfxConfig& in_config, const std::weak_ptr<Instance>& in_ins
     VkPhysicalDeviceFeatures deviceFeatures{
         .fillModeNonSolid = true,
         .samplerAnisotropy = true,
+        .shaderSampledImageArrayDynamicIndexing = true,
         .shaderInt16 = true,
     };
 
     VkPhysicalDeviceVulkan12Features device_features_12{
         .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
         .shaderFloat16 = true,
+        .descriptorBindingSampledImageUpdateAfterBind = true,
+        .descriptorBindingUpdateUnusedWhilePending = true,
         .descriptorBindingPartiallyBound = true,
         .descriptorBindingVariableDescriptorCount = true,
         .runtimeDescriptorArray = true,
+        .timelineSemaphore = true,
     };
 
     VkDeviceCreateInfo createInfo{
@@ -139,8 +170,11 @@ std::shared_ptr<Device> Device::create(const GfxConfig& config, const std::weak_
     for (const auto& queue : device->queues->all_families())
         queue->init_queue(device->weak_from_this());
 
-    device->pending_kill_resources.resize(device->image_count, {});
-    device->descriptor_pool = DescriptorPool::create(device);
+    device->descriptor_pool     = DescriptorPool::create(device);
+    device->upload_queue        = UploadQueue::create(device, config.staging_ring_size);
+    device->transient_allocator = TransientAllocator::create(device, config.transient_frame_size);
+    device->bindless_table      = BindlessTable::create(device, config.bindless_texture_count, config.bindless_sampler_count);
+    device->pipeline_cache      = PipelineCache::create(device, config.pipeline_cache_path, config.pipeline_cache_interval);
     return device;
 }
 
@@ -164,6 +198,18 @@ const std::vector<const char*>& Device::get_device_extensions()
     return device_extensions;
 }
 
+BufferArena& Device::get_buffer_arena(EBufferUsage usage, size_t stride)
+{
+    std::lock_guard lock(arena_mutex);
+    auto&           arena = buffer_arenas[{usage, stride}];
+    if (!arena)
+    {
+        const auto block_element_count = static_cast<uint32_t>(std::max(config.buffer_arena_block_size / stride, size_t{1}));
+        arena                          = BufferArena::create(std::format("{}_arena_{}", usage == EBufferUsage::INDEX_DATA ? "index" : "vertex", stride), weak_from_this(), usage, stride, block_element_count);
+    }
+    return *arena;
+}
+
 std::weak_ptr<VkRendererPass> Device::declare_render_pass(const RenderPassKey& key, const RenderPassGenericId& name)
 {
     registered_render_passes.emplace(key.render_pass_ref.generic_id(), ankerl::unordered_dense::set<RenderPassRef>{}).first->second.insert(key.render_pass_ref);
@@ -191,12 +237,19 @@ std::weak_ptr<VkRendererPass> Device::get_render_pass(const RenderPassGenericId&
 void Device::destroy_resources()
 {
     wait();
-    pending_kill_resources.clear();
+    pipeline_cache->save();
     render_passes.clear();
     render_passes_named.clear();
+    buffer_arenas.clear();
+    transient_allocator = nullptr;
+    bindless_table      = nullptr;
+    pipeline_cache      = nullptr;
+    upload_queue        = nullptr;
+    queues              = nullptr;
+    // The device is idle : the resources dropped above and during the previous frames are released at once. The pending ones first, as they can
+    // drop other resources.
     pending_kill_resources.clear();
-    queues = nullptr;
-    pending_kill_resources.clear();
+    dropped_resources.clear();
     descriptor_pool = nullptr;
 
     VmaTotalStatistics stats;
@@ -205,6 +258,5 @@ void Device::destroy_resources()
         LOG_ERROR("{} allocation were not destroyed", stats.total.statistics.allocationCount);
 
     vmaDestroyAllocator(allocator->allocator);
-    pending_kill_resources.clear();
 }
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -3,7 +3,6 @@
 #include "gfx/renderer/instance/render_pass_instance.hpp"
 #include "gfx/vulkan/command_buffer.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
 #include "gfx/vulkan/image_view.hpp"
 #include "gfx/vulkan/vk_render_pass.hpp"
 #include "jobsys/job_sys.hpp"
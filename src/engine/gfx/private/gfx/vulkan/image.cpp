@@ -1,8 +1,7 @@
 #include "gfx/vulkan/image.hpp"
 
-#include "gfx/vulkan/command_buffer.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
+#include "gfx/vulkan/upload_queue.hpp"
 #include "gfx/vulkan/vk_check.hpp"
 #include "gfx/vulkan/vk_wrap.hpp"
 
@@ -12,6 +11,10 @@ namespace Eng::Gfx
 {
 VkImageUsageFlags vk_usage(const ImageParameter& texture_parameters)
 {
+    // Transient attachments can't have any other usage
+    if (texture_parameters.transient_attachment)
+        return VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | (is_depth_format(texture_parameters.format) ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT);
+
     VkImageUsageFlags usage_flags = 0;
     if (static_cast<int>(texture_parameters.transfer_capabilities) & static_cast<int>(ETextureTransferCapabilities::CopySource) || texture_parameters.generate_mips.does_generates())
         usage_flags |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
@@ -124,8 +127,7 @@ void Image::set_data(glm::uvec2 new_size, const std::vector<BufferData>& mips)
     case EBufferType::IMMUTABLE:
         LOG_FATAL("Cannot update immutable image !!")
     case EBufferType::STATIC:
-        device.lock()->wait();
-        images[0]->set_data(mips);
+        images[0]->set_data(mips, true);
         images = {nullptr};
         break;
     case EBufferType::DYNAMIC:
@@ -179,6 +181,13 @@ Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> i
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
 
+    if (!params.bind_memory)
+    {
+        VK_CHECK(vkCreateImage(device().lock()->raw(), &image_create_infos, nullptr, &ptr), "failed to create image")
+        device().lock()->debug_set_object_name(name(), ptr);
+        return;
+    }
+
     constexpr VmaAllocationCreateInfo vma_allocation{
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
     };
@@ -192,66 +201,110 @@ Image::ImageResource::ImageResource(std::string in_name, std::weak_ptr<Device> i
 
 Image::ImageResource::~ImageResource()
 {
-    vmaDestroyImage(device().lock()->get_allocator().allocator, ptr, allocation->allocation);
+    if (allocation)
+        vmaDestroyImage(device().lock()->get_allocator().allocator, ptr, allocation->allocation);
+    else
+        vkDestroyImage(device().lock()->raw(), ptr, nullptr);
 }
 
-void Image::ImageResource::set_data(const std::vector<BufferData>& mips)
+void Image::ImageResource::set_data(const std::vector<BufferData>& mips, bool b_wait_frames_in_flight)
 {
-    std::vector<std::shared_ptr<Buffer>> transfer_buffers;
-
     assert(mip_count == mips.size() || generate_mips.does_generates());
 
-    for (const auto& mip : mips)
-        transfer_buffers.emplace_back(Buffer::create(name() + "_transfer_buffer", device(), Buffer::CreateInfos{.usage = EBufferUsage::TRANSFER_MEMORY}, mip));
-
-    auto command_buffer = CommandBuffer::create(name() + "_transfer_cmd1", device(), QueueSpecialization::Transfer);
-
-    command_buffer->begin(true);
-
-    set_image_layout(*command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    uint32_t mipWidth  = res.x;
-    uint32_t mipHeight = res.y;
-    for (uint32_t mip = 0; mip < transfer_buffers.size(); ++mip)
-    {
-        const VkBufferImageCopy region = {
-            .bufferOffset = 0,
-            .bufferRowLength = 0,
-            .bufferImageHeight = 0,
-            .imageSubresource =
+    // The previous upload released the image to the graphic queue : it is acquired back, discarding its content
+    const UploadToken previous_upload = data_update_token;
+    data_update_token                 = device().lock()->get_upload_queue().upload(
+        mips,
+        [&](const UploadQueue::Commands& commands)
+        {
+            if (previous_upload)
             {
-                .aspectMask = is_depth ? static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_DEPTH_BIT) : static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_COLOR_BIT),
-                .mipLevel = mip,
-                .baseArrayLayer = 0,
-                .layerCount = 1,
-            },
-            .imageOffset = {0, 0, 0},
-            .imageExtent = {mipWidth, mipHeight, depth},
-        };
-
-        vkCmdCopyBufferToImage(command_buffer->raw(), transfer_buffers[mip]->raw_current(), ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
-        if (mipWidth > 1)
-            mipWidth /= 2;
-        if (mipHeight > 1)
-            mipHeight /= 2;
-    }
-    command_buffer->end();
-
-    const auto fence = Fence::create(name() + "_fence", device());
-    command_buffer->submit({}, &*fence);
-    fence->wait();
-
-    command_buffer = nullptr;
-    command_buffer = CommandBuffer::create(name() + "_transfer_cmd2", device(), QueueSpecialization::Graphic);
-    command_buffer->begin(true);
-    if (generate_mips.does_generates())
-        generate_mipmaps(mip_count, *command_buffer);
-    set_image_layout(*command_buffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    command_buffer->end();
-    command_buffer->submit({}, &*fence);
-    fence->wait();
+                commands.acquire_from_graphic(
+                    VkImageMemoryBarrier{
+                        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                        .image = ptr,
+                        .subresourceRange =
+                        VkImageSubresourceRange{
+                            .aspectMask = is_depth ? static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_DEPTH_BIT) : static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_COLOR_BIT),
+                            .baseMipLevel = 0,
+                            .levelCount = mip_count,
+                            .baseArrayLayer = 0,
+                            .layerCount = layer_cout,
+                        },
+                    },
+                    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+                image_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            }
+            else
+            {
+                image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+                set_image_layout(commands.transfer(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            }
+            uint32_t mipWidth  = res.x;
+            uint32_t mipHeight = res.y;
+            for (uint32_t mip = 0; mip < commands.offsets.size(); ++mip)
+            {
+                const VkBufferImageCopy region = {
+                    .bufferOffset = commands.offsets[mip],
+                    .bufferRowLength = 0,
+                    .bufferImageHeight = 0,
+                    .imageSubresource =
+                    {
+                        .aspectMask = is_depth ? static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_DEPTH_BIT) : static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_COLOR_BIT),
+                        .mipLevel = mip,
+                        .baseArrayLayer = 0,
+                        .layerCount = 1,
+                    },
+                    .imageOffset = {0, 0, 0},
+                    .imageExtent = {mipWidth, mipHeight, depth},
+                };
+
+                vkCmdCopyBufferToImage(commands.transfer(), commands.staging_buffer, ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+                if (mipWidth > 1)
+                    mipWidth /= 2;
+                if (mipHeight > 1)
+                    mipHeight /= 2;
+            }
+
+            // Blits need the graphic queue : the mips are generated once the image is acquired
+            const VkImageLayout release_layout = generate_mips.does_generates() ? VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            commands.release_to_graphic(
+                VkImageMemoryBarrier{
+                    .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+                    .oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    .newLayout = release_layout,
+                    .image = ptr,
+                    .subresourceRange =
+                    VkImageSubresourceRange{
+                        .aspectMask = is_depth ? static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_DEPTH_BIT) : static_cast<VkImageAspectFlags>(VK_IMAGE_ASPECT_COLOR_BIT),
+                        .baseMipLevel = 0,
+                        .levelCount = mip_count,
+                        .baseArrayLayer = 0,
+                        .layerCount = layer_cout,
+                    },
+                },
+                generate_mips.does_generates() ? VK_PIPELINE_STAGE_TRANSFER_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                generate_mips.does_generates() ? VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT);
+            image_layout = release_layout;
+
+            if (generate_mips.does_generates())
+            {
+                generate_mipmaps(mip_count, commands.graphic());
+                set_image_layout(commands.graphic(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+            }
+        },
+        b_wait_frames_in_flight, previous_upload);
+}
+
+void Image::ImageResource::wait_data_upload() const
+{
+    if (data_update_token)
+        device().lock()->get_upload_queue().wait(data_update_token);
 }
 
-void Image::ImageResource::set_image_layout(const CommandBuffer& command_buffer, VkImageLayout new_layout)
+void Image::ImageResource::set_image_layout(VkCommandBuffer command_buffer, VkImageLayout new_layout)
 {
     VkImageMemoryBarrier barrier = VkImageMemoryBarrier{
         .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
@@ -294,10 +347,10 @@ void Image::ImageResource::set_image_layout(const CommandBuffer& command_buffer,
     }
 
     image_layout = new_layout;
-    vkCmdPipelineBarrier(command_buffer.raw(), source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    vkCmdPipelineBarrier(command_buffer, source_stage, destination_stage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-void Image::ImageResource::generate_mipmaps(uint32_t mipLevels, const CommandBuffer& command_buffer) const
+void Image::ImageResource::generate_mipmaps(uint32_t mipLevels, VkCommandBuffer command_buffer) const
 {
     VkFormatProperties formatProperties;
     vkGetPhysicalDeviceFormatProperties(device().lock()->get_physical_device().raw(), format, &formatProperties);
@@ -325,7 +378,7 @@ void Image::ImageResource::generate_mipmaps(uint32_t mipLevels, const CommandBuf
         barrier.srcAccessMask                 = VK_ACCESS_TRANSFER_WRITE_BIT;
         barrier.dstAccessMask                 = VK_ACCESS_TRANSFER_READ_BIT;
 
-        vkCmdPipelineBarrier(command_buffer.raw(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
         VkImageBlit blit{};
         blit.srcOffsets[0]                 = {0, 0, 0};
@@ -341,14 +394,14 @@ void Image::ImageResource::generate_mipmaps(uint32_t mipLevels, const CommandBuf
         blit.dstSubresource.baseArrayLayer = 0;
         blit.dstSubresource.layerCount     = 1;
 
-        vkCmdBlitImage(command_buffer.raw(), ptr, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+        vkCmdBlitImage(command_buffer, ptr, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, ptr, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
 
         barrier.oldLayout     = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
         barrier.newLayout     = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
         barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
         barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
 
-        vkCmdPipelineBarrier(command_buffer.raw(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        vkCmdPipelineBarrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 
         if (mipWidth > 1)
             mipWidth /= 2;
@@ -22,14 +22,8 @@ ImageView::ImageView(std::string in_name, std::weak_ptr<Device> in_device, std::
 
 ImageView::~ImageView()
 {
-    if (views.size() != 1)
-    {
-        for (size_t i = 0; i < views.size(); ++i)
-            device.lock()->drop_resource(views[i], i);
-    }
-    else
-        for (const auto& resource : views)
-            device.lock()->drop_resource(resource);
+    for (const auto& resource : views)
+        device.lock()->drop_resource(resource);
 }
 
 VkImageView ImageView::raw_current() const
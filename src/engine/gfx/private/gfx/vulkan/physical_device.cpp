@@ -115,6 +115,13 @@ std::string PhysicalDevice::get_device_name() const
     return deviceProperties.deviceName;
 }
 
+VkPhysicalDeviceProperties PhysicalDevice::get_properties() const
+{
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(ptr, &deviceProperties);
+    return deviceProperties;
+}
+
 bool PhysicalDevice::check_extension_support()
 {
     uint32_t extensionCount;
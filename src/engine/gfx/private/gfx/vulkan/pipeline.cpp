@@ -4,6 +4,7 @@
 #include "gfx_types/pipeline.hpp"
 
 #include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/pipeline_cache.hpp"
 #include "gfx/vulkan/pipeline_layout.hpp"
 #include "gfx/vulkan/shader_module.hpp"
 #include "gfx/vulkan/vk_check.hpp"
@@ -227,7 +228,7 @@ Pipeline::Pipeline(std::string in_name, std::weak_ptr<Device> in_device, const s
         .basePipelineIndex = -1,
     };
 
-    VK_CHECK(vkCreateGraphicsPipelines(device().lock()->raw(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &ptr), "Failed to create material graphic pipeline")
+    VK_CHECK(vkCreateGraphicsPipelines(device().lock()->raw(), device().lock()->get_pipeline_cache().raw(), 1, &pipelineInfo, nullptr, &ptr), "Failed to create material graphic pipeline")
     device().lock()->debug_set_object_name(name(), ptr);
 }
 
@@ -0,0 +1,176 @@
+#include "gfx/vulkan/pipeline_cache.hpp"
+
+#include "logger.hpp"
+#include "profiler.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+
+#include <cstring>
+#include <fstream>
+
+namespace Eng::Gfx
+{
+// Written before the driver data : the driver only checks its own header, which does not include the driver version
+struct PipelineCacheHeader
+{
+    static constexpr uint32_t MAGIC   = 0x43504B56; // "VKPC"
+    static constexpr uint32_t VERSION = 1;
+
+    uint32_t magic          = MAGIC;
+    uint32_t version        = VERSION;
+    uint32_t vendor_id      = 0;
+    uint32_t device_id      = 0;
+    uint32_t driver_version = 0;
+    uint8_t  uuid[VK_UUID_SIZE]{};
+    uint64_t data_size = 0;
+    uint64_t data_hash = 0;
+
+    static PipelineCacheHeader from_device(const Device& device)
+    {
+        const auto          properties = device.get_physical_device().get_properties();
+        PipelineCacheHeader header{
+            .vendor_id = properties.vendorID,
+            .device_id = properties.deviceID,
+            .driver_version = properties.driverVersion,
+        };
+        std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        return header;
+    }
+
+    bool is_compatible(const PipelineCacheHeader& other) const
+    {
+        return magic == other.magic && version == other.version && vendor_id == other.vendor_id && device_id == other.device_id && driver_version == other.driver_version &&
+               std::memcmp(uuid, other.uuid, VK_UUID_SIZE) == 0;
+    }
+};
+
+// FNV-1a, detects truncated or corrupted files
+static uint64_t hash_data(const std::vector<uint8_t>& data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (const uint8_t byte : data)
+        hash = (hash ^ byte) * 0x100000001b3;
+    return hash;
+}
+
+PipelineCache::PipelineCache(std::weak_ptr<Device> in_device, std::filesystem::path in_path, double in_save_interval)
+    : device(std::move(in_device)), path(std::move(in_path)), save_interval(in_save_interval), last_save(std::chrono::steady_clock::now())
+{
+    PROFILER_SCOPE(LoadPipelineCache);
+    const auto data = load();
+    saved_hash      = data.empty() ? 0 : hash_data(data);
+
+    const VkPipelineCacheCreateInfo create_infos{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.data(),
+    };
+    const auto device_ptr = device.lock();
+    VK_CHECK(vkCreatePipelineCache(device_ptr->raw(), &create_infos, nullptr, &ptr), "Failed to create pipeline cache")
+    device_ptr->debug_set_object_name("pipeline_cache", ptr);
+}
+
+PipelineCache::~PipelineCache()
+{
+    if (save_job)
+        save_job->await();
+    vkDestroyPipelineCache(device.lock()->raw(), ptr, nullptr);
+}
+
+std::vector<uint8_t> PipelineCache::load() const
+{
+    if (path.empty() || !exists(path))
+        return {};
+
+    std::ifstream       file(path, std::ios::binary);
+    PipelineCacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(PipelineCacheHeader)))
+    {
+        LOG_WARNING("Ignoring pipeline cache '{}' : invalid header", path.string());
+        return {};
+    }
+    if (!header.is_compatible(PipelineCacheHeader::from_device(*device.lock())))
+    {
+        LOG_INFO("Ignoring pipeline cache '{}' : it was built for another device or driver", path.string());
+        return {};
+    }
+
+    std::vector<uint8_t> data(header.data_size);
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size())) || hash_data(data) != header.data_hash)
+    {
+        LOG_WARNING("Ignoring pipeline cache '{}' : corrupted data", path.string());
+        return {};
+    }
+    LOG_INFO("Loaded pipeline cache '{}' ({} bytes)", path.string(), data.size());
+    return data;
+}
+
+void PipelineCache::save()
+{
+    if (path.empty())
+        return;
+
+    PROFILER_SCOPE(SavePipelineCache);
+    std::lock_guard lock(cache_mutex);
+    const auto      device_ptr = device.lock();
+
+    // Other threads may add pipelines between the two calls
+    std::vector<uint8_t> data;
+    VkResult             result;
+    do
+    {
+        size_t data_size = 0;
+        VK_CHECK(vkGetPipelineCacheData(device_ptr->raw(), ptr, &data_size, nullptr), "Failed to get pipeline cache size")
+        data.resize(data_size);
+        result = vkGetPipelineCacheData(device_ptr->raw(), ptr, &data_size, data.data());
+        data.resize(data_size);
+    } while (result == VK_INCOMPLETE);
+    VK_CHECK(result, "Failed to get pipeline cache data")
+
+    // The entries replaced by the driver can keep the same total size : the content is compared instead
+    const uint64_t data_hash = hash_data(data);
+    if (data.empty() || data_hash == saved_hash)
+        return;
+
+    auto header      = PipelineCacheHeader::from_device(*device_ptr);
+    header.data_size = data.size();
+    header.data_hash = data_hash;
+
+    // Written next to the destination then renamed, so a crash while saving never leaves a partial file
+    if (path.has_parent_path())
+        create_directories(path.parent_path());
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(PipelineCacheHeader));
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file)
+        {
+            LOG_ERROR("Failed to write pipeline cache '{}'", tmp_path.string());
+            return;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tmp_path, path, error);
+    if (error)
+    {
+        LOG_ERROR("Failed to write pipeline cache '{}' : {}", path.string(), error.message());
+        return;
+    }
+    saved_hash = data_hash;
+}
+
+void PipelineCache::next_frame()
+{
+    // Reading, hashing and writing a large cache would stall the frame
+    if (std::chrono::steady_clock::now() - last_save < save_interval || (save_job && !save_job->finished()))
+        return;
+    last_save = std::chrono::steady_clock::now();
+    save_job  = JobSystem::get().schedule(
+        [this]
+        {
+            save();
+        });
+}
+} // namespace Eng::Gfx
@@ -1,6 +1,7 @@
 #include "gfx/vulkan/pipeline_layout.hpp"
 
 #include "logger.hpp"
+#include "gfx/vulkan/bindless_table.hpp"
 #include "gfx/vulkan/descriptor_pool.hpp"
 #include "gfx/vulkan/device.hpp"
 #include "gfx/vulkan/shader_module.hpp"
@@ -39,6 +40,21 @@ static VkDescriptorType vk_descriptor_type(EBindingType type)
     }
 }
 
+bool PipelineLayout::has_binding(const std::string& binding_name) const
+{
+    for (const auto& binding : descriptor_bindings)
+        if (binding.name == binding_name)
+            return true;
+    return false;
+}
+
+std::optional<uint32_t> PipelineLayout::get_push_constant_offset(const std::string& field_name) const
+{
+    if (auto found = push_constant_fields.find(field_name); found != push_constant_fields.end())
+        return found->second;
+    return {};
+}
+
 PipelineLayout::~PipelineLayout()
 {
     vkDestroyDescriptorSetLayout(device().lock()->raw(), descriptor_layout, nullptr);
@@ -50,12 +66,31 @@ PipelineLayout::PipelineLayout(std::string in_name, std::weak_ptr<Device> in_dev
     std::vector<VkDescriptorSetLayoutBinding> bindings;
     std::vector<VkDescriptorBindingFlags>     flags{};
     bool                                      bindless = false;
+
+    // Single storage buffers take dynamic offsets, so transient allocations can be bound without updating the descriptors (see TransientAllocator)
+    uint32_t dynamic_buffers_left = device().lock()->get_physical_device().get_properties().limits.maxDescriptorSetStorageBuffersDynamic;
+
+    // Each stage reflects the bindings it uses : the ones shared by several stages are declared once for all of them
+    ankerl::unordered_dense::map<uint32_t, size_t> binding_indices;
     for (const auto& stage : shader_stage)
     {
-        for (const auto& binding : stage->infos().bindings)
+        for (auto binding : stage->infos().bindings)
         {
+            if (auto found = binding_indices.find(binding.binding); found != binding_indices.end())
+            {
+                if (descriptor_bindings[found->second].name != binding.name)
+                    LOG_ERROR("Binding {} is named {} and {} in {}", binding.binding, descriptor_bindings[found->second].name, binding.name, name());
+                bindings[found->second].stageFlags |= static_cast<VkShaderStageFlags>(stage->infos().stage);
+                continue;
+            }
+            binding_indices.emplace(binding.binding, bindings.size());
             if (bindless)
                 LOG_FATAL("Variable sized descriptor {} should be the last one", binding.name);
+            if (binding.type == EBindingType::STORAGE_BUFFER && binding.array_elements == 0 && dynamic_buffers_left > 0)
+            {
+                binding.type = EBindingType::STORAGE_BUFFER_DYNAMIC;
+                --dynamic_buffers_left;
+            }
             descriptor_bindings.push_back(binding);
             bindings.emplace_back(VkDescriptorSetLayoutBinding{
                 .binding = binding.binding,
@@ -91,22 +126,48 @@ PipelineLayout::PipelineLayout(std::string in_name, std::weak_ptr<Device> in_dev
         .pBindings = bindings.data(),
     };
 
+    // Computed once : allocating sets only hashes the layout through this key
+    ankerl::unordered_dense::map<VkDescriptorType, uint32_t> pool_sizes;
+    descriptor_key.hash = bindings.size();
+    for (size_t i = 0; i < bindings.size(); ++i)
+    {
+        const auto& binding = bindings[i];
+        descriptor_key.bindings.emplace_back(DescriptorLayoutKey::Binding{binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags, flags[i]});
+        for (const uint64_t value : {uint64_t{binding.binding}, static_cast<uint64_t>(binding.descriptorType), uint64_t{binding.descriptorCount}, uint64_t{binding.stageFlags}, uint64_t{flags[i]}})
+            descriptor_key.hash = (descriptor_key.hash ^ std::hash<uint64_t>()(value)) * 0x100000001B3ull;
+        // Variable sized arrays are allocated separately
+        if (!(flags[i] & VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT))
+            pool_sizes[binding.descriptorType] += binding.descriptorCount;
+    }
+    for (const auto& [type, count] : pool_sizes)
+        descriptor_key.pool_sizes.emplace_back(type, count);
+
     VK_CHECK(vkCreateDescriptorSetLayout(device().lock()->raw(), &layout_infos, nullptr, &descriptor_layout), "Failed to create descriptor set layout")
     device().lock()->debug_set_object_name(name() + "_set_layout", descriptor_layout);
 
     std::vector<VkPushConstantRange> push_constants = {};
     for (const auto& stage : shader_stage)
+    {
         if (stage->infos().push_constant_size > 0)
             push_constants.emplace_back(VkPushConstantRange{
                 .stageFlags = static_cast<VkShaderStageFlags>(stage->infos().stage),
                 .offset = 0,
                 .size = stage->infos().push_constant_size,
             });
+        push_constant_size = std::max(push_constant_size, stage->infos().push_constant_size);
+        for (const auto& field : stage->infos().push_constant_fields)
+            push_constant_fields.insert(field);
+        b_uses_bindless_table |= stage->infos().b_uses_bindless;
+    }
+
+    std::vector set_layouts = {descriptor_layout};
+    if (b_uses_bindless_table)
+        set_layouts.emplace_back(device().lock()->get_bindless_table().get_layout());
 
     const VkPipelineLayoutCreateInfo pipeline_layout_infos{
         .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-        .setLayoutCount = 1,
-        .pSetLayouts = &descriptor_layout,
+        .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
         .pushConstantRangeCount = static_cast<uint32_t>(push_constants.size()),
         .pPushConstantRanges = push_constants.data(),
     };
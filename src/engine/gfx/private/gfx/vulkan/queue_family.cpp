@@ -8,9 +8,9 @@
 
 #include "gfx/vulkan/command_pool.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
 #include "gfx/vulkan/physical_device.hpp"
 #include "gfx/vulkan/surface.hpp"
+#include "gfx/vulkan/vk_check.hpp"
 
 namespace Eng::Gfx
 {
@@ -149,11 +149,27 @@ QueueFamily::QueueFamily(uint32_t index, VkQueueFlags flags, bool support_presen
 {
 }
 
-void QueueFamily::init_queue(const std::weak_ptr<Device>& device)
+QueueFamily::~QueueFamily()
 {
+    if (timeline != VK_NULL_HANDLE)
+        vkDestroySemaphore(device.lock()->raw(), timeline, nullptr);
+}
+
+void QueueFamily::init_queue(const std::weak_ptr<Device>& in_device)
+{
+    device = in_device;
     vkGetDeviceQueue(device.lock()->raw(), index(), 0, &ptr);
     command_pool = CommandPool::create(name + "_cmd_pool", device, index());
     device.lock()->debug_set_object_name(name, ptr);
+
+    VkSemaphoreTypeCreateInfo timeline_infos{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue = 0,
+    };
+    VkSemaphoreCreateInfo create_infos{.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO, .pNext = &timeline_infos};
+    VK_CHECK(vkCreateSemaphore(device.lock()->raw(), &create_infos, nullptr, &timeline), "Failed to create timeline semaphore")
+    device.lock()->debug_set_object_name(name + "_timeline", timeline);
 }
 
 VkResult QueueFamily::present(const VkPresentInfoKHR& present_infos)
@@ -170,26 +186,87 @@ VkResult QueueFamily::present(const VkPresentInfoKHR& present_infos)
     return result;
 }
 
-VkResult QueueFamily::submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos, const Fence* optional_fence)
+uint64_t QueueFamily::submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos)
+{
+    auto cmds                       = cmd.raw();
+    submit_infos.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_infos.commandBufferCount = 1;
+    submit_infos.pCommandBuffers    = &cmds;
+    return submit_internal(&submit_infos, 1);
+}
+
+uint64_t QueueFamily::submit(const std::vector<VkSubmitInfo>& submit_infos)
+{
+    if (submit_infos.empty())
+        return submitted_value;
+    return submit_internal(submit_infos.data(), static_cast<uint32_t>(submit_infos.size()));
+}
+
+uint64_t QueueFamily::submit_internal(const VkSubmitInfo* submit_infos, uint32_t submit_count)
 {
     std::lock_guard lk(queue_mutex);
     {
         PROFILER_SCOPE(WaitQueueAvailable);
         queue_global_lock->lock_shared();
     }
-    if (optional_fence)
+
+    // Append the timeline signal to the last batch. Binary semaphores ignore their value.
+    std::vector<VkSubmitInfo> batches(submit_infos, submit_infos + submit_count);
+    VkSubmitInfo&             last_batch = batches.back();
+    const uint64_t            value      = submitted_value + 1;
+    std::vector<VkSemaphore>  signal_semaphores(last_batch.pSignalSemaphores, last_batch.pSignalSemaphores + last_batch.signalSemaphoreCount);
+    std::vector<uint64_t>     signal_values(signal_semaphores.size(), 0);
+    VkTimelineSemaphoreSubmitInfo timeline_infos{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext = last_batch.pNext,
+    };
+
+    // Merge the timeline values given by the caller (waits on the timeline of other queues)
+    if (last_batch.pNext && static_cast<const VkBaseInStructure*>(last_batch.pNext)->sType == VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO)
     {
-        PROFILER_SCOPE(ResetFence);
-        optional_fence->reset();
+        const auto* caller_infos               = static_cast<const VkTimelineSemaphoreSubmitInfo*>(last_batch.pNext);
+        timeline_infos.pNext                   = caller_infos->pNext;
+        timeline_infos.waitSemaphoreValueCount = caller_infos->waitSemaphoreValueCount;
+        timeline_infos.pWaitSemaphoreValues    = caller_infos->pWaitSemaphoreValues;
+        for (uint32_t i = 0; i < caller_infos->signalSemaphoreValueCount && i < signal_values.size(); ++i)
+            signal_values[i] = caller_infos->pSignalSemaphoreValues[i];
     }
-    auto cmds                       = cmd.raw();
-    submit_infos.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_infos.commandBufferCount = 1;
-    submit_infos.pCommandBuffers    = &cmds;
+    signal_semaphores.emplace_back(timeline);
+    signal_values.emplace_back(value);
+    timeline_infos.signalSemaphoreValueCount = static_cast<uint32_t>(signal_values.size());
+    timeline_infos.pSignalSemaphoreValues    = signal_values.data();
+    last_batch.pNext                = &timeline_infos;
+    last_batch.signalSemaphoreCount = static_cast<uint32_t>(signal_semaphores.size());
+    last_batch.pSignalSemaphores    = signal_semaphores.data();
+
     PROFILER_SCOPE(SubmitQueue);
-    auto result = vkQueueSubmit(ptr, 1, &submit_infos, optional_fence ? optional_fence->raw() : nullptr);
+    PROFILER_COUNTER_ADD(QueueSubmits, 1);
+    const VkResult result = vkQueueSubmit(ptr, submit_count, batches.data(), VK_NULL_HANDLE);
     queue_global_lock->unlock_shared();
-    return result;
+    VK_CHECK(result, "Failed to submit queue {}", name)
+    submitted_value = value;
+    return value;
+}
+
+bool QueueFamily::is_complete(uint64_t value) const
+{
+    uint64_t completed_value = 0;
+    VK_CHECK(vkGetSemaphoreCounterValue(device.lock()->raw(), timeline, &completed_value), "Failed to read timeline semaphore")
+    return completed_value >= value;
+}
+
+void QueueFamily::wait(uint64_t value) const
+{
+    if (value == 0)
+        return;
+    PROFILER_SCOPE(WaitQueueTimeline);
+    const VkSemaphoreWaitInfo wait_infos{
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+        .semaphoreCount = 1,
+        .pSemaphores = &timeline,
+        .pValues = &value,
+    };
+    VK_CHECK(vkWaitSemaphores(device.lock()->raw(), &wait_infos, UINT64_MAX), "Failed to wait timeline semaphore")
 }
 
 auto Queues::find_best_suited_queue_family(const ankerl::unordered_dense::map<uint32_t, std::shared_ptr<QueueFamily>>& available, VkQueueFlags required_flags, bool require_present,
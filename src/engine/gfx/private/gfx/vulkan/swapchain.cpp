@@ -3,7 +3,6 @@
 #include "gfx/renderer/definition/renderer.hpp"
 #include "gfx/ui/ImGuiWrapper.hpp"
 #include "gfx/vulkan/device.hpp"
-#include "gfx/vulkan/fence.hpp"
 #include "gfx/vulkan/framebuffer.hpp"
 #include "gfx/vulkan/image_view.hpp"
 #include "gfx/vulkan/queue_family.hpp"
@@ -146,10 +145,6 @@ void Swapchain::create_or_recreate()
     for (uint32_t i = 0; i < device_ptr->get_image_count(); ++i)
         image_available_semaphores.emplace_back(Semaphore::create(get_definition().render_pass_ref.to_string() + "_sem_#" + std::to_string(i), device()));
 
-    render_finished_fences.resize(get_image_count());
-    for (auto& fence : render_finished_fences)
-        fence = Fence::create(std::format("Render fence semaphore : {}", get_definition().render_pass_ref), device());
-
     if (get_definition().resize_callback_ptr)
         LOG_FATAL("Resize callback can't be used with swapchain draw pass");
     create_or_resize(extent, extent, true);
@@ -182,10 +177,10 @@ bool Swapchain::render_internal()
     const auto device_reference = device().lock();
     uint8_t    current_frame    = device().lock()->get_current_image();
 
-    if (current_frame < in_flight_fences.size() && in_flight_fences[current_frame])
+    if (current_frame < in_flight_values.size())
     {
         PROFILER_SCOPE(WaitSwapchainImageAvailable);
-        in_flight_fences[current_frame]->wait();
+        device_reference->get_queues().get_queue(QueueSpecialization::Graphic)->wait(in_flight_values[current_frame]);
     }
     device().lock()->flush_resources();
     reset_for_next_frame();
@@ -199,11 +194,9 @@ bool Swapchain::render_internal()
         VK_CHECK(acquire_result, "Failed to acquire next swapchain image")
     }
 
-    if (current_frame >= in_flight_fences.size())
-        in_flight_fences.resize(current_frame + 1, nullptr);
-    in_flight_fences[current_frame] = get_render_finished_fence(current_frame);
-
-    render(static_cast<uint8_t>(swapchain_image), current_frame);
+    if (current_frame >= in_flight_values.size())
+        in_flight_values.resize(current_frame + 1, 0);
+    in_flight_values[current_frame] = render(static_cast<uint8_t>(swapchain_image), current_frame);
 
     // Submit to present queue
     const auto             render_finished_semaphore = get_render_finished_semaphore();
@@ -229,7 +222,7 @@ bool Swapchain::render_internal()
 void Swapchain::destroy()
 {
     device().lock()->wait();
-    in_flight_fences.clear();
+    in_flight_values.clear();
     image_view = nullptr;
 
     if (ptr != VK_NULL_HANDLE)
@@ -0,0 +1,129 @@
+#include "gfx/vulkan/transient_allocator.hpp"
+
+#include "profiler.hpp"
+#include "gfx/vulkan/buffer.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+#include "gfx/vulkan/vk_wrap.hpp"
+
+#include <bit>
+#include <vk_mem_alloc.h>
+
+namespace Eng::Gfx
+{
+// Host visible and coherent buffer mapped during its whole lifetime
+class TransientBlock : public DeviceResource
+{
+public:
+    TransientBlock(std::string name, std::weak_ptr<Device> device, VkDeviceSize in_size) : DeviceResource(std::move(name), std::move(device)), size(in_size)
+    {
+        const VkBufferCreateInfo buffer_create_info = {
+            .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size        = size,
+            .usage       = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+        const VmaAllocationCreateInfo allocation_infos = {
+            .flags         = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage         = VMA_MEMORY_USAGE_AUTO,
+            .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+        };
+        VmaAllocationInfo infos;
+        VK_CHECK(vmaCreateBuffer(device().lock()->get_allocator().allocator, &buffer_create_info, &allocation_infos, &ptr, &allocation, &infos), "Failed to create transient buffer {}", this->name())
+        data = static_cast<uint8_t*>(infos.pMappedData);
+        device().lock()->debug_set_object_name(this->name(), ptr);
+    }
+
+    ~TransientBlock() override
+    {
+        vmaDestroyBuffer(device().lock()->get_allocator().allocator, ptr, allocation);
+    }
+
+    VkBuffer      ptr        = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    uint8_t*      data       = nullptr;
+    VkDeviceSize  size       = 0;
+};
+
+TransientAllocator::TransientAllocator(std::weak_ptr<Device> in_device, VkDeviceSize in_frame_size) : device(std::move(in_device))
+{
+    const auto device_ptr = device.lock();
+    const auto limits     = device_ptr->get_physical_device().get_properties().limits;
+    alignment             = std::max({limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, VkDeviceSize{16}});
+    frame_size            = std::bit_ceil(std::max(in_frame_size, alignment));
+    block                 = std::make_shared<TransientBlock>("transient_buffer", device, frame_size * device_ptr->get_image_count());
+}
+
+TransientAllocator::~TransientAllocator()
+{
+    const auto device_ptr = device.lock();
+    device_ptr->drop_resource(block);
+    for (const auto& overflow : overflow_blocks)
+        device_ptr->drop_resource(overflow);
+}
+
+TransientBuffer TransientAllocator::allocate(VkDeviceSize size)
+{
+    size                      = std::bit_ceil(std::max(size, alignment));
+    const VkDeviceSize offset = head.fetch_add(size);
+    if (offset + size > frame_size)
+        return allocate_overflow(size);
+    return TransientBuffer{
+        .buffer = block->ptr,
+        .offset = region_start + offset,
+        .size   = size,
+        .data   = block->data + region_start + offset,
+    };
+}
+
+TransientBuffer TransientAllocator::write(const BufferData& data)
+{
+    const TransientBuffer allocation = allocate(data.get_byte_size());
+    if (data.get_byte_size() > 0)
+        data.copy_to(allocation.data);
+    return allocation;
+}
+
+TransientBuffer TransientAllocator::allocate_overflow(VkDeviceSize size)
+{
+    std::lock_guard lock(overflow_mutex);
+    overflow_bytes += size;
+    if (overflow_blocks.empty() || overflow_head + size > overflow_blocks.back()->size)
+    {
+        overflow_blocks.emplace_back(std::make_shared<TransientBlock>(std::format("transient_overflow_#{}", overflow_blocks.size()), device, std::max(frame_size, size)));
+        overflow_head = 0;
+    }
+    const TransientBlock& overflow = *overflow_blocks.back();
+    const VkDeviceSize    offset   = overflow_head;
+    overflow_head += size;
+    return TransientBuffer{
+        .buffer = overflow.ptr,
+        .offset = offset,
+        .size   = size,
+        .data   = overflow.data + offset,
+    };
+}
+
+void TransientAllocator::next_frame(uint8_t image)
+{
+    const auto device_ptr = device.lock();
+    if (overflow_bytes > 0)
+    {
+        PROFILER_SCOPE(GrowTransientBuffer);
+        // The frames in flight still use the previous buffer : it is released once they complete
+        const VkDeviceSize required_size = frame_size + overflow_bytes;
+        while (frame_size < required_size)
+            frame_size *= 2;
+        LOG_INFO("Transient memory grew to {:.1f}MB per frame", static_cast<double>(frame_size) / 1048576.0);
+        device_ptr->drop_resource(block);
+        block = std::make_shared<TransientBlock>("transient_buffer", device, frame_size * device_ptr->get_image_count());
+        overflow_bytes = 0;
+    }
+    for (const auto& overflow : overflow_blocks)
+        device_ptr->drop_resource(overflow);
+    overflow_blocks.clear();
+    overflow_head = 0;
+    region_start  = image * frame_size;
+    head          = 0;
+}
+} // namespace Eng::Gfx
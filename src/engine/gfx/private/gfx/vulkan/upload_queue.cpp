@@ -0,0 +1,456 @@
+#include "gfx/vulkan/upload_queue.hpp"
+
+#include "profiler.hpp"
+#include "gfx/vulkan/buffer.hpp"
+#include "gfx/vulkan/device.hpp"
+#include "gfx/vulkan/queue_family.hpp"
+#include "gfx/vulkan/vk_check.hpp"
+#include "gfx/vulkan/vk_wrap.hpp"
+
+#include <cassert>
+#include <vk_mem_alloc.h>
+
+namespace Eng::Gfx
+{
+// Multiple of every texel size, as vkCmdCopyBufferToImage requires the source offset to be
+static constexpr VkDeviceSize staging_alignment = 48;
+
+static VkDeviceSize align_staging(VkDeviceSize size)
+{
+    return (size + staging_alignment - 1) / staging_alignment * staging_alignment;
+}
+
+// Host visible buffer mapped during its whole lifetime
+class StagingBuffer : public DeviceResource
+{
+public:
+    StagingBuffer(std::string name, std::weak_ptr<Device> device, VkDeviceSize size) : DeviceResource(std::move(name), std::move(device))
+    {
+        const VkBufferCreateInfo buffer_create_info = {
+            .sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+            .size        = size,
+            .usage       = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        };
+        const VmaAllocationCreateInfo allocation_infos = {
+            .flags         = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+            .usage         = VMA_MEMORY_USAGE_AUTO,
+            .requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+        };
+        VmaAllocationInfo infos;
+        VK_CHECK(vmaCreateBuffer(device().lock()->get_allocator().allocator, &buffer_create_info, &allocation_infos, &ptr, &allocation, &infos), "Failed to create staging buffer {}", this->name())
+        data = static_cast<uint8_t*>(infos.pMappedData);
+        device().lock()->debug_set_object_name(this->name(), ptr);
+    }
+
+    ~StagingBuffer() override
+    {
+        vmaDestroyBuffer(device().lock()->get_allocator().allocator, ptr, allocation);
+    }
+
+    // Copy the data at the given offsets, and make it visible to the device if the memory is not coherent
+    void write(const std::vector<BufferData>& pieces, const std::vector<VkDeviceSize>& offsets, VkDeviceSize size) const
+    {
+        for (size_t i = 0; i < pieces.size(); ++i)
+            pieces[i].copy_to(data + offsets[i]);
+        VK_CHECK(vmaFlushAllocation(device().lock()->get_allocator().allocator, allocation, offsets.empty() ? 0 : offsets[0], size), "Failed to flush staging buffer {}", name())
+    }
+
+    VkBuffer      ptr        = VK_NULL_HANDLE;
+    VmaAllocation allocation = VK_NULL_HANDLE;
+    uint8_t*      data       = nullptr;
+};
+
+UploadQueue::UploadQueue(std::weak_ptr<Device> in_device, VkDeviceSize staging_size) : device(std::move(in_device)), capacity(staging_size / staging_alignment * staging_alignment)
+{
+    const auto device_ptr = device.lock();
+    transfer_queue        = device_ptr->get_queues().get_queue(QueueSpecialization::Transfer);
+    graphic_queue         = device_ptr->get_queues().get_queue(QueueSpecialization::Graphic);
+    b_ownership_transfer  = transfer_queue->index() != graphic_queue->index();
+    ring                  = std::make_shared<StagingBuffer>("staging_ring", device, capacity);
+
+    // Recorded from any thread under the queue lock : it owns its pools instead of using the per-thread ones of the queues
+    for (const auto& [queue, pool] : {std::pair{transfer_queue.get(), &transfer_pool}, std::pair{graphic_queue.get(), &graphic_pool}})
+    {
+        const VkCommandPoolCreateInfo create_infos{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+            .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+            .queueFamilyIndex = queue->index(),
+        };
+        VK_CHECK(vkCreateCommandPool(device_ptr->raw(), &create_infos, nullptr, pool), "Failed to create upload command pool")
+        device_ptr->debug_set_object_name("upload_pool_" + std::to_string(queue->index()), *pool);
+    }
+}
+
+UploadQueue::~UploadQueue()
+{
+    // The device is idle : the command buffers are released with the pools
+    vkDestroyCommandPool(device.lock()->raw(), transfer_pool, nullptr);
+    vkDestroyCommandPool(device.lock()->raw(), graphic_pool, nullptr);
+}
+
+VkCommandBuffer UploadQueue::Commands::transfer() const
+{
+    return queue.recording->transfer_commands;
+}
+
+VkCommandBuffer UploadQueue::Commands::graphic() const
+{
+    if (!queue.b_ownership_transfer)
+        return queue.recording->transfer_commands;
+    if (!queue.recording->graphic_commands)
+        queue.recording->graphic_commands = queue.begin_command_buffer(queue.graphic_pool, queue.free_graphic_command_buffers);
+    return queue.recording->graphic_commands;
+}
+
+void UploadQueue::Commands::release_to_graphic(VkBufferMemoryBarrier barrier, VkPipelineStageFlags destination_stages, VkAccessFlags destination_access) const
+{
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (!queue.b_ownership_transfer)
+    {
+        barrier.dstAccessMask       = destination_access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_TRANSFER_BIT, destination_stages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        return;
+    }
+    barrier.dstAccessMask       = 0;
+    barrier.srcQueueFamilyIndex = queue.transfer_queue->index();
+    barrier.dstQueueFamilyIndex = queue.graphic_queue->index();
+    vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = destination_access;
+    vkCmdPipelineBarrier(graphic(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, destination_stages, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void UploadQueue::Commands::release_to_graphic(VkImageMemoryBarrier barrier, VkPipelineStageFlags destination_stages, VkAccessFlags destination_access) const
+{
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    if (!queue.b_ownership_transfer)
+    {
+        barrier.dstAccessMask       = destination_access;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_TRANSFER_BIT, destination_stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+    // The layout transition is declared identically by the release and the acquire
+    barrier.dstAccessMask       = 0;
+    barrier.srcQueueFamilyIndex = queue.transfer_queue->index();
+    barrier.dstQueueFamilyIndex = queue.graphic_queue->index();
+    vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = destination_access;
+    vkCmdPipelineBarrier(graphic(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, destination_stages, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VkCommandBuffer UploadQueue::Commands::release_from_graphic() const
+{
+    if (!queue.recording->release_commands)
+        queue.recording->release_commands = queue.begin_command_buffer(queue.graphic_pool, queue.free_graphic_command_buffers);
+    return queue.recording->release_commands;
+}
+
+void UploadQueue::Commands::acquire_from_graphic(VkBufferMemoryBarrier barrier, VkPipelineStageFlags source_stages) const
+{
+    if (!queue.b_ownership_transfer)
+    {
+        // The previous upload may be recorded in the same batch
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vkCmdPipelineBarrier(transfer(), source_stages | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+        return;
+    }
+    // The graphic queue only read the resource : there is nothing to make available
+    barrier.srcAccessMask       = 0;
+    barrier.dstAccessMask       = 0;
+    barrier.srcQueueFamilyIndex = queue.graphic_queue->index();
+    barrier.dstQueueFamilyIndex = queue.transfer_queue->index();
+    vkCmdPipelineBarrier(release_from_graphic(), source_stages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+void UploadQueue::Commands::acquire_from_graphic(VkImageMemoryBarrier barrier, VkPipelineStageFlags source_stages) const
+{
+    if (!queue.b_ownership_transfer)
+    {
+        barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        vkCmdPipelineBarrier(transfer(), source_stages | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+        return;
+    }
+    // The layout transition is declared identically by the release and the acquire
+    barrier.srcAccessMask       = 0;
+    barrier.dstAccessMask       = 0;
+    barrier.srcQueueFamilyIndex = queue.graphic_queue->index();
+    barrier.dstQueueFamilyIndex = queue.transfer_queue->index();
+    vkCmdPipelineBarrier(release_from_graphic(), source_stages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(transfer(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+UploadToken UploadQueue::upload(const std::vector<BufferData>& data, const RecordCommands& record, bool b_wait_frames_in_flight, const UploadToken& previous_upload)
+{
+    PROFILER_SCOPE(Upload);
+    Commands     commands(*this);
+    VkDeviceSize size = 0;
+    for (const auto& piece : data)
+    {
+        commands.offsets.emplace_back(size);
+        size = align_staging(size + piece.get_byte_size());
+    }
+    PROFILER_COUNTER_ADD(UploadBytes, size);
+
+    // Dedicated buffers are filled before taking the lock
+    std::shared_ptr<StagingBuffer> dedicated;
+    if (size > capacity / 4)
+    {
+        dedicated = std::make_shared<StagingBuffer>("dedicated_staging_buffer", device, size);
+        dedicated->write(data, commands.offsets, size);
+    }
+
+    std::lock_guard lock(queue_mutex);
+    retire_completed_batches();
+
+    // The previous upload releases the resource in the transfer commands of its batch : it is acquired back once the batch is submitted
+    if (b_ownership_transfer && recording && recording->index == previous_upload.batch)
+        submit_batch();
+
+    if (dedicated)
+    {
+        commands.staging_buffer = dedicated->ptr;
+        current_batch().dedicated_buffers.emplace_back(dedicated);
+    }
+    else
+    {
+        std::optional<VkDeviceSize> ring_offset;
+        VkDeviceSize                consumed = 0;
+        while (!(ring_offset = try_allocate(size, consumed)))
+        {
+            PROFILER_SCOPE(WaitStagingRingSpace);
+            // Only the batch being recorded holds the ring
+            if (submitted.empty())
+                submit_batch();
+            assert(!submitted.empty());
+            const Batch& oldest = submitted.front();
+            transfer_queue->wait(oldest.transfer_value);
+            graphic_queue->wait(oldest.graphic_value);
+            retire_completed_batches();
+        }
+        current_batch().ring_bytes += consumed;
+        for (auto& offset : commands.offsets)
+            offset += *ring_offset;
+        ring->write(data, commands.offsets, size);
+        commands.staging_buffer = ring->ptr;
+    }
+
+    Batch& batch = current_batch();
+    if (b_wait_frames_in_flight)
+        batch.graphic_wait_value = graphic_queue->get_submitted_value();
+    record(commands);
+    return {batch.index};
+}
+
+void UploadQueue::flush()
+{
+    std::lock_guard lock(queue_mutex);
+    submit_batch();
+}
+
+bool UploadQueue::is_complete(const UploadToken& token)
+{
+    std::lock_guard lock(queue_mutex);
+    if (recording && recording->index == token.batch)
+        return false;
+    for (const auto& batch : submitted)
+        if (batch.index == token.batch)
+            return is_batch_complete(batch);
+    // Retired batches are complete
+    return true;
+}
+
+void UploadQueue::wait(const UploadToken& token)
+{
+    uint64_t transfer_value = 0;
+    uint64_t graphic_value  = 0;
+    {
+        std::lock_guard lock(queue_mutex);
+        if (recording && recording->index == token.batch)
+            submit_batch();
+        for (const auto& batch : submitted)
+            if (batch.index == token.batch)
+            {
+                transfer_value = batch.transfer_value;
+                graphic_value  = batch.graphic_value;
+            }
+    }
+    PROFILER_SCOPE(WaitUpload);
+    transfer_queue->wait(transfer_value);
+    graphic_queue->wait(graphic_value);
+}
+
+std::optional<VkDeviceSize> UploadQueue::try_allocate(VkDeviceSize size, VkDeviceSize& out_consumed)
+{
+    if (used > 0 && head == tail)
+        return {};
+
+    VkDeviceSize skipped = 0;
+    VkDeviceSize offset  = head;
+    if (head >= tail)
+    {
+        // Wrap, leaving the end of the ring unused
+        if (head + size > capacity)
+        {
+            if (size > tail)
+                return {};
+            skipped = capacity - head;
+            offset  = 0;
+        }
+    }
+    else if (head + size > tail)
+        return {};
+
+    head         = offset + size;
+    out_consumed = skipped + size;
+    used += out_consumed;
+    return offset;
+}
+
+UploadQueue::Batch& UploadQueue::current_batch()
+{
+    if (!recording)
+        recording.emplace(Batch{
+            .index             = next_batch_index++,
+            .transfer_commands = begin_command_buffer(transfer_pool, free_transfer_command_buffers),
+        });
+    return *recording;
+}
+
+VkCommandBuffer UploadQueue::begin_command_buffer(VkCommandPool pool, std::vector<VkCommandBuffer>& free_command_buffers) const
+{
+    VkCommandBuffer command_buffer = VK_NULL_HANDLE;
+    if (!free_command_buffers.empty())
+    {
+        command_buffer = free_command_buffers.back();
+        free_command_buffers.pop_back();
+    }
+    else
+    {
+        const VkCommandBufferAllocateInfo allocate_infos{
+            .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+            .commandPool = pool,
+            .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+            .commandBufferCount = 1,
+        };
+        VK_CHECK(vkAllocateCommandBuffers(device.lock()->raw(), &allocate_infos, &command_buffer), "Failed to allocate upload command buffer")
+    }
+    constexpr VkCommandBufferBeginInfo begin_infos{
+        .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+        .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+    VK_CHECK(vkBeginCommandBuffer(command_buffer, &begin_infos), "Failed to begin upload command buffer")
+    return command_buffer;
+}
+
+void UploadQueue::submit_batch()
+{
+    if (!recording)
+        return;
+    PROFILER_SCOPE(SubmitUploadBatch);
+
+    // The transfer may wait for the frames reading the resources it overwrites
+    const VkSemaphore              graphic_timeline = graphic_queue->get_timeline_semaphore();
+    constexpr VkPipelineStageFlags transfer_stage   = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    VkTimelineSemaphoreSubmitInfo  transfer_timeline_infos{
+        .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .waitSemaphoreValueCount = 1,
+        .pWaitSemaphoreValues = &recording->graphic_wait_value,
+    };
+    // Re-uploaded resources are released by the graphic queue first, after the frames reading them
+    if (recording->release_commands)
+    {
+        VK_CHECK(vkEndCommandBuffer(recording->release_commands), "Failed to end upload command buffer")
+        const VkSubmitInfo release_infos{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &recording->release_commands,
+        };
+        recording->graphic_wait_value = graphic_queue->submit(std::vector{release_infos});
+    }
+
+    VK_CHECK(vkEndCommandBuffer(recording->transfer_commands), "Failed to end upload command buffer")
+    VkSubmitInfo transfer_infos{
+        .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .commandBufferCount = 1,
+        .pCommandBuffers = &recording->transfer_commands,
+    };
+    if (recording->graphic_wait_value != 0)
+    {
+        transfer_infos.pNext              = &transfer_timeline_infos;
+        transfer_infos.waitSemaphoreCount = 1;
+        transfer_infos.pWaitSemaphores    = &graphic_timeline;
+        transfer_infos.pWaitDstStageMask  = &transfer_stage;
+    }
+    recording->transfer_value = transfer_queue->submit(std::vector{transfer_infos});
+
+    // Every later graphic submission comes after the acquisitions
+    if (recording->graphic_commands)
+    {
+        const VkSemaphore              transfer_timeline = transfer_queue->get_timeline_semaphore();
+        constexpr VkPipelineStageFlags acquire_stage     = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        const VkTimelineSemaphoreSubmitInfo graphic_timeline_infos{
+            .sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+            .waitSemaphoreValueCount = 1,
+            .pWaitSemaphoreValues = &recording->transfer_value,
+        };
+        VK_CHECK(vkEndCommandBuffer(recording->graphic_commands), "Failed to end upload command buffer")
+        const VkSubmitInfo graphic_infos{
+            .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+            .pNext = &graphic_timeline_infos,
+            .waitSemaphoreCount = 1,
+            .pWaitSemaphores = &transfer_timeline,
+            .pWaitDstStageMask = &acquire_stage,
+            .commandBufferCount = 1,
+            .pCommandBuffers = &recording->graphic_commands,
+        };
+        recording->graphic_value = graphic_queue->submit(std::vector{graphic_infos});
+    }
+
+    recording->ring_end = head;
+    submitted.emplace_back(std::move(*recording));
+    recording.reset();
+}
+
+bool UploadQueue::is_batch_complete(const Batch& batch) const
+{
+    return transfer_queue->is_complete(batch.transfer_value) && graphic_queue->is_complete(batch.graphic_value);
+}
+
+void UploadQueue::retire_completed_batches()
+{
+    while (!submitted.empty() && is_batch_complete(submitted.front()))
+    {
+        Batch& batch = submitted.front();
+        VK_CHECK(vkResetCommandBuffer(batch.transfer_commands, 0), "Failed to reset upload command buffer")
+        free_transfer_command_buffers.emplace_back(batch.transfer_commands);
+        if (batch.graphic_commands)
+        {
+            VK_CHECK(vkResetCommandBuffer(batch.graphic_commands, 0), "Failed to reset upload command buffer")
+            free_graphic_command_buffers.emplace_back(batch.graphic_commands);
+        }
+        if (batch.release_commands)
+        {
+            VK_CHECK(vkResetCommandBuffer(batch.release_commands, 0), "Failed to reset upload command buffer")
+            free_graphic_command_buffers.emplace_back(batch.release_commands);
+        }
+        tail = batch.ring_end;
+        used -= batch.ring_bytes;
+        submitted.pop_front();
+    }
+}
+} // namespace Eng::Gfx
@@ -27,15 +27,20 @@ VkRendererPass::VkRendererPass(const std::string& in_name, const std::weak_ptr<D
                 .layout     = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
             });
 
+        // Transient attachments are not sampled afterward : keep them in their attachment layout
+        VkImageLayout final_layout = key.b_present ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        if (attachment.b_transient)
+            final_layout = is_depth_format(attachment.color_format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
         attachments.emplace_back(VkAttachmentDescription{
             .format         = static_cast<VkFormat>(attachment.color_format),
             .samples        = VK_SAMPLE_COUNT_1_BIT,
             .loadOp         = attachment.has_clear() ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
-            .storeOp        = VK_ATTACHMENT_STORE_OP_STORE,
+            .storeOp        = attachment.b_transient ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE,
             .stencilLoadOp  = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
             .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
             .initialLayout  = VK_IMAGE_LAYOUT_UNDEFINED,
-            .finalLayout    = key.b_present ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .finalLayout    = final_layout,
         });
     }
 
@@ -13,5 +13,12 @@ class GfxConfig
     bool        allow_integrated_gpus    = false;
     bool        v_sync                   = true;
     uint8_t     swapchain_image_count    = 2;
+    size_t      staging_ring_size        = 64 * 1024 * 1024;           // Host memory shared by the uploads in flight (see UploadQueue)
+    size_t      buffer_arena_block_size  = 64 * 1024 * 1024;           // Size of the shared mesh buffers (see BufferArena)
+    size_t      transient_frame_size     = 4 * 1024 * 1024;            // Initial memory for the data rewritten every frame (see TransientAllocator)
+    uint32_t    bindless_texture_count   = 16384;                      // Capacity of the global texture table (see BindlessTable)
+    uint32_t    bindless_sampler_count   = 256;
+    std::string pipeline_cache_path      = "saved/pipeline_cache.bin"; // Compiled pipelines kept between runs, disabled when empty (see PipelineCache)
+    double      pipeline_cache_interval  = 60.0;                       // Seconds between two saves of the pipeline cache
 };
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <utility>
 
 #include "vulkan/buffer.hpp"
+#include "vulkan/buffer_arena.hpp"
 
 namespace Eng::Gfx
 {
@@ -16,6 +17,10 @@ enum class IndexBufferType
     Uint32
 };
 
+/**
+ * Immutable meshes are ranges of the device buffer arenas (see Device::get_buffer_arena()) : the meshes sharing the same blocks are drawn without
+ * rebinding. The other meshes own their buffers.
+ */
 class Mesh
 {
 public:
@@ -31,6 +36,7 @@ public:
 
     Mesh(Mesh&&) = delete;
     Mesh(Mesh&)  = delete;
+    ~Mesh();
     void reserve_vertices(size_t vertex_count);
     void reserve_indices(size_t index_count, IndexBufferType index_buffer_type);
     void set_vertices(size_t start_vertex, const BufferData& vertex_data);
@@ -38,12 +44,38 @@ public:
 
     Buffer* get_vertices() const
     {
-        return vertex_buffer.get();
+        return vertex_allocation ? &vertex_allocation->get_buffer() : vertex_buffer.get();
     }
 
     Buffer* get_indices() const
     {
-        return index_buffer.get();
+        return index_allocation ? &index_allocation->get_buffer() : index_buffer.get();
+    }
+
+    // Range of the mesh in get_vertices()
+    uint32_t get_first_vertex() const
+    {
+        return vertex_allocation ? vertex_allocation->get_first_element() : 0;
+    }
+
+    uint32_t get_vertex_count() const
+    {
+        if (vertex_allocation)
+            return vertex_allocation->get_element_count();
+        return vertex_buffer ? static_cast<uint32_t>(vertex_buffer->get_element_count()) : 0;
+    }
+
+    // Range of the mesh in get_indices()
+    uint32_t get_first_index() const
+    {
+        return index_allocation ? index_allocation->get_first_element() : 0;
+    }
+
+    uint32_t get_index_count() const
+    {
+        if (index_allocation)
+            return index_allocation->get_element_count();
+        return index_buffer ? static_cast<uint32_t>(index_buffer->get_element_count()) : 0;
     }
 
     const IndexBufferType& get_index_buffer_type() const
@@ -58,12 +90,14 @@ public:
 
 private:
     Mesh(std::string name, const std::weak_ptr<Device>& device, size_t vertex_structure_size, EBufferType buffer_type, const BufferData* vertices = nullptr, const BufferData* indices = nullptr);
-    EBufferType             buffer_type;
-    size_t                  vertex_structure_size = 0;
-    IndexBufferType         index_type;
-    std::weak_ptr<Device>   device;
-    std::shared_ptr<Buffer> vertex_buffer;
-    std::shared_ptr<Buffer> index_buffer;
-    std::string             name;
+    EBufferType                              buffer_type;
+    size_t                                   vertex_structure_size = 0;
+    IndexBufferType                          index_type;
+    std::weak_ptr<Device>                    device;
+    std::shared_ptr<Buffer>                  vertex_buffer;
+    std::shared_ptr<Buffer>                  index_buffer;
+    std::shared_ptr<BufferArena::Allocation> vertex_allocation;
+    std::shared_ptr<BufferArena::Allocation> index_allocation;
+    std::string                              name;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
@@ -52,15 +52,31 @@ public:
         return *this;
     }
 
+    // The attachment is only used inside its render pass and never read by another pass : it is not stored and can live in lazily allocated memory
+    Attachment& transient(bool enabled = true)
+    {
+        b_transient = enabled;
+        return *this;
+    }
+
+    // The attachment is sampled outside of the render graph (UI, other graphs) : its memory is never shared with other attachments
+    Attachment& read_outside_graph(bool enabled = true)
+    {
+        b_read_outside_graph = enabled;
+        return *this;
+    }
+
     bool has_clear() const
     {
         return clear_color_value.has_value() || clear_depth_value.has_value();
     }
 
     std::string              name;
-    ColorFormat              color_format      = ColorFormat::UNDEFINED;
-    std::optional<glm::vec4> clear_color_value = {};
-    std::optional<glm::vec2> clear_depth_value = {};
+    ColorFormat              color_format         = ColorFormat::UNDEFINED;
+    std::optional<glm::vec4> clear_color_value    = {};
+    std::optional<glm::vec2> clear_depth_value    = {};
+    bool                     b_transient          = false;
+    bool                     b_read_outside_graph = false;
 
 private:
     Attachment(std::string in_name) : name(std::move(in_name))
@@ -79,6 +95,7 @@ public:
     {
     }
 
+    // Called on the render thread for every pass before the frame is recorded : draw() may run on a worker
     virtual void pre_draw(const RenderPassInstanceBase&)
     {
     }
@@ -107,7 +124,7 @@ struct RenderPassKey
         if (attachments.size() != other.attachments.size())
             return false;
         for (auto a = attachments.begin(), b = other.attachments.begin(); a != attachments.end(); ++a, ++b)
-            if (a->color_format != b->color_format || a->has_clear() != b->has_clear())
+            if (a->color_format != b->color_format || a->has_clear() != b->has_clear() || a->b_transient != b->b_transient)
                 return false;
         return true;
     }
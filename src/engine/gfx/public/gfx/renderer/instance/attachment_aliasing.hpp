@@ -0,0 +1,73 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <ankerl/unordered_dense.h>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class Device;
+class Image;
+class RenderPassInstanceBase;
+class SharedImageMemory;
+
+/**
+ * Share the memory of the render graph attachments whose lifetimes don't overlap.
+ * An attachment lives from the pass writing it until every pass depending on this pass is done. Another pass can reuse its memory if it transitively
+ * depends on all these readers : the semaphores between the passes then order the GPU work (see RenderPassInstanceBase::render()). Images are placed
+ * first-fit in the memory blocks created so far, separately for each device image.
+ *
+ * It lives during the outermost RenderPassInstanceBase::create_or_resize() call and only aliases the passes created by it. The attachments of the
+ * pass it started from and the ones declared with Attachment::read_outside_graph() are never aliased, as they are read outside of the graph. Debug
+ * views reading every attachment disable the aliasing while they are open (see disable()).
+ */
+class AttachmentAliasing
+{
+public:
+    // Start aliasing the attachments of the passes created from entry_pass, unless an outer create_or_resize() already does on this thread
+    static std::unique_ptr<AttachmentAliasing> begin(std::weak_ptr<Device> device, const RenderPassInstanceBase& entry_pass);
+
+    // Aliasing in progress on this thread, if any
+    static AttachmentAliasing* current();
+
+    // Stop aliasing the graphs created or resized until the matching enable(). The graphs created before must be recreated.
+    static void disable();
+    static void enable();
+
+    AttachmentAliasing(AttachmentAliasing&)  = delete;
+    AttachmentAliasing(AttachmentAliasing&&) = delete;
+    ~AttachmentAliasing();
+
+    // Can the attachments of this pass share their memory
+    bool can_alias(const RenderPassInstanceBase& pass) const;
+
+    // Bind the memory of an image created with ImageParameter::bind_memory = false
+    void bind(const RenderPassInstanceBase& pass, const Image& image);
+
+private:
+    AttachmentAliasing(std::weak_ptr<Device> device, const RenderPassInstanceBase& entry_pass);
+
+    struct MemoryBlock
+    {
+        std::shared_ptr<SharedImageMemory> memory;
+        VkDeviceSize                       size         = 0;
+        VkDeviceSize                       offset       = 0;
+        uint32_t                           memory_type  = 0;
+        size_t                             device_image = 0;
+        std::vector<size_t>                producers; // Passes whose attachments are bound to this block
+    };
+
+    // Is the block free once the given pass starts
+    bool is_free_for(const MemoryBlock& block, size_t pass) const;
+
+    std::weak_ptr<Device>                                               device;
+    ankerl::unordered_dense::map<const RenderPassInstanceBase*, size_t> pass_indices;
+    size_t                                                              entry_index = 0;
+    std::vector<std::vector<size_t>>                                    readers;   // Passes depending directly on each pass
+    std::vector<std::vector<bool>>                                      ancestors; // ancestors[a][b] : pass a transitively depends on pass b
+    std::vector<MemoryBlock>                                            blocks;
+    VkDeviceSize                                                        requested_size = 0;
+    VkDeviceSize                                                        lazy_size      = 0;
+    VkDeviceSize                                                        allocated_size = 0;
+};
+} // namespace Eng::Gfx
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <ankerl/unordered_dense.h>
+
+namespace Eng::Gfx
+{
+/**
+ * Index in passes of the dependencies of each pass, given for_each_dependency(pass, callback(const Pass*)).
+ * The dependencies missing from passes were collected by another root sharing them earlier in the frame (see RenderPassInstanceBase::render()) : they
+ * are already recorded, so they are ignored.
+ */
+template <typename Pass, typename ForEachDependency> std::vector<std::vector<size_t>> find_pass_dependencies(const std::vector<Pass*>& passes, const ForEachDependency& for_each_dependency)
+{
+    ankerl::unordered_dense::map<const Pass*, size_t> pass_indices;
+    for (size_t i = 0; i < passes.size(); ++i)
+        pass_indices.emplace(passes[i], i);
+
+    std::vector<std::vector<size_t>> pass_dependencies(passes.size());
+    for (size_t i = 0; i < passes.size(); ++i)
+        for_each_dependency(*passes[i],
+                            [&](const Pass* dependency)
+                            {
+                                if (auto found = pass_indices.find(dependency); found != pass_indices.end())
+                                    pass_dependencies[i].emplace_back(found->second);
+                            });
+    return pass_dependencies;
+}
+} // namespace Eng::Gfx
@@ -7,7 +7,6 @@
 
 namespace Eng::Gfx
 {
-class Fence;
 class Semaphore;
 class Framebuffer;
 class Swapchain;
@@ -41,6 +40,7 @@ class RenderPassInstance : public RenderPassInstanceBase
 protected:
     RenderPassInstance(std::weak_ptr<Device> device, const Renderer& renderer, const RenderPassGenericId& rp_ref, bool b_is_present);
 
+    void pre_draw_internal(SwapchainImageId swapchain_image) override;
     void render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image) override;
 
     virtual void fill_command_buffer(CommandBuffer& cmd, size_t group_index) const;
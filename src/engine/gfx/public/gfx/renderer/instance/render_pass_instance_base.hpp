@@ -24,7 +24,6 @@ class VkRendererPass;
 class RenderPassInstance;
 class ImageView;
 class Semaphore;
-class Fence;
 class Renderer;
 class Device;
 
@@ -42,12 +41,17 @@ public:
     ankerl::unordered_dense::map<std::string, std::shared_ptr<Buffer>>    buffers;
 
     std::vector<std::shared_ptr<Framebuffer>> framebuffers;
+
+    // The attachments share their memory with other passes (see AttachmentAliasing)
+    bool aliased_memory = false;
 };
 
 struct FrameCommandBuffers
 {
-    std::shared_ptr<CommandBuffer>                                                         command_buffer;
+    // Primary command buffer of each thread allowed to record the pass. Each one is allocated from the command pool of its thread.
+    ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<CommandBuffer>>          command_buffers;
     ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<SecondaryCommandBuffer>> secondary_command_buffers;
+    CommandBuffer&                                                                         get_primary_command_buffer() const;
     CommandBuffer&                                                                         get_this_thread_command_buffer(const Framebuffer& framebuffer) const;
 };
 
@@ -67,7 +71,13 @@ public:
     // Should be called before each frame to reset max draw flags
     void                    reset_for_next_frame();
     virtual FrameResources* create_or_resize(const glm::uvec2& viewport, const glm::uvec2& parent, bool b_force = false);
-    void                    render(SwapchainImageId swapchain_image, DeviceImageId device_image);
+
+    /**
+     * Record and submit this pass and all its dependencies. Each pass is recorded once all its dependencies are submitted, and the passes that
+     * don't depend on each other are recorded concurrently on the job system.
+     * Returns the timeline value of the graphic queue reached once the whole frame completed on the GPU.
+     */
+    uint64_t render(SwapchainImageId swapchain_image, DeviceImageId device_image);
 
     /**
      * The resolution of this current pass
@@ -149,14 +159,11 @@ public:
 protected:
     RenderPassInstanceBase(std::weak_ptr<Device> in_device, const Renderer& renderer, const RenderPassGenericId& name);
 
-    // Retrieve the fence that will be signaled once the image rendering is finished
-    virtual const Fence* get_render_finished_fence(DeviceImageId) const
-    {
-        return nullptr;
-    }
-
     VkSemaphore get_render_finished_semaphore() const;
 
+    // Submit the command buffer of this pass with the rest of the frame at the end of render(). It signals the render finished semaphore.
+    void queue_submission(CommandBuffer& cmd, std::vector<VkSemaphore> wait_semaphores);
+
     // Are drawcalls split in multiple jobs for this pass
     bool enable_parallel_rendering() const
     {
@@ -166,6 +173,11 @@ protected:
     // Create image and the image view for the given attachment
     virtual std::shared_ptr<ImageView> create_view_for_attachment(const std::string& attachment);
 
+    // Let the interface prepare the frame (see IRenderPass::pre_draw()). Called on the render thread before any pass is recorded.
+    virtual void pre_draw_internal(SwapchainImageId)
+    {
+    }
+
     // Implement the mechanics to draw this render pass
     virtual void render_internal(SwapchainImageId swapchain_image, DeviceImageId device_image) = 0;
 
@@ -176,6 +188,16 @@ protected:
     const FrameCommandBuffers& get_this_frame_command_buffer(DeviceImageId device_image) const;
 
 private:
+    struct PendingSubmission
+    {
+        CommandBuffer*           command_buffer = nullptr;
+        std::vector<VkSemaphore> wait_semaphores;
+        VkSemaphore              signal_semaphore = VK_NULL_HANDLE;
+    };
+
+    // List the passes of this graph that were not prepared yet, every pass after its dependencies
+    void collect_passes(std::vector<RenderPassInstanceBase*>& passes);
+
     bool prepared  = false;
     bool submitted = false;
 
@@ -183,6 +205,7 @@ private:
     std::shared_ptr<FrameResources> next_frame_resources;
 
     std::vector<std::shared_ptr<Semaphore>> render_finished_semaphores;
+    PendingSubmission                       pending_submission;
 
     std::vector<FrameCommandBuffers> command_buffers;
 
@@ -26,7 +26,6 @@ class Sampler;
 class ImageView;
 class Image;
 class CommandBuffer;
-class Mesh;
 class VkRendererPass;
 class Device;
 class Pipeline;
@@ -76,7 +75,6 @@ private:
 
     std::chrono::steady_clock::time_point last_time;
 
-    std::shared_ptr<Mesh>          mesh;
     std::shared_ptr<Pipeline>      imgui_material;
     std::shared_ptr<DescriptorSet> imgui_font_descriptor;
     std::shared_ptr<Image>         font_texture;
@@ -91,7 +89,7 @@ private:
     const RenderPassInstance* current_render_pass = nullptr;
 
     ImTextureID                                                                                                      max_texture_id = 0;
-    ankerl::unordered_dense::map<std::shared_ptr<ImageView>, std::pair<ImTextureID, std::shared_ptr<DescriptorSet>>> per_image_descriptor;
+    ankerl::unordered_dense::map<std::shared_ptr<ImageView>, std::pair<ImTextureID, std::shared_ptr<DescriptorSet>>> per_image_descriptor; // Transient descriptors of the current frame
     ankerl::unordered_dense::map<ImTextureID, std::shared_ptr<ImageView>>                                            per_image_ids;
     std::string                                                                                                      name;
     std::vector<std::unique_ptr<MainMenuItem>>                                                                       main_menu_items;
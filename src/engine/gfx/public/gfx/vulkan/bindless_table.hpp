@@ -0,0 +1,91 @@
+#pragma once
+#include "device_resource.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class BindlessTable;
+class ImageView;
+class Sampler;
+
+// Stable index in the bindless table. The index is released with the slot : drop it to the device (see Device::drop_resource()).
+class BindlessSlot : public DeviceResource
+{
+public:
+    BindlessSlot(std::string name, std::weak_ptr<Device> device, std::weak_ptr<BindlessTable> table, uint32_t binding, uint32_t index);
+    ~BindlessSlot() override;
+
+    uint32_t get_index() const
+    {
+        return index;
+    }
+
+private:
+    friend class BindlessTable;
+    std::weak_ptr<BindlessTable> table;
+    std::shared_ptr<ImageView>   view; // The referenced resource is kept alive as long as the descriptor
+    std::shared_ptr<Sampler>     sampler;
+    uint32_t                     binding = 0;
+    uint32_t                     index   = 0;
+};
+
+/**
+ * Global descriptor set of every texture and sampler, bound to BINDLESS_DESCRIPTOR_SET by the pipelines whose shaders use it. Materials then pass
+ * the indices of their resources through push constants instead of owning descriptors, so switching materials needs no descriptor bind.
+ * The set is updated after bind : new slots are written while the frames in flight use the other ones, and a freed index is only reused once
+ * the GPU is done with it.
+ */
+class BindlessTable : public std::enable_shared_from_this<BindlessTable>
+{
+public:
+    static constexpr uint32_t texture_binding = 0;
+    static constexpr uint32_t sampler_binding = 1;
+
+    static std::shared_ptr<BindlessTable> create(std::weak_ptr<Device> device, uint32_t texture_count, uint32_t sampler_count)
+    {
+        return std::shared_ptr<BindlessTable>(new BindlessTable(std::move(device), texture_count, sampler_count));
+    }
+
+    BindlessTable(BindlessTable&)  = delete;
+    BindlessTable(BindlessTable&&) = delete;
+    ~BindlessTable();
+
+    std::shared_ptr<BindlessSlot> add_texture(const std::shared_ptr<ImageView>& view);
+    std::shared_ptr<BindlessSlot> add_sampler(const std::shared_ptr<Sampler>& sampler);
+
+    VkDescriptorSet raw() const
+    {
+        return descriptor_set;
+    }
+
+    VkDescriptorSetLayout get_layout() const
+    {
+        return layout;
+    }
+
+private:
+    friend class BindlessSlot;
+    BindlessTable(std::weak_ptr<Device> device, uint32_t texture_count, uint32_t sampler_count);
+
+    struct Binding
+    {
+        uint32_t              capacity = 0;
+        uint32_t              next     = 0; // First index never allocated
+        std::vector<uint32_t> free_indices;
+    };
+
+    uint32_t allocate(uint32_t binding);
+    void     free(uint32_t binding, uint32_t index);
+
+    std::weak_ptr<Device> device;
+    VkDescriptorSetLayout layout         = VK_NULL_HANDLE;
+    VkDescriptorPool      pool           = VK_NULL_HANDLE;
+    VkDescriptorSet       descriptor_set = VK_NULL_HANDLE;
+    Binding               bindings[2];
+    std::mutex            table_mutex;
+};
+} // namespace Eng::Gfx
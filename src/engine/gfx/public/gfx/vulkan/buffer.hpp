@@ -5,12 +5,12 @@
 
 #include "device.hpp"
 #include "device_resource.hpp"
+#include "upload_queue.hpp"
 
 struct VmaAllocationWrap;
 
 namespace Eng::Gfx
 {
-class Fence;
 class CommandBuffer;
 class Device;
 
@@ -153,7 +153,7 @@ public:
     {
         auto new_buffer = std::shared_ptr<Buffer>(new Buffer(name, std::move(device), create_infos, data.get_stride(), data.get_element_count()));
         for (const auto& buffer : new_buffer->buffers)
-            buffer->set_data_and_wait(0, data);
+            buffer->set_data(0, data);
         return new_buffer;
     }
 
@@ -188,7 +188,8 @@ public:
         ~Resource();
         void set_data_and_wait(size_t start_index, const BufferData& data);
 
-        void set_data(size_t start_index, const BufferData& data);
+        // Overwriting data the frames in flight may still read requires b_wait_frames_in_flight (see UploadQueue::upload())
+        void set_data(size_t start_index, const BufferData& data, bool b_wait_frames_in_flight = false);
         void wait_data_upload();
 
         size_t                             stride        = 0;
@@ -198,9 +199,7 @@ public:
         VkBuffer                           ptr           = VK_NULL_HANDLE;
         std::unique_ptr<VmaAllocationWrap> allocation;
         VkDescriptorBufferInfo             descriptor_data;
-        std::shared_ptr<CommandBuffer>     data_update_cmd;
-        std::shared_ptr<Fence>             data_update_fence;
-        std::shared_ptr<Buffer>            transfer_buffer;
+        UploadToken                        data_update_token; // Last upload through the upload queue
     };
 
     const std::string& get_name() const
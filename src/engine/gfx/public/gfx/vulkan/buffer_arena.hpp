@@ -0,0 +1,88 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include "buffer.hpp"
+#include "device_resource.hpp"
+
+namespace Eng::Gfx
+{
+class Device;
+
+/**
+ * Large shared buffers split in element ranges, so the meshes using the same block need no rebinding and can be drawn together.
+ * Each block keeps its free ranges sorted by size and by offset : allocations take the smallest range that fits, and freed ranges are merged with
+ * their free neighbours. Data larger than a block gets a block of its own.
+ */
+class BufferArena : public std::enable_shared_from_this<BufferArena>
+{
+public:
+    // Range of elements of an arena block. The range is released with it : drop it to the device (see Device::drop_resource()).
+    class Allocation : public DeviceResource
+    {
+    public:
+        Allocation(std::string name, std::weak_ptr<Device> device, std::weak_ptr<BufferArena> arena, size_t block, uint32_t first_element, uint32_t element_count);
+        ~Allocation() override;
+
+        Buffer& get_buffer() const;
+
+        uint32_t get_first_element() const
+        {
+            return first_element;
+        }
+
+        uint32_t get_element_count() const
+        {
+            return element_count;
+        }
+
+    private:
+        std::weak_ptr<BufferArena> arena;
+        std::shared_ptr<Buffer>    buffer; // Keeps the block alive
+        size_t                     block         = 0;
+        uint32_t                   first_element = 0;
+        uint32_t                   element_count = 0;
+    };
+
+    static std::shared_ptr<BufferArena> create(std::string name, std::weak_ptr<Device> device, EBufferUsage usage, size_t stride, uint32_t block_element_count)
+    {
+        return std::shared_ptr<BufferArena>(new BufferArena(std::move(name), std::move(device), usage, stride, block_element_count));
+    }
+
+    BufferArena(BufferArena&)  = delete;
+    BufferArena(BufferArena&&) = delete;
+
+    // Allocate a range for the data and upload it through the upload queue. Empty data gets no range (nullptr).
+    std::shared_ptr<Allocation> allocate(const std::string& name, const BufferData& data);
+
+    size_t get_block_count() const
+    {
+        std::lock_guard lock(arena_mutex);
+        return blocks.size();
+    }
+
+private:
+    BufferArena(std::string name, std::weak_ptr<Device> device, EBufferUsage usage, size_t stride, uint32_t block_element_count);
+
+    struct Block
+    {
+        std::shared_ptr<Buffer>                      buffer;
+        std::map<uint32_t, uint32_t>                 free_by_offset; // offset -> size
+        std::set<std::pair<uint32_t, uint32_t>>      free_by_size;   // (size, offset)
+    };
+
+    bool allocate_in_block(Block& block, uint32_t element_count, uint32_t& out_first_element);
+    void free(size_t block, uint32_t first_element, uint32_t element_count);
+
+    std::string           name;
+    std::weak_ptr<Device> device;
+    EBufferUsage          usage;
+    size_t                stride              = 0;
+    uint32_t              block_element_count = 0;
+    std::vector<Block>    blocks;
+    mutable std::mutex    arena_mutex;
+};
+} // namespace Eng::Gfx
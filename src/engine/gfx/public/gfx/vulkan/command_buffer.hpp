@@ -35,8 +35,9 @@ class DescriptorSet;
 class Pipeline;
 class BufferData;
 class Mesh;
-class Fence;
 class Device;
+struct TransientBuffer;
+enum class IndexBufferType;
 
 struct Scissor
 {
@@ -46,6 +47,18 @@ struct Scissor
     uint32_t height;
 };
 
+/**
+ * Number of state changes actually recorded since begin(). Redundant binds are skipped and not counted.
+ */
+struct CommandBufferStats
+{
+    uint32_t pipeline_binds      = 0;
+    uint32_t descriptor_binds    = 0;
+    uint32_t vertex_buffer_binds = 0;
+    uint32_t index_buffer_binds  = 0;
+    uint32_t draw_calls          = 0;
+};
+
 struct Viewport
 {
     float x = 0;
@@ -64,6 +77,12 @@ public:
         return std::shared_ptr<CommandBuffer>(new CommandBuffer(name, std::move(device), type, std::this_thread::get_id()));
     }
 
+    // Create a command buffer that will be recorded by another thread
+    static std::shared_ptr<CommandBuffer> create(const std::string& name, std::weak_ptr<Device> device, QueueSpecialization type, std::thread::id thread_id)
+    {
+        return std::shared_ptr<CommandBuffer>(new CommandBuffer(name, std::move(device), type, thread_id));
+    }
+
     CommandBuffer(CommandBuffer&)  = delete;
     CommandBuffer(CommandBuffer&&) = delete;
     virtual ~CommandBuffer();
@@ -75,16 +94,29 @@ public:
 
     virtual void begin(bool one_time);
     virtual void end();
-    void         submit(VkSubmitInfo submit_infos, const Fence* optional_fence = nullptr);
+
+    // Returns the timeline value of the queue reached once this command buffer completed (see QueueFamily::submit())
+    uint64_t submit(VkSubmitInfo submit_infos);
+
+    /**
+     * Submit several command buffers of the same queue in a single vkQueueSubmit. submit_infos[i] describes the batch of command_buffers[i].
+     * Batches start in order, so a batch can wait for the semaphores signaled by the previous ones.
+     */
+    static uint64_t submit(const std::vector<CommandBuffer*>& command_buffers, std::vector<VkSubmitInfo> submit_infos);
 
     void begin_debug_marker(const std::string& name, const std::array<float, 4>& color) const;
     void end_debug_marker() const;
 
     void draw_procedural(uint32_t vertex_count, uint32_t first_vertex, uint32_t instance_count, uint32_t first_instance) const;
     void bind_pipeline(const std::shared_ptr<Pipeline>& pipeline);
-    void bind_descriptors(const DescriptorSet& descriptors, const Pipeline& pipeline) const;
-    void draw_mesh(const Mesh& in_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
-    void draw_mesh(const Mesh& in_buffer, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count = 1, uint32_t first_instance = 0) const;
+    void bind_descriptors(const DescriptorSet& descriptors, const Pipeline& pipeline);
+    void draw_mesh(const Mesh& in_buffer, uint32_t instance_count = 1, uint32_t first_instance = 0);
+    void draw_mesh(const Mesh& in_buffer, uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count = 1, uint32_t first_instance = 0);
+
+    // Geometry written for the current frame only (see TransientAllocator)
+    void bind_vertex_buffer(const TransientBuffer& vertices);
+    void bind_index_buffer(const TransientBuffer& indices, IndexBufferType index_type);
+    void draw_indexed(uint32_t first_index, uint32_t vertex_offset, uint32_t index_count, uint32_t instance_count = 1, uint32_t first_instance = 0);
     void set_scissor(const Scissor& scissors) const;
     void set_viewport(const Viewport& viewport) const;
     void push_constant(EShaderStage stage, const Pipeline& pipeline, const BufferData& data) const;
@@ -116,6 +148,11 @@ public:
         return render_pass_name;
     }
 
+    const CommandBufferStats& stats() const
+    {
+        return current_stats;
+    }
+
 protected:
     RenderPassRef render_pass_name;
     friend class SecondaryCommandBuffer;
@@ -133,6 +170,13 @@ private:
     std::thread::id           thread_id;
     std::string               name;
     std::shared_ptr<Pipeline> last_pipeline;
+    VkDescriptorSet           last_descriptor_set = VK_NULL_HANDLE;
+    VkPipelineLayout          last_layout         = VK_NULL_HANDLE;
+    std::vector<uint32_t>     last_dynamic_offsets;
+    std::vector<uint32_t>     dynamic_offsets; // Reused by bind_descriptors()
+    VkBuffer                  last_vertex_buffer  = VK_NULL_HANDLE;
+    VkBuffer                  last_index_buffer   = VK_NULL_HANDLE;
+    CommandBufferStats        current_stats;
     bool                      is_recording      = false;
     bool                      b_wait_submission = false;
 };
@@ -1,54 +1,47 @@
 #pragma once
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
 
-#include "descriptor_sets.hpp"
+#include "pipeline_layout.hpp"
 
 namespace Eng::Gfx
 {
-class PipelineLayout;
+class Device;
 
-struct PoolDescription
+/**
+ * Descriptor sets grouped by layout (see DescriptorLayoutKey). Sets of identical layouts are interchangeable : a released set goes back to the free
+ * list of its layout and is reused by the next allocation, so the pools never free single sets. Each full pool is followed by one twice as large.
+ * Each thread allocates from its own pools, only the free lists and the shared sets are common to all threads.
+ *
+ * Transient sets are only valid during the current frame. They come from per-frame pools, reset as a whole when the frame comes back.
+ */
+class DescriptorPool
 {
   public:
-    PoolDescription(const PipelineLayout& pipeline);
-
-    bool operator==(const PoolDescription& other) const
+    // Set written once, then shared by every descriptor set of the same layout holding the same descriptors (see acquire_shared())
+    class SharedSet : public DeviceResource
     {
-        auto a = other.pool_sizes.begin(), b = pool_sizes.begin();
-        for (; a != other.pool_sizes.end() && b != pool_sizes.end(); ++a, ++b)
-            if (a->descriptorCount != b->descriptorCount || a->type != b->type)
-                return false;
-        return a == other.pool_sizes.end() && b == pool_sizes.end();
-    }
-
-    std::vector<VkDescriptorPoolSize> pool_sizes;
-};
-} // namespace Eng::Gfx
+      public:
+        SharedSet(std::string name, std::weak_ptr<Device> device, std::shared_ptr<PipelineLayout> pipeline, std::vector<uint64_t> content);
+        SharedSet(SharedSet&)  = delete;
+        SharedSet(SharedSet&&) = delete;
+        ~SharedSet() override;
 
-template <> struct std::hash<Eng::Gfx::PoolDescription>
-{
-    size_t operator()(const Eng::Gfx::PoolDescription& val) const noexcept
-    {
-        auto ite = val.pool_sizes.begin();
-        if (ite == val.pool_sizes.end())
-            return 0;
-        size_t hash = std::hash<int32_t>()(static_cast<uint32_t>(ite->type) + ite->descriptorCount + 1);
-        for (; ite != val.pool_sizes.end(); ++ite)
+        VkDescriptorSet raw() const
         {
-            hash ^= std::hash<int32_t>()(static_cast<uint32_t>(ite->type) + ite->descriptorCount) * 13;
+            return ptr;
         }
-        return hash;
-    }
-};
 
-namespace Eng::Gfx
-{
-class Device;
+      private:
+        friend class DescriptorPool;
+        std::shared_ptr<PipelineLayout> pipeline;
+        std::vector<uint64_t>           content;
+        VkDescriptorSet                 ptr = VK_NULL_HANDLE;
+    };
 
-class DescriptorPool
-{
-  public:
     static std::shared_ptr<DescriptorPool> create(std::weak_ptr<Device> device)
     {
         return std::shared_ptr<DescriptorPool>(new DescriptorPool(std::move(device)));
@@ -56,40 +49,87 @@ class DescriptorPool
 
     DescriptorPool(DescriptorPool&)  = delete;
     DescriptorPool(DescriptorPool&&) = delete;
-    VkDescriptorSet allocate(const PipelineLayout& pipeline, size_t& pool_index);
-    void            free(const VkDescriptorSet& desc_set, const PipelineLayout& pipeline, size_t pool_index);
+    ~DescriptorPool();
+
+    VkDescriptorSet allocate(const PipelineLayout& pipeline);
+
+    // The GPU must be done with the set (see Device::drop_resource())
+    void free(VkDescriptorSet desc_set, const PipelineLayout& pipeline);
+
+    // Set released when the current swapchain image comes back
+    VkDescriptorSet allocate_transient(const PipelineLayout& pipeline);
+
+    /**
+     * Get the set holding the given descriptors. An existing set with the same layout and descriptors is returned as is, otherwise a new set is
+     * allocated and written with them (their dstSet is filled here). The set is released once the last reference was dropped : drop it to the
+     * device when the GPU may still use it.
+     */
+    std::shared_ptr<SharedSet> acquire_shared(const std::string& name, const std::shared_ptr<PipelineLayout>& pipeline, std::vector<VkWriteDescriptorSet>& writes);
+
+    // Reset the transient sets of the given swapchain image, after waiting for the graphic work of the last frame that used them. Called by
+    // Device::next_frame().
+    void next_frame(uint8_t image);
 
   private:
     DescriptorPool(std::weak_ptr<Device> device);
 
-    class Pool
+    // Pools of growing size, filled one after the other
+    struct PoolChain
     {
-      public:
-        Pool(std::weak_ptr<Device> device, const PoolDescription& description);
-        ~Pool();
+        struct Pool
+        {
+            VkDescriptorPool ptr       = VK_NULL_HANDLE;
+            uint32_t         capacity  = 0;
+            uint32_t         allocated = 0;
+        };
 
-        // Return null if full
-        VkDescriptorSet allocate(const VkDescriptorSetLayout& layout);
+        std::vector<Pool> pools;
+        size_t            current = 0;
+    };
 
-        // Return true if empty
-        bool free(const VkDescriptorSet& desc_set);
+    struct ContentHash
+    {
+        using is_avalanching = void;
 
-        // Return true if empty
-        bool is_empty() const
+        size_t operator()(const std::vector<uint64_t>& content) const noexcept
         {
-            return space_left == initial_space;
+            return ankerl::unordered_dense::detail::wyhash::hash(content.data(), content.size() * sizeof(uint64_t));
         }
+    };
 
-      private:
-        uint32_t              space_left    = 0;
-        uint32_t              initial_space = 0;
-        VkDescriptorPool      ptr           = VK_NULL_HANDLE;
-        std::weak_ptr<Device> device;
+    // Shared by all threads
+    struct LayoutPools
+    {
+        std::mutex                                                                                  lock;
+        std::vector<VkDescriptorSet>                                                                free_sets;
+        std::mutex                                                                                  shared_lock;
+        ankerl::unordered_dense::map<std::vector<uint64_t>, std::weak_ptr<SharedSet>, ContentHash> shared_sets; // Written descriptors -> set
     };
 
-    std::mutex pool_lock;
+    // Pools of one thread. The lock is only contended by next_frame().
+    struct ThreadPools
+    {
+        struct Chains
+        {
+            PoolChain              persistent;
+            std::vector<PoolChain> transient; // One chain per swapchain image
+        };
+
+        std::mutex                                               lock;
+        ankerl::unordered_dense::map<DescriptorLayoutKey, Chains> layouts;
+    };
 
-    std::weak_ptr<Device>                                                                      device;
-    ankerl::unordered_dense::map<PoolDescription, std::pair<size_t, std::vector<std::shared_ptr<Pool>>>> pools;
+    LayoutPools&    get_layout_pools(const DescriptorLayoutKey& key);
+    ThreadPools&    get_thread_pools();
+    VkDescriptorSet allocate_from(PoolChain& chain, const PipelineLayout& pipeline) const;
+    void            release_shared(const SharedSet& shared_set);
+
+    std::weak_ptr<Device>                                                            device;
+    uint8_t                                                                          current_image = 0;
+    std::vector<uint64_t>                                                            frame_values; // Graphic timeline value of the last frame of each image
+    std::shared_mutex                                                                layouts_lock;
+    ankerl::unordered_dense::map<DescriptorLayoutKey, std::unique_ptr<LayoutPools>> layouts;
+    std::shared_mutex                                                                threads_lock;
+    ankerl::unordered_dense::map<std::thread::id, std::unique_ptr<ThreadPools>>     threads;
 };
 } // namespace Eng::Gfx
@@ -1,6 +1,9 @@
 #pragma once
+#include "descriptor_pool.hpp"
 #include "device_resource.hpp"
+#include "transient_allocator.hpp"
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <ankerl/unordered_dense.h>
@@ -25,7 +28,11 @@ public:
     ~DescriptorSet();
     static std::shared_ptr<DescriptorSet> create(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline, bool b_static = false);
 
-    const VkDescriptorSet& raw_current() const;
+    // Set only valid during the current frame, allocated from the per-frame pools (see DescriptorPool::allocate_transient())
+    static std::shared_ptr<DescriptorSet> create_transient(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline);
+
+    // Only locks when the bindings changed since the last call
+    VkDescriptorSet raw_current() const;
 
     void bind_image(const std::string& binding_name, const std::shared_ptr<ImageView>& in_image)
     {
@@ -42,40 +49,48 @@ public:
         bind_buffers(binding_name, {in_buffer});
     }
 
+    // Bind memory of the current frame. Dynamic bindings only store its offset : the descriptors are updated when the buffer or the size changes.
+    void bind_buffer(const std::string& binding_name, const TransientBuffer& in_buffer);
+
     void bind_images(const std::string& binding_name, const std::vector<std::shared_ptr<ImageView>>& in_images);
     void bind_samplers(const std::string& binding_name, const std::vector<std::shared_ptr<Sampler>>& in_samplers);
     void bind_buffers(const std::string& binding_name, const std::vector<std::shared_ptr<Buffer>>& in_buffers);
 
+    // Offsets of the dynamic bindings, in binding order (see vkCmdBindDescriptorSets())
+    void get_dynamic_offsets(std::vector<uint32_t>& out_offsets) const;
+
 private:
     class Resource : public DeviceResource
     {
     public:
-        Resource(std::string name, const std::weak_ptr<Device>& device, const std::weak_ptr<DescriptorSet>& parent, const std::shared_ptr<PipelineLayout>& in_pipeline);
+        Resource(std::string name, const std::weak_ptr<Device>& device, const std::weak_ptr<DescriptorSet>& parent, const std::shared_ptr<PipelineLayout>& in_pipeline, bool b_transient);
         Resource(Resource&)  = delete;
         Resource(Resource&&) = delete;
-        ~Resource();
 
-        void mark_as_dirty()
+        // The set is only read without the lock once it holds the given bindings
+        bool is_outdated(uint64_t version) const
         {
-            outdated = true;
+            return written_version.load(std::memory_order_acquire) != version;
         }
 
+        // Requires DescriptorSet::update_lock
         void update();
 
-        const VkDescriptorSet& raw() const
+        VkDescriptorSet raw() const
         {
-            return ptr;
+            return ptr.load(std::memory_order_relaxed);
         }
 
     private:
-        bool                            outdated   = false;
-        size_t                          pool_index = 0;
-        std::shared_ptr<PipelineLayout> pipeline;
-        std::weak_ptr<DescriptorSet>    parent;
-        VkDescriptorSet                 ptr = VK_NULL_HANDLE;
+        std::atomic<uint64_t>                      written_version = 0; // Recycled sets still hold the descriptors of their previous owner
+        bool                                       b_transient;
+        std::shared_ptr<PipelineLayout>            pipeline;
+        std::weak_ptr<DescriptorSet>               parent;
+        std::shared_ptr<DescriptorPool::SharedSet> shared_set; // Sets of the same layout writing the same descriptors share it (not transient)
+        std::atomic<VkDescriptorSet>               ptr = VK_NULL_HANDLE;
     };
 
-    DescriptorSet(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline, bool b_static);
+    DescriptorSet(const std::string& name, const std::weak_ptr<Device>& device, const std::shared_ptr<PipelineLayout>& pipeline, bool b_static, bool b_transient);
 
     class Descriptor
     {
@@ -150,7 +165,7 @@ private:
     class BufferDescriptor : public Descriptor
     {
     public:
-        BufferDescriptor(std::vector<std::shared_ptr<Buffer>> in_buffer) : buffers(std::move(in_buffer))
+        BufferDescriptor(std::vector<std::shared_ptr<Buffer>> in_buffer, VkDescriptorType in_type) : buffers(std::move(in_buffer)), type(in_type)
         {
         }
 
@@ -169,17 +184,49 @@ private:
     protected:
         bool                                 equals(const Descriptor& other) const override;
         std::vector<std::shared_ptr<Buffer>> buffers;
+        VkDescriptorType                     type;
+    };
+
+    class TransientBufferDescriptor : public Descriptor
+    {
+    public:
+        // The offset is left to the dynamic offsets for dynamic bindings
+        TransientBufferDescriptor(const TransientBuffer& buffer, bool b_in_dynamic)
+            : infos{.buffer = buffer.buffer, .offset = b_in_dynamic ? 0 : buffer.offset, .range = buffer.size}, b_dynamic(b_in_dynamic)
+        {
+        }
+
+        void get_resources(uint32_t& buffer_count, uint32_t&) override
+        {
+            ++buffer_count;
+        }
+
+        void fill(std::vector<VkWriteDescriptorSet>& out_sets, VkDescriptorSet dst_set, uint32_t binding, std::vector<VkDescriptorImageInfo>& image_descs, std::vector<VkDescriptorBufferInfo>& buffer_descs) override;
+
+        uint32_t get_type_id() const override
+        {
+            return 4;
+        }
+
+    protected:
+        bool                   equals(const Descriptor& other) const override;
+        VkDescriptorBufferInfo infos;
+        bool                   b_dynamic;
     };
 
     bool try_insert(const std::string& binding_name, const std::shared_ptr<Descriptor>& descriptor);
 
     ankerl::unordered_dense::map<std::string, std::shared_ptr<Descriptor>> write_descriptors;
     ankerl::unordered_dense::map<std::string, uint32_t>                    descriptor_bindings;
+    ankerl::unordered_dense::map<std::string, uint32_t>                    dynamic_slots; // Index of each dynamic binding in dynamic_offsets
+    std::vector<std::atomic<uint32_t>>                                     dynamic_offsets;
 
     std::vector<std::shared_ptr<Resource>> resources;
+    std::atomic<uint64_t>                  binding_version = 1; // Incremented under update_lock when the bindings change
     mutable std::mutex                     update_lock;
     std::weak_ptr<Device>                  device;
     bool                                   b_static;
+    bool                                   b_transient;
     std::string                            name;
 };
 } // namespace Eng::Gfx
\ No newline at end of file
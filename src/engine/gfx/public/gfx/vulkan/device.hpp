@@ -5,16 +5,24 @@
 #include "gfx/renderer/definition/render_pass_id.hpp"
 
 #include <ankerl/unordered_dense.h>
+#include <deque>
+#include <map>
 
 struct VmaAllocatorWrap;
 
 namespace Eng::Gfx
 {
 struct RenderPassKey;
+class BindlessTable;
+class BufferArena;
 class VkRendererPass;
 class DescriptorPool;
 class DeviceResource;
+class PipelineCache;
 class Queues;
+class TransientAllocator;
+class UploadQueue;
+enum class EBufferUsage;
 
 class Device : public std::enable_shared_from_this<Device>
 {
@@ -51,6 +59,14 @@ public:
         return {};
     }
 
+    std::vector<RenderPassGenericId> get_render_pass_types() const
+    {
+        std::vector<RenderPassGenericId> types;
+        for (const auto& type : registered_render_passes)
+            types.emplace_back(type.first);
+        return types;
+    }
+
     void destroy_resources();
 
     uint8_t get_image_count() const
@@ -67,29 +83,47 @@ public:
 
     void wait() const;
 
+    // Release the dropped resources whose frame completed on every queue. Never blocks.
     void flush_resources();
 
+    /**
+     * Keep the resource alive until the GPU is done with the current frame. The resources dropped during a frame are tagged with the timeline value
+     * of every queue in next_frame(), and released by flush_resources() once all of them are reached.
+     */
     void drop_resource(const std::shared_ptr<DeviceResource>& resource)
     {
         std::lock_guard lock(resource_mutex);
-        if (current_image >= pending_kill_resources.size())
-            pending_kill_resources.resize(current_image + 1);
-        pending_kill_resources[current_image].emplace_back(resource);
+        dropped_resources.emplace_back(resource);
     }
 
-    void drop_resource(const std::shared_ptr<DeviceResource>& resource, size_t resource_image)
+    DescriptorPool& get_descriptor_pool() const
     {
-        std::lock_guard lock(resource_mutex);
-        if (resource_image >= pending_kill_resources.size())
-            pending_kill_resources.resize(resource_image + 1);
-        pending_kill_resources[resource_image].emplace_back(resource);
+        return *descriptor_pool;
     }
 
-    DescriptorPool& get_descriptor_pool() const
+    UploadQueue& get_upload_queue() const
     {
-        return *descriptor_pool;
+        return *upload_queue;
+    }
+
+    TransientAllocator& get_transient_allocator() const
+    {
+        return *transient_allocator;
+    }
+
+    BindlessTable& get_bindless_table() const
+    {
+        return *bindless_table;
+    }
+
+    PipelineCache& get_pipeline_cache() const
+    {
+        return *pipeline_cache;
     }
 
+    // Shared buffers of the given usage and stride, created on first use (see BufferArena)
+    BufferArena& get_buffer_arena(EBufferUsage usage, size_t stride);
+
     template <typename Object_T> void debug_set_object_name([[maybe_unused]] const std::string& object_name, [[maybe_unused]] const Object_T& object)
     {
         if (b_enable_validation_layers)
@@ -177,6 +211,12 @@ public:
     }
 
 private:
+    struct PendingRelease
+    {
+        std::vector<uint64_t>                        queue_values; // Submitted timeline value of each queue family (see Queues::all_families())
+        std::vector<std::shared_ptr<DeviceResource>> resources;
+    };
+
     std::mutex object_name_mutex;
     bool       b_enable_validation_layers = false;
     Device(const GfxConfig& config, const std::weak_ptr<Instance>& instance, const PhysicalDevice& physical_device, const Surface& surface);
@@ -190,8 +230,15 @@ private:
     uint8_t                                                                                        image_count   = 2;
     uint8_t                                                                                        current_image = 0;
     std::mutex                                                                                     resource_mutex;
-    std::vector<std::vector<std::shared_ptr<DeviceResource>>>                                      pending_kill_resources;
+    std::vector<std::shared_ptr<DeviceResource>>                                                   dropped_resources;
+    std::deque<PendingRelease>                                                                     pending_kill_resources;
     std::shared_ptr<DescriptorPool>                                                                descriptor_pool;
+    std::shared_ptr<UploadQueue>                                                                   upload_queue;
+    std::shared_ptr<TransientAllocator>                                                            transient_allocator;
+    std::shared_ptr<BindlessTable>                                                                 bindless_table;
+    std::shared_ptr<PipelineCache>                                                                 pipeline_cache;
+    std::mutex                                                                                     arena_mutex;
+    std::map<std::pair<EBufferUsage, size_t>, std::shared_ptr<BufferArena>>                        buffer_arenas;
     std::weak_ptr<Instance>                                                                        instance;
     GfxConfig                                                                                      config;
 };
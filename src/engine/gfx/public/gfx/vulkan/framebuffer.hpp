@@ -9,7 +9,6 @@
 namespace Eng::Gfx
 {
 class FrameResources;
-class Fence;
 class VkRendererPass;
 class Semaphore;
 class Device;
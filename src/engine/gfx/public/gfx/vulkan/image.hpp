@@ -11,7 +11,6 @@
 
 namespace Eng::Gfx
 {
-class CommandBuffer;
 class Device;
 
 enum class EImageType
@@ -97,6 +96,8 @@ struct ImageParameter
     uint32_t                     depth                  = 1;
     uint32_t                     array_size             = 1;
     bool                         read_only              = true;
+    bool                         transient_attachment   = false; // Only used as an attachment inside a render pass : never sampled nor stored
+    bool                         bind_memory            = true;  // If false, the memory is bound later by the owner of the image (see AttachmentAliasing)
 };
 
 class Image
@@ -111,13 +112,17 @@ public:
         ImageResource(ImageResource&&) = delete;
         ImageResource(ImageResource&)  = delete;
         ~ImageResource();
-        void set_data(const std::vector<BufferData>& mips);
-        void set_image_layout(const CommandBuffer& command_buffer, VkImageLayout new_layout);
-        void generate_mipmaps(uint32_t mipLevels, const CommandBuffer& command_buffer) const;
+        // Overwriting an image the frames in flight may still read requires b_wait_frames_in_flight (see UploadQueue::upload())
+        void set_data(const std::vector<BufferData>& mips, bool b_wait_frames_in_flight = false);
+        void wait_data_upload() const;
+        void set_image_layout(VkCommandBuffer command_buffer, VkImageLayout new_layout);
+        void generate_mipmaps(uint32_t mipLevels, VkCommandBuffer command_buffer) const;
 
         VkImage                            ptr          = VK_NULL_HANDLE;
         VkImageLayout                      image_layout = VK_IMAGE_LAYOUT_UNDEFINED;
         std::unique_ptr<VmaAllocationWrap> allocation;
+        std::shared_ptr<DeviceResource>    bound_memory; // Memory shared with other images, when created without its own allocation
+        UploadToken                        data_update_token; // Last upload through the upload queue
         bool                               outdated      = false;
         uint32_t                           layer_cout    = 0;
         uint32_t                           mip_count     = 0;
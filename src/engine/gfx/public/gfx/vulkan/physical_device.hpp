@@ -32,6 +32,8 @@ class PhysicalDevice
 
     std::string get_device_name() const;
 
+    VkPhysicalDeviceProperties get_properties() const;
+
     VkPhysicalDevice raw() const
     {
         return ptr;
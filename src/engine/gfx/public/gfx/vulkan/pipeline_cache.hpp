@@ -0,0 +1,59 @@
+#pragma once
+#include "jobsys/job_sys.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class Device;
+
+/**
+ * Device-wide VkPipelineCache persisted on disk, so the driver skips the compilation of the pipelines it already built in a previous run.
+ * The file is only loaded when it was written by the same device and driver : any mismatch or corruption starts from an empty cache.
+ *
+ * The cache is internally synchronized : every thread building pipelines uses it directly.
+ */
+class PipelineCache
+{
+public:
+    static std::shared_ptr<PipelineCache> create(std::weak_ptr<Device> device, std::filesystem::path path, double save_interval)
+    {
+        return std::shared_ptr<PipelineCache>(new PipelineCache(std::move(device), std::move(path), save_interval));
+    }
+
+    PipelineCache(PipelineCache&)  = delete;
+    PipelineCache(PipelineCache&&) = delete;
+    ~PipelineCache();
+
+    VkPipelineCache raw() const
+    {
+        return ptr;
+    }
+
+    // Write the cache to disk. Skipped when its content did not change since the last save.
+    void save();
+
+    // Save periodically on a worker, so the compiled pipelines survive a crash. Called by Device::next_frame().
+    void next_frame();
+
+private:
+    PipelineCache(std::weak_ptr<Device> device, std::filesystem::path path, double save_interval);
+
+    std::vector<uint8_t> load() const;
+
+    std::weak_ptr<Device>                 device;
+    VkPipelineCache                       ptr = VK_NULL_HANDLE;
+    std::filesystem::path                 path;
+    std::chrono::duration<double>         save_interval;
+    std::chrono::steady_clock::time_point last_save;
+    uint64_t                              saved_hash = 0; // Hash of the data written by the last save
+    std::mutex                            cache_mutex;
+    std::optional<JobHandle<void>>        save_job;
+};
+} // namespace Eng::Gfx
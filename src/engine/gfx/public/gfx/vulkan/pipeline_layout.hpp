@@ -2,7 +2,9 @@
 #include "device_resource.hpp"
 #include <vulkan/vulkan.h>
 
+#include <optional>
 #include <string>
+#include <ankerl/unordered_dense.h>
 #include <vector>
 
 namespace ShaderCompiler
@@ -14,6 +16,42 @@ namespace Eng::Gfx
 {
 class ShaderModule;
 
+// Identity of a descriptor set layout : sets allocated with identical layouts can be bound with either of them (see DescriptorPool)
+struct DescriptorLayoutKey
+{
+    struct Binding
+    {
+        uint32_t                 binding;
+        VkDescriptorType         type;
+        uint32_t                 count;
+        VkShaderStageFlags       stages;
+        VkDescriptorBindingFlags flags;
+
+        bool operator==(const Binding& other) const = default;
+    };
+
+    bool operator==(const DescriptorLayoutKey& other) const
+    {
+        return hash == other.hash && bindings == other.bindings;
+    }
+
+    std::vector<Binding>              bindings;
+    std::vector<VkDescriptorPoolSize> pool_sizes; // Descriptors of one set
+    size_t                            hash = 0;
+};
+} // namespace Eng::Gfx
+
+template <> struct std::hash<Eng::Gfx::DescriptorLayoutKey>
+{
+    size_t operator()(const Eng::Gfx::DescriptorLayoutKey& val) const noexcept
+    {
+        return val.hash;
+    }
+};
+
+namespace Eng::Gfx
+{
+
 class PipelineLayout : public DeviceResource
 {
 public:
@@ -29,6 +67,22 @@ public:
         return descriptor_bindings;
     }
 
+    bool has_binding(const std::string& binding_name) const;
+
+    // Offset of the push constant member of the given name
+    std::optional<uint32_t> get_push_constant_offset(const std::string& field_name) const;
+
+    uint32_t get_push_constant_size() const
+    {
+        return push_constant_size;
+    }
+
+    // The bindless table is bound to BINDLESS_DESCRIPTOR_SET (see BindlessTable)
+    bool uses_bindless_table() const
+    {
+        return b_uses_bindless_table;
+    }
+
     const VkPipelineLayout& raw() const
     {
         return ptr;
@@ -39,11 +93,20 @@ public:
         return descriptor_layout;
     }
 
+    const DescriptorLayoutKey& get_descriptor_key() const
+    {
+        return descriptor_key;
+    }
+
 private:
     PipelineLayout(std::string name, std::weak_ptr<Device> in_device, const std::vector<std::shared_ptr<ShaderModule>>& shader_stage);
 
-    VkDescriptorSetLayout                           descriptor_layout = VK_NULL_HANDLE;
-    VkPipelineLayout                                ptr               = VK_NULL_HANDLE;
-    std::vector<ShaderCompiler::BindingDescription> descriptor_bindings;
+    VkDescriptorSetLayout                               descriptor_layout = VK_NULL_HANDLE;
+    VkPipelineLayout                                    ptr               = VK_NULL_HANDLE;
+    std::vector<ShaderCompiler::BindingDescription>     descriptor_bindings;
+    DescriptorLayoutKey                                 descriptor_key;
+    ankerl::unordered_dense::map<std::string, uint32_t> push_constant_fields;
+    uint32_t                                            push_constant_size    = 0;
+    bool                                                b_uses_bindless_table = false;
 };
 }
\ No newline at end of file
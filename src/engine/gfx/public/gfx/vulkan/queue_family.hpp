@@ -1,12 +1,14 @@
 #pragma once
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <vector>
 #include <ankerl/unordered_dense.h>
 #include <vulkan/vulkan_core.h>
 
 namespace Eng::Gfx
 {
-class Fence;
 class CommandBuffer;
 class CommandPool;
 class Surface;
@@ -31,6 +33,7 @@ class QueueFamily
     QueueFamily(uint32_t index, VkQueueFlags flags, bool support_present, std::shared_ptr<std::shared_mutex> queue_global_lock);
     QueueFamily(QueueFamily&)  = delete;
     QueueFamily(QueueFamily&&) = delete;
+    ~QueueFamily();
 
     bool support_present() const
     {
@@ -55,7 +58,28 @@ class QueueFamily
     }
 
     VkResult present(const VkPresentInfoKHR& present_infos);
-    VkResult submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos = {}, const Fence* optional_fence = nullptr);
+
+    /**
+     * Every submission signals the timeline semaphore of this queue with the next value and returns it. The work is complete once the timeline
+     * reached this value (see is_complete() and wait()). For batched submissions, only the last batch signals the timeline.
+     * The wait values of a VkTimelineSemaphoreSubmitInfo chained first on the last batch are kept.
+     */
+    uint64_t submit(const CommandBuffer& cmd, VkSubmitInfo submit_infos = {});
+    uint64_t submit(const std::vector<VkSubmitInfo>& submit_infos);
+
+    // Value signaled by the last submission
+    uint64_t get_submitted_value() const
+    {
+        return submitted_value;
+    }
+
+    bool is_complete(uint64_t value) const;
+    void wait(uint64_t value) const;
+
+    VkSemaphore get_timeline_semaphore() const
+    {
+        return timeline;
+    }
 
     void set_name(const std::string& in_name)
     {
@@ -63,6 +87,8 @@ class QueueFamily
     }
 
   private:
+    uint64_t submit_internal(const VkSubmitInfo* submit_infos, uint32_t submit_count);
+
     std::mutex queue_mutex;
 
     uint32_t                           queue_index;
@@ -73,6 +99,9 @@ class QueueFamily
     std::shared_ptr<CommandPool>       command_pool;
     std::string                        name;
     std::shared_ptr<std::shared_mutex> queue_global_lock;
+    std::weak_ptr<Device>              device;
+    VkSemaphore                        timeline        = VK_NULL_HANDLE;
+    std::atomic_uint64_t               submitted_value = 0;
 };
 
 class Queues
@@ -13,7 +13,6 @@
 namespace Eng::Gfx
 {
 class Renderer;
-class Fence;
 class Semaphore;
 class ImageView;
 class SwapchainRenderer;
@@ -70,11 +69,6 @@ class Swapchain final : public RenderPassInstance
 protected:
     std::vector<VkSemaphore> get_semaphores_to_wait(DeviceImageId swapchain_image) const override;
 
-    const Fence* get_render_finished_fence(DeviceImageId device_image) const override
-    {
-        return render_finished_fences[device_image].get();
-    }
-
   private:
     Swapchain(const std::weak_ptr<Device>& device, const std::weak_ptr<Surface>& surface, const Renderer& renderer);
 
@@ -84,7 +78,6 @@ protected:
     bool render_internal();
     void destroy();
 
-    std::vector<std::shared_ptr<Fence>>     render_finished_fences;
     std::weak_ptr<Surface>                  surface;
     VkSwapchainKHR                          ptr              = VK_NULL_HANDLE;
     ColorFormat                             swapchain_format = ColorFormat::UNDEFINED;
@@ -92,6 +85,6 @@ protected:
     std::vector<VkImage>                    swapChainImages;
     std::shared_ptr<ImageView>              image_view;
     std::vector<std::shared_ptr<Semaphore>> image_available_semaphores;
-    std::vector<const Fence*>               in_flight_fences;
+    std::vector<uint64_t>                   in_flight_values; // Graphic queue timeline value of the last frame rendered with each device image
 };
 } // namespace Eng::Gfx
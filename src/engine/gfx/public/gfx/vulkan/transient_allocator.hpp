@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class BufferData;
+class Device;
+class TransientBlock;
+
+// Memory written by the CPU for the current frame only (see TransientAllocator)
+struct TransientBuffer
+{
+    VkBuffer     buffer = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size   = 0;
+    uint8_t*     data   = nullptr; // Mapped memory at offset
+
+    explicit operator bool() const
+    {
+        return buffer != VK_NULL_HANDLE;
+    }
+};
+
+/**
+ * Linear allocator for the data rewritten every frame (view constants, lights, UI geometry...). A persistently mapped buffer is split in one region
+ * per swapchain image : allocating is an atomic bump in the region of the current frame, and the whole region is reused once the frame comes back.
+ * Allocations are bound through dynamic offsets (see DescriptorSet::bind_buffer()), so the descriptors don't change from frame to frame.
+ *
+ * When a frame needs more than its region, the rest of it goes to overflow blocks and the regions grow at the next frame.
+ */
+class TransientAllocator
+{
+public:
+    static std::shared_ptr<TransientAllocator> create(std::weak_ptr<Device> device, VkDeviceSize frame_size)
+    {
+        return std::shared_ptr<TransientAllocator>(new TransientAllocator(std::move(device), frame_size));
+    }
+
+    TransientAllocator(TransientAllocator&)  = delete;
+    TransientAllocator(TransientAllocator&&) = delete;
+    ~TransientAllocator();
+
+    // Sizes are rounded up to a power of two : the descriptor ranges stay the same while the content size changes a bit between frames
+    TransientBuffer allocate(VkDeviceSize size);
+
+    // Allocate and copy the data
+    TransientBuffer write(const BufferData& data);
+
+    // Start writing the region of the given swapchain image. Called by Device::next_frame().
+    void next_frame(uint8_t image);
+
+private:
+    TransientAllocator(std::weak_ptr<Device> device, VkDeviceSize frame_size);
+
+    TransientBuffer allocate_overflow(VkDeviceSize size);
+
+    std::weak_ptr<Device>                        device;
+    std::shared_ptr<TransientBlock>              block;           // One region of frame_size bytes per swapchain image
+    std::vector<std::shared_ptr<TransientBlock>> overflow_blocks; // Allocated by the current frame once its region was full
+    VkDeviceSize                                 frame_size     = 0;
+    VkDeviceSize                                 alignment      = 0;
+    VkDeviceSize                                 region_start   = 0;
+    std::atomic<VkDeviceSize>                    head           = 0; // Bytes reserved in the current region, can go past frame_size
+    VkDeviceSize                                 overflow_head  = 0;
+    VkDeviceSize                                 overflow_bytes = 0;
+    std::mutex                                   overflow_mutex;
+};
+} // namespace Eng::Gfx
@@ -0,0 +1,145 @@
+#pragma once
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include <vulkan/vulkan_core.h>
+
+namespace Eng::Gfx
+{
+class BufferData;
+class Device;
+class QueueFamily;
+class StagingBuffer;
+
+// Completion of an upload (see UploadQueue::is_complete() and UploadQueue::wait())
+struct UploadToken
+{
+    uint64_t batch = 0;
+
+    explicit operator bool() const
+    {
+        return batch != 0;
+    }
+};
+
+/**
+ * Non-blocking uploads through the transfer queue. The data is copied to a persistently mapped staging ring shared by the whole device, and the copies
+ * are recorded in the transfer command buffer of the current batch. The batch is submitted once per frame before the render graph (see flush()) : the
+ * commands finishing the uploads on the graphic queue wait for the transfer timeline, and every later graphic submission comes after them.
+ *
+ * When the transfer queue belongs to its own family, the written resources are released by the transfer queue and acquired by the graphic queue.
+ * Re-uploaded resources go the other way first : the graphic queue releases them in a command buffer submitted before the transfer.
+ * A batch keeps its part of the ring until both queues completed it, the uploads waiting for free space otherwise. Uploads larger than a quarter of
+ * the ring get a dedicated staging buffer.
+ */
+class UploadQueue
+{
+public:
+    // Commands of one upload, recorded under the queue lock
+    class Commands
+    {
+    public:
+        VkBuffer                  staging_buffer = VK_NULL_HANDLE;
+        std::vector<VkDeviceSize> offsets; // Offset of each uploaded data in the staging buffer
+
+        // Executed by the transfer queue, they can read the staging buffer
+        VkCommandBuffer transfer() const;
+
+        // Executed by the graphic queue once the transfer is done
+        VkCommandBuffer graphic() const;
+
+        // Make the transfer writes visible to the given stages of the graphic queue, transferring the queue family ownership if needed.
+        // The access masks and the queue families of the barrier are filled here.
+        void release_to_graphic(VkBufferMemoryBarrier barrier, VkPipelineStageFlags destination_stages, VkAccessFlags destination_access) const;
+        void release_to_graphic(VkImageMemoryBarrier barrier, VkPipelineStageFlags destination_stages, VkAccessFlags destination_access) const;
+
+        // Before overwriting a resource released to the graphic queue by a previous upload : the graphic queue releases it back to the transfer
+        // queue once the given stages are done with it. The access masks and the queue families of the barrier are filled here.
+        void acquire_from_graphic(VkBufferMemoryBarrier barrier, VkPipelineStageFlags source_stages) const;
+        void acquire_from_graphic(VkImageMemoryBarrier barrier, VkPipelineStageFlags source_stages) const;
+
+    private:
+        friend class UploadQueue;
+        VkCommandBuffer release_from_graphic() const;
+
+        Commands(UploadQueue& in_queue) : queue(in_queue)
+        {
+        }
+
+        UploadQueue& queue;
+    };
+
+    using RecordCommands = std::function<void(const Commands& commands)>;
+
+    static std::shared_ptr<UploadQueue> create(std::weak_ptr<Device> device, VkDeviceSize staging_size)
+    {
+        return std::shared_ptr<UploadQueue>(new UploadQueue(std::move(device), staging_size));
+    }
+
+    UploadQueue(UploadQueue&)  = delete;
+    UploadQueue(UploadQueue&&) = delete;
+    ~UploadQueue();
+
+    /**
+     * Copy the data to the staging memory and record the commands of the upload in the current batch. Never waits for the GPU unless the staging
+     * memory is full. Overwriting a resource the frames in flight may still read requires b_wait_frames_in_flight : the transfer then starts after
+     * the graphic work submitted so far. Re-uploads pass the token of the previous upload of the resource, so that it is acquired from the graphic
+     * queue after the previous batch (see Commands::acquire_from_graphic()).
+     */
+    UploadToken upload(const std::vector<BufferData>& data, const RecordCommands& record, bool b_wait_frames_in_flight = false, const UploadToken& previous_upload = {});
+
+    // Submit the current batch, if any
+    void flush();
+
+    bool is_complete(const UploadToken& token);
+
+    // Wait for the GPU to complete the upload, submitting it first if needed
+    void wait(const UploadToken& token);
+
+private:
+    UploadQueue(std::weak_ptr<Device> device, VkDeviceSize staging_size);
+
+    struct Batch
+    {
+        uint64_t                                    index              = 0;
+        VkCommandBuffer                             transfer_commands  = VK_NULL_HANDLE;
+        VkCommandBuffer                             graphic_commands   = VK_NULL_HANDLE;
+        VkCommandBuffer                             release_commands   = VK_NULL_HANDLE; // Graphic releases executed before the transfer
+        uint64_t                                    graphic_wait_value = 0; // Graphic work to wait for before the transfer
+        uint64_t                                    transfer_value     = 0;
+        uint64_t                                    graphic_value      = 0;
+        VkDeviceSize                                ring_end           = 0; // Ring head once the batch was submitted
+        VkDeviceSize                                ring_bytes         = 0; // Bytes of the ring used by the batch, padding included
+        std::vector<std::shared_ptr<StagingBuffer>> dedicated_buffers;
+    };
+
+    // Reserve ring memory. Returns nothing if there is no space left, out_consumed also counts the end of the ring skipped when wrapping.
+    std::optional<VkDeviceSize> try_allocate(VkDeviceSize size, VkDeviceSize& out_consumed);
+    Batch&                      current_batch();
+    VkCommandBuffer             begin_command_buffer(VkCommandPool pool, std::vector<VkCommandBuffer>& free_command_buffers) const;
+    void                        submit_batch();
+    bool                        is_batch_complete(const Batch& batch) const;
+    void                        retire_completed_batches();
+
+    std::weak_ptr<Device>          device;
+    std::shared_ptr<QueueFamily>   transfer_queue;
+    std::shared_ptr<QueueFamily>   graphic_queue;
+    bool                           b_ownership_transfer = false; // The transfer and graphic queues belong to different families
+    std::shared_ptr<StagingBuffer> ring;
+    VkDeviceSize                   capacity      = 0;
+    VkDeviceSize                   head          = 0; // Next free byte
+    VkDeviceSize                   tail          = 0; // First byte still used by a batch
+    VkDeviceSize                   used          = 0;
+    VkCommandPool                  transfer_pool = VK_NULL_HANDLE;
+    VkCommandPool                  graphic_pool  = VK_NULL_HANDLE;
+    std::vector<VkCommandBuffer>   free_transfer_command_buffers;
+    std::vector<VkCommandBuffer>   free_graphic_command_buffers;
+    std::optional<Batch>           recording;
+    std::deque<Batch>              submitted;
+    uint64_t                       next_batch_index = 1;
+    std::mutex                     queue_mutex;
+};
+} // namespace Eng::Gfx
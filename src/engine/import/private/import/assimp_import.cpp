@@ -16,8 +16,10 @@
 #include "assets/texture_asset.hpp"
 #include "import/material_import.hpp"
 #include "import/image_import.hpp"
+#include "import/mesh_simplifier.hpp"
 #include "scene/components/mesh_component.hpp"
 #include "scene/components/scene_component.hpp"
+#include "scene/scene_serializer.hpp"
 
 #include <numbers>
 
@@ -28,14 +30,16 @@ AssimpImporter::AssimpImporter() : importer(std::make_shared<Assimp::Importer>()
 {
 }
 
-AssimpImporter::SceneLoader::SceneLoader(const std::filesystem::path& in_file_path, const aiScene* in_scene, Scene& output_scene) : scene(in_scene), file_path(in_file_path)
+AssimpImporter::SceneLoader::SceneLoader(const std::filesystem::path& in_file_path, const aiScene* in_scene, Scene& output_scene, uint32_t in_generated_lods, float in_lod_triangle_ratio,
+                                         AssetPayloads* in_payloads)
+    : scene(in_scene), file_path(in_file_path), generated_lods(in_generated_lods), lod_triangle_ratio(in_lod_triangle_ratio), payloads(in_payloads)
 {
     PROFILER_SCOPE(DecomposeAssimpScene);
     decompose_node(scene->mRootNode, {}, output_scene);
     scene->mRootNode;
 }
 
-Scene AssimpImporter::load_from_path(const std::filesystem::path& path) const
+Scene AssimpImporter::load_from_path(const std::filesystem::path& path, AssetPayloads* payloads) const
 {
     Scene output_scene;
     PROFILER_SCOPE_NAMED(LoadAssimpSceneFromPath, std::format("Load assimp scene from path {}", path.filename().string()));
@@ -45,7 +49,7 @@ Scene AssimpImporter::load_from_path(const std::filesystem::path& path) const
         LOG_ERROR("Failed to load scene from path {}", path.string());
         return output_scene;
     }
-    SceneLoader loader(path, scene, output_scene);
+    SceneLoader loader(path, scene, output_scene, generated_lods, lod_triangle_ratio, payloads);
     return output_scene;
 }
 
@@ -54,13 +58,31 @@ void AssimpImporter::SceneLoader::decompose_node(aiNode* node, TObjectRef<SceneC
     TObjectRef<SceneComponent> this_component;
     if (node->mNumMeshes > 0)
     {
-        auto new_mesh = Engine::get().asset_registry().create<MeshAsset>(node->mName.C_Str());
+        auto                                      new_mesh     = Engine::get().asset_registry().create<MeshAsset>(node->mName.C_Str());
+        uint64_t                                  content_hash = 0;
+        std::vector<std::shared_ptr<MeshSection>> sections;
         for (size_t i = 0; i < node->mNumMeshes; ++i)
         {
             auto section = find_or_load_mesh(node->mMeshes[i]);
             if (!section)
                 continue;
-            new_mesh->add_section(section->name, section->vertices, *section->indices, section->mat);
+            new_mesh->add_section(section->name, section->vertices, *section->indices, section->mat, {}, section->lods);
+            sections.emplace_back(section);
+
+            // Serialized scenes reference the mesh by its geometry and materials
+            const std::string_view material_name = section->mat ? section->mat->get_name() : "";
+            const uint64_t         hashes[4]     = {content_hash, ankerl::unordered_dense::detail::wyhash::hash(section->vertices.data(), section->vertices.size() * sizeof(MeshAsset::Vertex)),
+                                                    ankerl::unordered_dense::detail::wyhash::hash(section->indices->data(), section->indices->get_byte_size()),
+                                                    ankerl::unordered_dense::detail::wyhash::hash(material_name.data(), material_name.size())};
+            content_hash = ankerl::unordered_dense::detail::wyhash::hash(hashes, sizeof(hashes));
+        }
+        new_mesh->set_content_hash(content_hash);
+        if (payloads && !payloads->find_mesh(content_hash))
+        {
+            std::vector<AssetPayloads::MeshSection> section_payloads;
+            for (const auto& section : sections)
+                section_payloads.emplace_back(section->name, section->vertices, section->indices, section->lods);
+            payloads->add_mesh(content_hash, std::move(section_payloads));
         }
         if (parent)
         {
@@ -98,7 +120,7 @@ TObjectRef<TextureAsset> AssimpImporter::SceneLoader::find_or_load_texture(const
 
         if (embed->mHeight == 0)
         {
-            auto new_tex = ImageImport::load_raw(embed->mFilename.C_Str(), Gfx::BufferData(embed->pcData, 1, embed->mWidth));
+            auto new_tex = ImageImport::load_raw(embed->mFilename.C_Str(), Gfx::BufferData(embed->pcData, 1, embed->mWidth), payloads);
             textures.emplace(path, new_tex);
             return new_tex;
         }
@@ -110,7 +132,7 @@ TObjectRef<TextureAsset> AssimpImporter::SceneLoader::find_or_load_texture(const
                 TextureAsset::CreateInfos{.width = static_cast<uint32_t>(embed->mWidth), .height = static_cast<uint32_t>(embed->mHeight),
                                           .format = Gfx::ColorFormat::R8G8B8A8_UNORM});
 
-            auto new_tex = ImageImport::load_raw(embed->mFilename.C_Str(), Gfx::BufferData(embed->pcData, 1, embed->mWidth));
+            auto new_tex = ImageImport::load_raw(embed->mFilename.C_Str(), Gfx::BufferData(embed->pcData, 1, embed->mWidth), payloads);
             textures.emplace(path, new_tex);
             return new_tex;
         }
@@ -128,17 +150,13 @@ TObjectRef<TextureAsset> AssimpImporter::SceneLoader::find_or_load_texture(const
             LOG_FATAL("Failed to load texture {}", fs_path.string());
         }
 
-        auto new_tex = ImageImport::load_from_path(fs_path);
+        auto new_tex = ImageImport::load_from_path(fs_path, payloads);
         textures.emplace(path, new_tex);
         return new_tex;
     }
 }
 
 
-TObjectRef<TextureAsset> default_normal;
-TObjectRef<TextureAsset> default_mrao;
-
-
 TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_material_instance(int id)
 {
     if (auto found = materials.find(id); found != materials.end())
@@ -161,27 +179,14 @@ TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_mate
 
     auto new_mat = Engine::get().asset_registry().create<MaterialInstanceAsset>(std::string("MaterialInstance_") + mat->GetName().C_Str() + "_" + std::to_string(id), find_or_load_material(type));
 
-    if (!default_normal)
-    {
-        std::vector<uint8_t> pixels = {
-            0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0,
-        };
-        default_normal = Engine::get().asset_registry().create<TextureAsset>("DefaultNormal", std::vector{Gfx::BufferData(pixels.data(), 1, pixels.size())},
-                                                                             TextureAsset::CreateInfos{.width = 2, .height = 2, .format = Gfx::ColorFormat::R8G8B8A8_UNORM});
-
-    }
-    if (!default_mrao)
-    {
-        std::vector<uint8_t> pixels = {
-            0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0,
-        };
-        default_mrao = Engine::get().asset_registry().create<TextureAsset>("DefaultMrao", std::vector{Gfx::BufferData(pixels.data(), 1, pixels.size())},
-                                                                           TextureAsset::CreateInfos{.width = 2, .height = 2, .format = Gfx::ColorFormat::R8G8B8A8_UNORM});
-    }
+    // Created by the loader rather than shared with TextureAsset::get_default_asset(), so they are stored with the saved scenes
+    const auto default_albedo = get_default_texture("DefaultTexture", {0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0});
+    const auto default_normal = get_default_texture("DefaultNormal", {0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0});
+    const auto default_mrao   = get_default_texture("DefaultMrao", {0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0});
 
     new_mat->set_sampler("sSampler", get_sampler());
     if (mat->GetTextureCount(aiTextureType_DIFFUSE) == 0)
-        new_mat->set_texture("albedo", TextureAsset::get_default_asset());
+        new_mat->set_texture("albedo", default_albedo);
     if (mat->GetTextureCount(aiTextureType_NORMALS) == 0)
         new_mat->set_texture("normal_map", default_normal);
     if (mat->GetTextureCount(aiTextureType_DIFFUSE_ROUGHNESS) == 0)
@@ -194,7 +199,7 @@ TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_mate
         if (auto diffuse = find_or_load_texture(path.C_Str()))
             new_mat->set_texture("albedo", diffuse);
         else
-            new_mat->set_texture("albedo", TextureAsset::get_default_asset());
+            new_mat->set_texture("albedo", default_albedo);
         break;
     }
 
@@ -205,7 +210,7 @@ TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_mate
         if (auto normal = find_or_load_texture(path.C_Str()))
             new_mat->set_texture("normal_map", normal);
         else
-            new_mat->set_texture("normal_map", TextureAsset::get_default_asset());
+            new_mat->set_texture("normal_map", default_normal);
         break;
     }
 
@@ -216,10 +221,25 @@ TObjectRef<MaterialInstanceAsset> AssimpImporter::SceneLoader::find_or_load_mate
         if (auto normal = find_or_load_texture(path.C_Str()))
             new_mat->set_texture("mr_map", normal);
         else
-            new_mat->set_texture("mr_map", TextureAsset::get_default_asset());
+            new_mat->set_texture("mr_map", default_mrao);
         break;
     }
 
+    // Serialized scenes reference the material by its base and parameters
+    const std::string_view material_name = new_mat->get_name();
+    uint64_t               content_hash  = ankerl::unordered_dense::detail::wyhash::hash(material_name.data(), material_name.size()) ^ new_mat->get_base()->get_content_hash();
+    for (const auto& [binding, texture] : new_mat->get_textures())
+    {
+        const uint64_t hashes[3] = {content_hash, ankerl::unordered_dense::detail::wyhash::hash(binding.data(), binding.size()), texture->get_content_hash()};
+        content_hash             = ankerl::unordered_dense::detail::wyhash::hash(hashes, sizeof(hashes));
+    }
+    for (const auto& [binding, sampler] : new_mat->get_samplers())
+    {
+        const uint64_t hashes[3] = {content_hash, ankerl::unordered_dense::detail::wyhash::hash(binding.data(), binding.size()), sampler->get_content_hash()};
+        content_hash             = ankerl::unordered_dense::detail::wyhash::hash(hashes, sizeof(hashes));
+    }
+    new_mat->set_content_hash(content_hash);
+
     new_mat->prepare_for_passes("gbuffers");
     new_mat->prepare_for_passes("shadows");
 
@@ -260,6 +280,11 @@ TObjectRef<MaterialAsset> AssimpImporter::SceneLoader::find_or_load_material(Mat
                              StageInputOutputDescription{4, 44, Gfx::ColorFormat::R32G32B32_SFLOAT},
                              StageInputOutputDescription{5, 56, Gfx::ColorFormat::R32G32B32A32_SFLOAT},
                          });
+    const std::string shader_path = mat->get_shader_path().generic_string();
+    const uint64_t    hashes[2]   = {ankerl::unordered_dense::detail::wyhash::hash(shader_path.data(), shader_path.size()),
+                                     ankerl::unordered_dense::detail::wyhash::hash(mat->get_vertex_inputs().data(), mat->get_vertex_inputs().size() * sizeof(StageInputOutputDescription))};
+    mat->set_content_hash(ankerl::unordered_dense::detail::wyhash::hash(hashes, sizeof(hashes)));
+    mat->precompile({"gbuffers", "shadows"});
 
     return materials_base.emplace(type, mat).first->second;
 }
@@ -290,69 +315,87 @@ std::shared_ptr<AssimpImporter::SceneLoader::MeshSection> AssimpImporter::SceneL
             vertices[i].color = glm::vec4(mesh->mColors[0][i].r, mesh->mColors[0][i].g, mesh->mColors[0][i].b, mesh->mColors[0][i].a);
     }
 
-    if (mesh->mNumVertices <= UINT16_MAX)
+    std::vector<uint32_t> triangles;
+    triangles.reserve(static_cast<size_t>(mesh->mNumFaces) * 3);
+    for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
     {
-        uint32_t total_faces = mesh->mNumFaces;
-
-        std::vector<uint16_t> triangles(total_faces * 3);
-
-        for (uint32_t i = 0, initial_face = 0; i < total_faces; ++i, ++initial_face)
+        auto& face = mesh->mFaces[i];
+        if (face.mNumIndices == 3)
+            triangles.insert(triangles.end(), {face.mIndices[0], face.mIndices[1], face.mIndices[2]});
+        else if (face.mNumIndices == 4)
+            triangles.insert(triangles.end(), {face.mIndices[0], face.mIndices[1], face.mIndices[2], face.mIndices[0], face.mIndices[2], face.mIndices[3]});
+        else
         {
-            auto& face = mesh->mFaces[initial_face];
-            if (face.mNumIndices == 3)
-            {
-                triangles[i * 3]     = static_cast<uint16_t>(face.mIndices[0]);
-                triangles[i * 3 + 1] = static_cast<uint16_t>(face.mIndices[1]);
-                triangles[i * 3 + 2] = static_cast<uint16_t>(face.mIndices[2]);
-            }
-            else if (face.mNumIndices == 4)
-            {
-                triangles[i * 3]     = static_cast<uint16_t>(face.mIndices[0]);
-                triangles[i * 3 + 1] = static_cast<uint16_t>(face.mIndices[1]);
-                triangles[i * 3 + 2] = static_cast<uint16_t>(face.mIndices[2]);
-                ++total_faces;
-                triangles.resize(total_faces * 3);
-                ++i;
-                triangles[i * 3]     = static_cast<uint16_t>(face.mIndices[0]);
-                triangles[i * 3 + 1] = static_cast<uint16_t>(face.mIndices[2]);
-                triangles[i * 3 + 2] = static_cast<uint16_t>(face.mIndices[3]);
-            }
-            else
-            {
-                LOG_ERROR("Unsupported mesh topology : {} ({})", mesh->mName.C_Str(), face.mNumIndices);
-                meshes.emplace(id, nullptr);
-                return nullptr;
-            }
+            LOG_ERROR("Unsupported mesh topology : {} ({})", mesh->mName.C_Str(), face.mNumIndices);
+            meshes.emplace(id, nullptr);
+            return nullptr;
         }
-
-        auto base_buffer = Gfx::BufferData(triangles.data(), 2, triangles.size());
-        auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices, base_buffer.copy());
-        meshes.emplace(id, new_section);
-        return new_section;
     }
-    else
-    {
-        std::vector<uint32_t> triangles(static_cast<size_t>(mesh->mNumFaces) * 3);
 
-        for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
+    // Every lod shares the vertices of the full detail mesh, their indices are appended after the lod 0 ones
+    std::vector<MeshLod> lods;
+    if (generated_lods > 0)
+    {
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+            positions[i] = vertices[i].pos;
+
+        lods.emplace_back(0, static_cast<uint32_t>(triangles.size()), 0, 0.f);
+        std::vector<uint32_t> previous_lod = triangles;
+        std::vector<uint32_t> simplified;
+        for (uint32_t i = 0; i < generated_lods; ++i)
         {
-            auto& face = mesh->mFaces[i];
-            assert(face.mNumIndices == 3);
-            triangles[i * 3]     = face.mIndices[0];
-            triangles[i * 3 + 1] = face.mIndices[1];
-            triangles[i * 3 + 2] = face.mIndices[2];
+            const size_t target_index_count = static_cast<size_t>(static_cast<float>(previous_lod.size()) * lod_triangle_ratio) / 3 * 3;
+            const float  error              = MeshSimplifier::simplify(positions, previous_lod, target_index_count, simplified);
+            // Stop once the borders and seams prevent any significant reduction
+            if (error < 0 || simplified.size() * 10 > previous_lod.size() * 9)
+                break;
+
+            lods.emplace_back(static_cast<uint32_t>(triangles.size()), static_cast<uint32_t>(simplified.size()), 0, lods.back().error + error);
+            triangles.insert(triangles.end(), simplified.begin(), simplified.end());
+            previous_lod.swap(simplified);
         }
-        auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices,
-                                                         Gfx::BufferData(triangles.data(), 4, triangles.size()).copy());
-        meshes.emplace(id, new_section);
-        return new_section;
+        if (lods.size() == 1)
+            lods.clear();
     }
+
+    std::shared_ptr<Gfx::BufferData> indices;
+    if (mesh->mNumVertices <= UINT16_MAX)
+    {
+        std::vector<uint16_t> short_triangles(triangles.begin(), triangles.end());
+        indices = Gfx::BufferData(short_triangles.data(), 2, short_triangles.size()).copy();
+    }
+    else
+        indices = Gfx::BufferData(triangles.data(), 4, triangles.size()).copy();
+
+    auto new_section = std::make_shared<MeshSection>(std::string(mesh->mName.C_Str()) + "_" + std::to_string(id), find_or_load_material_instance(mesh->mMaterialIndex), vertices, indices, lods);
+    meshes.emplace(id, new_section);
+    return new_section;
 }
 
 TObjectRef<SamplerAsset> AssimpImporter::SceneLoader::get_sampler()
 {
     if (!sampler)
+    {
         sampler = Engine::get().asset_registry().create<SamplerAsset>("Sampler");
+        // Samplers have no parameters yet : they are all the same
+        sampler->set_content_hash(ankerl::unordered_dense::detail::wyhash::hash("Sampler", 7));
+    }
     return sampler;
 }
+
+TObjectRef<TextureAsset> AssimpImporter::SceneLoader::get_default_texture(const std::string& name, const std::vector<uint8_t>& pixels)
+{
+    if (auto found = default_textures.find(name); found != default_textures.end())
+        return found->second;
+
+    const std::vector               mips{Gfx::BufferData(pixels.data(), 1, pixels.size())};
+    const TextureAsset::CreateInfos infos{.width = 2, .height = 2, .format = Gfx::ColorFormat::R8G8B8A8_UNORM};
+    auto                            texture      = Engine::get().asset_registry().create<TextureAsset>(name, mips, infos);
+    const uint64_t                  content_hash = ankerl::unordered_dense::detail::wyhash::hash(pixels.data(), pixels.size());
+    texture->set_content_hash(content_hash);
+    if (payloads)
+        payloads->add_texture(content_hash, mips, infos);
+    return default_textures.emplace(name, texture).first->second;
+}
 } // namespace Eng
\ No newline at end of file
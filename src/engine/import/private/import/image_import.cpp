@@ -5,6 +5,7 @@
 #include "gfx/vulkan/buffer.hpp"
 #include "object_ptr.hpp"
 #include "profiler.hpp"
+#include "scene/scene_serializer.hpp"
 #include <vulkan/vulkan.h>
 #include "dds_image/dds.hpp"
 
@@ -42,16 +43,27 @@ struct FreeImageInitializer
 
 static FreeImageInitializer _initializer;
 
-TObjectRef<TextureAsset> ImageImport::load_from_path(const std::filesystem::path& path)
+TObjectRef<TextureAsset> ImageImport::load_from_path(const std::filesystem::path& path, AssetPayloads* payloads)
 {
     std::ifstream        input(path, std::ios::binary);
     std::vector<uint8_t> buffer(std::istreambuf_iterator(input), {});
-    return load_raw(path.filename().string(), Gfx::BufferData(buffer.data(), 1, buffer.size()));
+    return load_raw(path.filename().string(), Gfx::BufferData(buffer.data(), 1, buffer.size()), payloads);
 }
 
-TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, const Gfx::BufferData& raw)
+static TObjectRef<TextureAsset> create_texture(const std::string& file_name, uint64_t content_hash, const std::vector<Gfx::BufferData>& mips, const TextureAsset::CreateInfos& infos,
+                                               AssetPayloads* payloads)
+{
+    const auto texture = Engine::get().asset_registry().create<TextureAsset>(file_name, mips, infos);
+    texture->set_content_hash(content_hash);
+    if (payloads)
+        payloads->add_texture(content_hash, mips, infos);
+    return texture;
+}
+
+TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, const Gfx::BufferData& raw, AssetPayloads* payloads)
 {
     PROFILER_SCOPE_NAMED(LoadImage, std::format("Load image {}", file_name));
+    const uint64_t content_hash = ankerl::unordered_dense::detail::wyhash::hash(raw.data(), raw.get_byte_size());
 
     if (std::filesystem::path(file_name).extension() == ".dds")
     {
@@ -71,15 +83,16 @@ TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, con
             for (const auto& mip : image.mipmaps)
                 mips.emplace_back(mip.data(), 1, mip.size());
 
-        const auto text = Engine::get().asset_registry().create<TextureAsset>(
-            file_name, mips,
+        const auto text = create_texture(
+            file_name, content_hash, mips,
             TextureAsset::CreateInfos{
                 .width = image.width,
                 .height = image.height,
                 .depth = image.depth,
                 .format = static_cast<Gfx::ColorFormat>(dds::getVulkanFormat(image.format, image.supportsAlpha)),
                 .array_size = image.arraySize
-            });
+            },
+            payloads);
 
         return text;
     }
@@ -110,12 +123,13 @@ TObjectRef<TextureAsset> ImageImport::load_raw(const std::string& file_name, con
         uint32_t x = FreeImage_GetWidth(converted);
         uint32_t y = FreeImage_GetHeight(converted);
 
-        const auto text = Engine::get().asset_registry().create<TextureAsset>(file_name, std::vector{Gfx::BufferData(FreeImage_GetBits(converted), 1, x * y * 4)},
-                                                                              TextureAsset::CreateInfos{
-                                                                                  .width = x,
-                                                                                  .height = y,
-                                                                                  .format = Gfx::ColorFormat::R8G8B8A8_UNORM
-                                                                              });
+        const auto text = create_texture(file_name, content_hash, std::vector{Gfx::BufferData(FreeImage_GetBits(converted), 1, x * y * 4)},
+                                         TextureAsset::CreateInfos{
+                                             .width = x,
+                                             .height = y,
+                                             .format = Gfx::ColorFormat::R8G8B8A8_UNORM
+                                         },
+                                         payloads);
 
         FreeImage_Unload(converted);
         return text;
@@ -0,0 +1,146 @@
+#include "import/mesh_simplifier.hpp"
+
+#include "profiler.hpp"
+
+#include <ankerl/unordered_dense.h>
+#include <functional>
+#include <queue>
+#include <glm/geometric.hpp>
+
+namespace Eng
+{
+struct EdgeCollapse
+{
+    float    length;
+    uint32_t from;
+    uint32_t to;
+
+    bool operator>(const EdgeCollapse& other) const
+    {
+        return length > other.length;
+    }
+};
+
+static uint64_t edge_key(uint32_t a, uint32_t b)
+{
+    return a < b ? static_cast<uint64_t>(a) << 32 | b : static_cast<uint64_t>(b) << 32 | a;
+}
+
+float MeshSimplifier::simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t target_index_count, std::vector<uint32_t>& out_indices)
+{
+    PROFILER_SCOPE(SimplifyMesh);
+
+    const size_t                       triangle_count = indices.size() / 3;
+    std::vector<uint32_t>              triangles(indices.begin(), indices.begin() + triangle_count * 3);
+    std::vector<bool>                  alive_triangles(triangle_count, true);
+    std::vector<std::vector<uint32_t>> vertex_triangles(positions.size());
+
+    ankerl::unordered_dense::map<uint64_t, uint32_t> edge_use;
+    for (uint32_t t = 0; t < triangle_count; ++t)
+        for (uint32_t c = 0; c < 3; ++c)
+        {
+            vertex_triangles[triangles[t * 3 + c]].emplace_back(t);
+            ++edge_use[edge_key(triangles[t * 3 + c], triangles[t * 3 + (c + 1) % 3])];
+        }
+
+    // Edges used by a single triangle are borders or attribute seams : their vertices must stay in place
+    std::vector<bool> locked(positions.size(), false);
+    for (const auto& [key, count] : edge_use)
+        if (count == 1)
+        {
+            locked[key >> 32]        = true;
+            locked[key & 0xFFFFFFFF] = true;
+        }
+
+    std::priority_queue<EdgeCollapse, std::vector<EdgeCollapse>, std::greater<>> queue;
+
+    auto push_edge = [&](uint32_t a, uint32_t b)
+    {
+        const float length = distance(positions[a], positions[b]);
+        if (!locked[a])
+            queue.emplace(length, a, b);
+        if (!locked[b])
+            queue.emplace(length, b, a);
+    };
+
+    for (const auto& [key, count] : edge_use)
+        push_edge(static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key & 0xFFFFFFFF));
+
+    std::vector<bool>  removed(positions.size(), false);
+    std::vector<float> vertex_error(positions.size(), 0.f);
+    size_t             alive_count = triangle_count;
+    float              max_error   = 0;
+
+    while (alive_count * 3 > target_index_count && !queue.empty())
+    {
+        const EdgeCollapse collapse = queue.top();
+        queue.pop();
+        if (removed[collapse.from] || removed[collapse.to])
+            continue;
+
+        // Entries are never updated in the queue : skip the edges destroyed by previous collapses, and the collapses that would flip a triangle
+        bool shares_triangle = false;
+        bool flips           = false;
+        for (uint32_t t : vertex_triangles[collapse.from])
+        {
+            if (!alive_triangles[t])
+                continue;
+            const uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+            {
+                shares_triangle = true;
+                continue;
+            }
+
+            glm::vec3 moved[3];
+            for (uint32_t c = 0; c < 3; ++c)
+                moved[c] = positions[tri[c] == collapse.from ? collapse.to : tri[c]];
+            const glm::vec3 before = cross(positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]]);
+            const glm::vec3 after  = cross(moved[1] - moved[0], moved[2] - moved[0]);
+            if (dot(before, after) <= 0)
+            {
+                flips = true;
+                break;
+            }
+        }
+        if (!shares_triangle || flips)
+            continue;
+
+        removed[collapse.from]    = true;
+        vertex_error[collapse.to] = std::max(vertex_error[collapse.to], vertex_error[collapse.from] + collapse.length);
+        max_error                 = std::max(max_error, vertex_error[collapse.to]);
+
+        for (uint32_t t : vertex_triangles[collapse.from])
+        {
+            if (!alive_triangles[t])
+                continue;
+            uint32_t* tri = &triangles[t * 3];
+            if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to)
+            {
+                alive_triangles[t] = false;
+                --alive_count;
+                continue;
+            }
+
+            for (uint32_t c = 0; c < 3; ++c)
+                if (tri[c] == collapse.from)
+                    tri[c] = collapse.to;
+            vertex_triangles[collapse.to].emplace_back(t);
+            for (uint32_t c = 0; c < 3; ++c)
+                if (tri[c] != collapse.to)
+                    push_edge(collapse.to, tri[c]);
+        }
+        vertex_triangles[collapse.from].clear();
+    }
+
+    if (alive_count == triangle_count)
+        return -1.f;
+
+    out_indices.clear();
+    out_indices.reserve(alive_count * 3);
+    for (uint32_t t = 0; t < triangle_count; ++t)
+        if (alive_triangles[t])
+            out_indices.insert(out_indices.end(), triangles.begin() + t * 3, triangles.begin() + t * 3 + 3);
+    return max_error;
+}
+} // namespace Eng
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/vec3.hpp>
+
+namespace Eng
+{
+class MeshSimplifier
+{
+  public:
+    /**
+     * Collapse the shortest edges of an indexed triangle list until it contains at most target_index_count indices.
+     * Collapsed vertices are merged into one of their neighbours instead of being moved, so the source vertex buffer stays valid for every generated lod.
+     * Open borders (including uv / normal seams) are locked to avoid cracks.
+     * @return the max distance (object space) a vertex travelled because of the collapses, or a negative value if nothing could be simplified
+     */
+    static float simplify(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& indices, size_t target_index_count, std::vector<uint32_t>& out_indices);
+};
+} // namespace Eng
@@ -22,6 +22,7 @@ class path;
 
 namespace Eng
 {
+class AssetPayloads;
 class Scene;
 
 class SamplerAsset;
@@ -52,7 +53,8 @@ class AssimpImporter
 
     struct SceneLoader
     {
-        SceneLoader(const std::filesystem::path& in_file_path, const aiScene* in_scene, Scene& output_scene);
+        SceneLoader(const std::filesystem::path& in_file_path, const aiScene* in_scene, Scene& output_scene, uint32_t in_generated_lods = 0, float in_lod_triangle_ratio = 0.5f,
+                    AssetPayloads* in_payloads = nullptr);
 
         void decompose_node(aiNode* node, TObjectRef<SceneComponent> parent, Scene& output_scene);
 
@@ -62,6 +64,7 @@ class AssimpImporter
             TObjectRef<MaterialInstanceAsset> mat;
             std::vector<MeshAsset::Vertex>    vertices;
             std::shared_ptr<Gfx::BufferData>  indices;
+            std::vector<MeshLod>              lods;
         };
 
         TObjectRef<TextureAsset>          find_or_load_texture(const std::string& path);
@@ -69,19 +72,29 @@ class AssimpImporter
         TObjectRef<MaterialAsset>         find_or_load_material(MaterialType type);
         std::shared_ptr<MeshSection>      find_or_load_mesh(int id);
         TObjectRef<SamplerAsset>          get_sampler();
+        TObjectRef<TextureAsset>          get_default_texture(const std::string& name, const std::vector<uint8_t>& pixels);
 
         ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>   textures;
+        ankerl::unordered_dense::map<std::string, TObjectRef<TextureAsset>>   default_textures;
         ankerl::unordered_dense::map<int, TObjectRef<MaterialInstanceAsset>>  materials;
         ankerl::unordered_dense::map<int, std::shared_ptr<MeshSection>>       meshes;
         TObjectRef<SamplerAsset>                                    sampler;
         const aiScene*                                              scene;
         ankerl::unordered_dense::map<MaterialType, TObjectRef<MaterialAsset>> materials_base;
         std::filesystem::path                                       file_path;
+        uint32_t                                                    generated_lods;
+        float                                                       lod_triangle_ratio;
+        AssetPayloads*                                              payloads;
     };
 
-    Scene load_from_path(const std::filesystem::path& path) const;
+    // The CPU data of the created textures and meshes is recorded in the payloads if any (see SceneSerializer::save())
+    Scene load_from_path(const std::filesystem::path& path, AssetPayloads* payloads = nullptr) const;
 
     std::shared_ptr<Assimp::Importer> importer;
+
+    // Simplified lods generated for each mesh section (0 to disable). Each lod keeps lod_triangle_ratio of the previous lod's triangles.
+    uint32_t generated_lods     = 0;
+    float    lod_triangle_ratio = 0.5f;
 };
 
 } // namespace Eng
\ No newline at end of file
@@ -17,12 +17,14 @@ namespace Gfx
 class BufferData;
 }
 
+class AssetPayloads;
 class TextureAsset;
 
 class ImageImport
 {
   public:
-    static TObjectRef<TextureAsset> load_from_path(const std::filesystem::path& path);
-    static TObjectRef<TextureAsset> load_raw(const std::string& file_name, const Gfx::BufferData& raw);
+    // The content hash of the texture is the hash of the encoded image. Its decoded mips are recorded in the payloads if any.
+    static TObjectRef<TextureAsset> load_from_path(const std::filesystem::path& path, AssetPayloads* payloads = nullptr);
+    static TObjectRef<TextureAsset> load_raw(const std::string& file_name, const Gfx::BufferData& raw, AssetPayloads* payloads = nullptr);
 };
 } // namespace Eng
\ No newline at end of file
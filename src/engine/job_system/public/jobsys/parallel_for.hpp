@@ -0,0 +1,27 @@
+#pragma once
+
+#include "job_sys.hpp"
+
+#include <vector>
+
+namespace JobSys
+{
+/**
+ * Run callback(job_index) for each job in [0, job_count[. The first job runs on the calling thread.
+ */
+template <typename Lambda> void parallel_for(size_t job_count, const Lambda& callback)
+{
+    std::vector<JobHandle<void>> handles;
+    handles.reserve(job_count);
+    for (size_t i = 1; i < job_count; ++i)
+        handles.emplace_back(JobSystem::get().schedule(
+            [&callback, i]
+            {
+                callback(i);
+            }));
+    if (job_count > 0)
+        callback(0);
+    for (const auto& handle : handles)
+        handle.await();
+}
+} // namespace JobSys
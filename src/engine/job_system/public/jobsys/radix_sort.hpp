@@ -0,0 +1,75 @@
+#pragma once
+
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace JobSys
+{
+/**
+ * Stable LSD radix sort on 64 bits keys (8 bits per pass). Histograms and scatters are split across the job system workers.
+ * Passes where every key share the same digit are skipped, so sparse keys only cost the digits they really use.
+ */
+template <typename T, typename KeyFn> void radix_sort(std::vector<T>& items, const KeyFn& get_key, size_t min_items_per_job = 4096)
+{
+    constexpr size_t   radix_bits = 8;
+    constexpr size_t   buckets    = 1ull << radix_bits;
+    constexpr uint64_t digit_mask = buckets - 1;
+
+    if (items.size() < 2)
+        return;
+
+    const size_t job_count = std::clamp<size_t>((items.size() + min_items_per_job - 1) / min_items_per_job, 1, std::max<size_t>(1, JobSystem::get().get_workers().size()));
+
+    // Bits that differs between at least two keys
+    const uint64_t first_key = get_key(items[0]);
+    uint64_t       diff_bits = 0;
+    for (const auto& item : items)
+        diff_bits |= get_key(item) ^ first_key;
+    if (diff_bits == 0)
+        return;
+
+    std::vector<T>                           scratch(items.size());
+    std::vector<std::array<size_t, buckets>> histograms(job_count);
+
+    for (size_t shift = 0; shift < 64; shift += radix_bits)
+    {
+        if ((diff_bits >> shift & digit_mask) == 0)
+            continue;
+
+        parallel_for(job_count,
+                     [&](size_t job)
+                     {
+                         auto& histogram = histograms[job];
+                         histogram.fill(0);
+                         const size_t end = items.size() * (job + 1) / job_count;
+                         for (size_t i = items.size() * job / job_count; i < end; ++i)
+                             ++histogram[get_key(items[i]) >> shift & digit_mask];
+                     });
+
+        // Exclusive prefix sum : bucket major, job minor to keep the sort stable
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < buckets; ++bucket)
+            for (auto& histogram : histograms)
+            {
+                const size_t count = histogram[bucket];
+                histogram[bucket]  = offset;
+                offset += count;
+            }
+
+        parallel_for(job_count,
+                     [&](size_t job)
+                     {
+                         auto&        histogram = histograms[job];
+                         const size_t end       = items.size() * (job + 1) / job_count;
+                         for (size_t i = items.size() * job / job_count; i < end; ++i)
+                             scratch[histogram[get_key(items[i]) >> shift & digit_mask]++] = std::move(items[i]);
+                     });
+
+        items.swap(scratch);
+    }
+}
+} // namespace JobSys
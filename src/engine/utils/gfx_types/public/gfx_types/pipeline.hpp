@@ -9,6 +9,9 @@ namespace Eng::Gfx
 {
 using RenderPass = std::string;
 
+// Descriptor set of the global bindless table (see BindlessTable). Every other binding lives in set 0.
+constexpr uint32_t BINDLESS_DESCRIPTOR_SET = 1;
+
 enum class EBindingType
 {
     SAMPLER,
@@ -1,5 +1,6 @@
 #pragma once
 #include <iostream>
+#include <new>
 #include <string>
 #include <ankerl/unordered_dense.h>
 #include <vector>
@@ -28,6 +29,13 @@ public:
     {
         static_assert(StaticClassInfos<ClassName>::value, "Failed to register class : not a reflected class. Please add the REFLECT_BODY macro to it.");
         Class* new_class = new Class(in_class_name, sizeof(ClassName));
+        if constexpr (requires { ClassName::class_flags; })
+            new_class->flags = static_cast<uint32_t>(ClassName::class_flags);
+        if constexpr (requires(void* ptr) { new (ptr) ClassName(); })
+            new_class->construct_func = [](void* ptr)
+            {
+                new (ptr) ClassName();
+            };
         register_class_internal(new_class);
         return new_class;
     }
@@ -47,6 +55,28 @@ public:
         return type_size;
     }
 
+    /**
+     * User defined flags, read from the optional "static constexpr uint32_t class_flags" member of the reflected class (inherited like any static member)
+     */
+    uint32_t get_flags() const
+    {
+        return flags;
+    }
+
+    /**
+     * Classes with an accessible default constructor can be instantiated from their reflected class
+     */
+    bool can_construct() const
+    {
+        return construct_func != nullptr;
+    }
+
+    // Default construct an object of this class in the given memory (stride() bytes)
+    void construct(void* ptr) const
+    {
+        construct_func(ptr);
+    }
+
     template <typename Type> static size_t make_type_id()
     {
         return std::hash<std::string>{}(StaticClassInfos<Type>::name);
@@ -54,6 +84,7 @@ public:
 
     using CastFunc      = void*(*)(const Class*, void*);
     using CastFuncConst = const void*(*)(const Class*, const void*);
+    using ConstructFunc = void (*)(void*);
 
     struct CastFuncWrapper
     {
@@ -138,7 +169,9 @@ private:
     std::vector<Class*>                                   parents = {};
     ankerl::unordered_dense::map<size_t, CastFuncWrapper> cast_functions;
 
-    size_t type_size = 0;
-    size_t type_id   = 0;
+    size_t        type_size      = 0;
+    size_t        type_id        = 0;
+    uint32_t      flags          = 0;
+    ConstructFunc construct_func = nullptr;
 };
 } // namespace Reflection
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "shader_cache.hpp"
+
+#include "logger.hpp"
+#include "slang.h"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <ranges>
+#include <thread>
+
+namespace ShaderCompiler
+{
+// Increment when the entry layout or the compiler options change
+static constexpr uint32_t CACHE_VERSION = 1;
+static constexpr uint32_t CACHE_MAGIC   = 0x43565053; // "SPVC"
+
+static uint64_t hash_bytes(std::string_view data)
+{
+    return ankerl::unordered_dense::hash<std::string_view>{}(data);
+}
+
+static std::optional<uint64_t> hash_file(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return {};
+    const std::string content((std::istreambuf_iterator(file)), std::istreambuf_iterator<char>());
+    return hash_bytes(content);
+}
+
+class CacheWriter
+{
+public:
+    template <typename T> void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+        data.insert(data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void write(const std::string& value)
+    {
+        write(static_cast<uint64_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+    }
+
+    void write(const std::vector<uint8_t>& value)
+    {
+        write(static_cast<uint64_t>(value.size()));
+        data.insert(data.end(), value.begin(), value.end());
+    }
+
+    std::vector<uint8_t> data;
+};
+
+class CacheReader
+{
+public:
+    CacheReader(const std::vector<uint8_t>& in_data) : data(in_data)
+    {
+    }
+
+    template <typename T> T read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (check(sizeof(T)))
+            std::memcpy(&value, data.data() + position, sizeof(T));
+        position += sizeof(T);
+        return value;
+    }
+
+    std::string read_string()
+    {
+        const auto  size = read<uint64_t>();
+        std::string value;
+        if (check(size))
+            value.assign(reinterpret_cast<const char*>(data.data() + position), size);
+        position += size;
+        return value;
+    }
+
+    std::vector<uint8_t> read_bytes()
+    {
+        const auto           size = read<uint64_t>();
+        std::vector<uint8_t> value;
+        if (check(size))
+            value.assign(data.begin() + static_cast<ptrdiff_t>(position), data.begin() + static_cast<ptrdiff_t>(position + size));
+        position += size;
+        return value;
+    }
+
+    // False once a read went past the end of the data
+    bool valid() const
+    {
+        return b_valid;
+    }
+
+private:
+    bool check(uint64_t size)
+    {
+        b_valid = b_valid && size <= data.size() && position <= data.size() - size;
+        return b_valid;
+    }
+
+    const std::vector<uint8_t>& data;
+    uint64_t                    position = 0;
+    bool                        b_valid  = true;
+};
+
+ShaderCache::ShaderCache(std::filesystem::path in_directory) : directory(std::move(in_directory))
+{
+}
+
+std::string ShaderCache::make_key(const std::filesystem::path& source, const std::string& render_pass, const Eng::Gfx::PermutationDescription& permutation)
+{
+    std::string key = std::format("{}|{}|{}|{}", CACHE_VERSION, spGetBuildTagString(), std::filesystem::absolute(source).generic_string(), render_pass);
+    for (const auto& switch_key : permutation.keys())
+        key += std::format("|{}={}", switch_key, permutation.get(switch_key));
+    return std::format("{:016x}", hash_bytes(key));
+}
+
+std::optional<CompilationResult> ShaderCache::load(const std::string& key, std::vector<std::filesystem::path>& out_dependencies) const
+{
+    if (directory.empty())
+        return {};
+
+    std::ifstream file(directory / (key + ".bin"), std::ios::binary);
+    if (!file)
+        return {};
+    const std::vector<uint8_t> data((std::istreambuf_iterator(file)), std::istreambuf_iterator<char>());
+    CacheReader                reader(data);
+
+    if (reader.read<uint32_t>() != CACHE_MAGIC || reader.read<uint32_t>() != CACHE_VERSION)
+        return {};
+
+    std::vector<std::filesystem::path> dependencies;
+    const auto                         dependency_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < dependency_count && reader.valid(); ++i)
+    {
+        std::filesystem::path path = reader.read_string();
+        const auto            hash = reader.read<uint64_t>();
+        if (hash_file(path) != hash)
+            return {};
+        dependencies.emplace_back(std::move(path));
+    }
+
+    CompilationResult result;
+    const auto        stage_count = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < stage_count && reader.valid(); ++i)
+    {
+        StageData stage;
+        stage.stage           = reader.read<Eng::Gfx::EShaderStage>();
+        stage.compiled_module = reader.read_bytes();
+
+        const auto binding_count = reader.read<uint32_t>();
+        for (uint32_t b = 0; b < binding_count && reader.valid(); ++b)
+        {
+            auto       name           = reader.read_string();
+            const auto binding        = reader.read<uint32_t>();
+            const auto type           = reader.read<Eng::Gfx::EBindingType>();
+            const auto array_elements = reader.read<uint32_t>();
+            stage.bindings.emplace_back(std::move(name), binding, type, array_elements);
+        }
+
+        const auto input_count = reader.read<uint32_t>();
+        for (uint32_t in = 0; in < input_count && reader.valid(); ++in)
+        {
+            auto name = reader.read_string();
+            stage.inputs.insert_or_assign(std::move(name), reader.read<StageInputOutputDescription>());
+        }
+
+        stage.push_constant_size = reader.read<uint32_t>();
+        const auto field_count   = reader.read<uint32_t>();
+        for (uint32_t f = 0; f < field_count && reader.valid(); ++f)
+        {
+            auto name = reader.read_string();
+            stage.push_constant_fields.insert_or_assign(std::move(name), reader.read<uint32_t>());
+        }
+        stage.b_uses_bindless = reader.read<uint8_t>() != 0;
+        result.stages.insert_or_assign(stage.stage, std::move(stage));
+    }
+
+    if (!reader.valid())
+    {
+        LOG_WARNING("Ignoring corrupted shader cache entry {}", key);
+        return {};
+    }
+    out_dependencies = std::move(dependencies);
+    return result;
+}
+
+void ShaderCache::save(const std::string& key, const CompilationResult& result, const std::vector<std::filesystem::path>& dependencies) const
+{
+    if (directory.empty() || !result.errors.empty())
+        return;
+
+    CacheWriter writer;
+    writer.write(CACHE_MAGIC);
+    writer.write(CACHE_VERSION);
+
+    writer.write(static_cast<uint32_t>(dependencies.size()));
+    for (const auto& dependency : dependencies)
+    {
+        const auto hash = hash_file(dependency);
+        if (!hash)
+            return;
+        writer.write(dependency.generic_string());
+        writer.write(*hash);
+    }
+
+    writer.write(static_cast<uint32_t>(result.stages.size()));
+    for (const auto& stage : result.stages | std::views::values)
+    {
+        writer.write(stage.stage);
+        writer.write(stage.compiled_module);
+
+        writer.write(static_cast<uint32_t>(stage.bindings.size()));
+        for (const auto& binding : stage.bindings)
+        {
+            writer.write(binding.name);
+            writer.write(binding.binding);
+            writer.write(binding.type);
+            writer.write(binding.array_elements);
+        }
+
+        writer.write(static_cast<uint32_t>(stage.inputs.size()));
+        for (const auto& [name, input] : stage.inputs)
+        {
+            writer.write(name);
+            writer.write(input);
+        }
+
+        writer.write(stage.push_constant_size);
+        writer.write(static_cast<uint32_t>(stage.push_constant_fields.size()));
+        for (const auto& [name, offset] : stage.push_constant_fields)
+        {
+            writer.write(name);
+            writer.write(offset);
+        }
+        writer.write(static_cast<uint8_t>(stage.b_uses_bindless));
+    }
+
+    // Another session may write the same entry : each one goes through its own temporary file
+    std::error_code error;
+    create_directories(directory, error);
+    const auto path     = directory / (key + ".bin");
+    const auto tmp_path = directory / std::format("{}.{}.tmp", key, std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+        std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(writer.data.data()), static_cast<std::streamsize>(writer.data.size()));
+        if (!file)
+        {
+            LOG_WARNING("Failed to write shader cache entry '{}'", tmp_path.string());
+            return;
+        }
+    }
+    std::filesystem::rename(tmp_path, path, error);
+    if (error)
+        LOG_WARNING("Failed to write shader cache entry '{}' : {}", path.string(), error.message());
+}
+} // namespace ShaderCompiler
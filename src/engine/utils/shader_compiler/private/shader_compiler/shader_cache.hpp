@@ -0,0 +1,30 @@
+#pragma once
+#include "shader_compiler/shader_compiler.hpp"
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace ShaderCompiler
+{
+/**
+ * On-disk cache of compilation results : SPIR-V and reflection of every stage. An entry is keyed by the source, render pass, permutation and compiler
+ * version, and stores the content hash of every file the module was built from, so an edited include invalidates it too.
+ */
+class ShaderCache
+{
+public:
+    ShaderCache(std::filesystem::path directory);
+
+    static std::string make_key(const std::filesystem::path& source, const std::string& render_pass, const Eng::Gfx::PermutationDescription& permutation);
+
+    // Empty if the entry is missing or any of its files changed. Otherwise out_dependencies gets the files the entry was built from.
+    std::optional<CompilationResult> load(const std::string& key, std::vector<std::filesystem::path>& out_dependencies) const;
+
+    void save(const std::string& key, const CompilationResult& result, const std::vector<std::filesystem::path>& dependencies) const;
+
+private:
+    std::filesystem::path directory;
+};
+} // namespace ShaderCompiler
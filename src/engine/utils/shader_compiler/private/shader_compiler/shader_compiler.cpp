@@ -1,17 +1,25 @@
 #include "shader_compiler/shader_compiler.hpp"
 
 #include "logger.hpp"
+#include "profiler.hpp"
+#include "shader_cache.hpp"
 #include "slang-com-ptr.h"
 #include "slang.h"
 #include "slang_helper.hpp"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <mutex>
+#include <regex>
+#include <thread>
 
 namespace ShaderCompiler
 {
 static Compiler* compiler_instance = nullptr;
 
+static const char* search_paths[] = {"resources/shaders"};
+
 Compiler& Compiler::get()
 {
     if (!compiler_instance)
@@ -21,66 +29,190 @@ Compiler& Compiler::get()
 
 Compiler::~Compiler()
 {
-    global_session->release();
+    if (global_session)
+        global_session->release();
 }
 
 std::shared_ptr<Session> Compiler::create_session(const std::filesystem::path& path)
 {
-    return std::shared_ptr<Session>(new Session(this, path));
+    std::lock_guard lk(sessions_lock);
+    auto&           existing = sessions[path.generic_string()];
+    if (auto session = existing.lock(); session && session->is_up_to_date())
+        return session;
+    auto session = std::shared_ptr<Session>(new Session(this, path));
+    existing     = session;
+    return session;
+}
+
+Compiler::Compiler() : cache(std::make_unique<ShaderCache>("saved/shader_cache")), max_contexts(std::max(std::thread::hardware_concurrency(), 1u))
+{
+}
+
+void Compiler::set_max_contexts(size_t count)
+{
+    max_contexts = std::max<size_t>(count, 1);
+}
+
+slang::IGlobalSession* Compiler::get_global_session()
+{
+    if (!global_session)
+    {
+        PROFILER_SCOPE(CreateSlangGlobalSession);
+        if (SLANG_FAILED(createGlobalSession(&global_session)))
+        {
+            std::cerr << "Failed to create global slang compiler session\n";
+            exit(-1);
+        }
+    }
+    return global_session;
+}
+
+Session::Session(Compiler* in_compiler, const std::filesystem::path& path) : compiler(in_compiler), module_path(path), source_path(find_source(path))
+{
+    if (source_path)
+    {
+        source_time             = last_write_time(*source_path);
+        permutation_description = parse_permutation_group(*source_path);
+    }
+}
+
+bool Session::is_up_to_date() const
+{
+    std::error_code error;
+    if (!source_path || last_write_time(*source_path, error) != source_time || error)
+        return false;
+
+    // The imported modules and included files
+    std::lock_guard lk(dependencies_lock);
+    for (const auto& [path, write_time] : dependency_times)
+        if (last_write_time(path, error) != write_time || error)
+            return false;
+    return true;
 }
 
-Compiler::Compiler()
+void Session::track_dependencies(const std::vector<std::filesystem::path>& dependencies) const
 {
-    if (SLANG_FAILED(createGlobalSession(&global_session)))
+    std::lock_guard lk(dependencies_lock);
+    for (const auto& dependency : dependencies)
     {
-        std::cerr << "Failed to create global slang compiler session\n";
-        exit(-1);
+        if (dependency_times.contains(dependency.generic_string()))
+            continue;
+        std::error_code error;
+        if (const auto write_time = last_write_time(dependency, error); !error)
+            dependency_times.emplace(dependency.generic_string(), write_time);
     }
 }
 
-Session::Session(Compiler* in_compiler, const std::filesystem::path& path) : compiler(in_compiler)
+std::optional<std::filesystem::path> Session::find_source(const std::filesystem::path& module_name)
+{
+    auto file_name = module_name;
+    if (!file_name.has_extension())
+        file_name += ".slang";
+    if (exists(file_name))
+        return file_name;
+
+    // Slang also looks for the module name with its underscores replaced by dashes
+    auto dashed_name = file_name.string();
+    std::ranges::replace(dashed_name, '_', '-');
+    for (const char* search_path : search_paths)
+        for (const auto& candidate : {std::filesystem::path(search_path) / file_name, std::filesystem::path(search_path) / dashed_name})
+            if (exists(candidate))
+                return candidate;
+    return {};
+}
+
+std::unique_ptr<Session::SlangContext> Session::create_context() const
 {
-    std::lock_guard    lk(session_lock);
-    std::lock_guard    lk2(in_compiler->global_session_lock);
+    PROFILER_SCOPE_NAMED(LoadSlangModule, "Load shader module " + module_path.string());
+    auto               context = std::make_unique<SlangContext>();
+    std::lock_guard    lk(compiler->global_session_lock);
+    const auto         global_session = compiler->get_global_session();
     slang::SessionDesc sessionDesc;
 
     // Target
     slang::TargetDesc targetDesc;
     targetDesc.format  = SLANG_SPIRV;
-    targetDesc.profile = compiler->global_session->findProfile("spirv_1_5");
+    targetDesc.profile = global_session->findProfile("spirv_1_5");
     if (targetDesc.profile == SLANG_PROFILE_UNKNOWN)
     {
-        load_errors.emplace_back("Failed to find slang profile 'spirv_1_5'");
-        return;
+        context->load_errors.emplace_back("Failed to find slang profile 'spirv_1_5'");
+        return context;
     }
     sessionDesc.targets                 = &targetDesc;
     sessionDesc.targetCount             = 1;
     sessionDesc.defaultMatrixLayoutMode = SLANG_MATRIX_LAYOUT_COLUMN_MAJOR;
 
     // Search paths
-    const char* searchPaths[]   = {"resources/shaders"};
-    sessionDesc.searchPaths     = searchPaths;
-    sessionDesc.searchPathCount = 1;
+    sessionDesc.searchPaths     = search_paths;
+    sessionDesc.searchPathCount = static_cast<SlangInt>(std::size(search_paths));
 
+    // The compiled code is cached by the shader cache instead of Slang's binary modules
     std::vector<slang::CompilerOptionEntry> compiler_options;
-    //compiler_options.emplace_back(slang::CompilerOptionEntry{slang::CompilerOptionName::UseUpToDateBinaryModule, slang::CompilerOptionValue{.kind = slang::CompilerOptionValueKind::Int, .intValue0 = 1}});
     compiler_options.emplace_back(slang::CompilerOptionEntry{slang::CompilerOptionName::Optimization, slang::CompilerOptionValue{.kind = slang::CompilerOptionValueKind::Int, .intValue0 = 3}});
     sessionDesc.compilerOptionEntries    = compiler_options.data();
     sessionDesc.compilerOptionEntryCount = static_cast<uint32_t>(compiler_options.size());
 
-    if (SLANG_FAILED(compiler->global_session->createSession(sessionDesc, &session)))
+    if (SLANG_FAILED(global_session->createSession(sessionDesc, &context->session)))
     {
-        load_errors.emplace_back("Failed to create slang compiler session");
-        return;
+        context->load_errors.emplace_back("Failed to create slang compiler session");
+        return context;
     }
 
     Slang::ComPtr<slang::IBlob> diagnostics;
-    module = session->loadModule(path.string().c_str(), diagnostics.writeRef());
+    context->module = context->session->loadModule(module_path.string().c_str(), diagnostics.writeRef());
     if (diagnostics)
+        context->load_errors.emplace_back(static_cast<const char*>(diagnostics->getBufferPointer()));
+    return context;
+}
+
+Session::SlangContext::~SlangContext()
+{
+    if (session)
+        session->release();
+}
+
+Session::SlangContext& Session::acquire_context() const
+{
+    std::unique_lock lk(contexts_lock);
+    context_released.wait(lk,
+                          [&]
+                          {
+                              return !free_contexts.empty() || context_count < compiler->get_max_contexts();
+                          });
+    if (!free_contexts.empty())
     {
-        load_errors.emplace_back(static_cast<const char*>(diagnostics->getBufferPointer()));
-        return;
+        SlangContext& context = *free_contexts.back();
+        free_contexts.pop_back();
+        return context;
+    }
+
+    // Loading the module is slow : the other threads keep using the existing contexts meanwhile
+    ++context_count;
+    lk.unlock();
+    auto new_context = create_context();
+    lk.lock();
+    return *contexts.emplace_back(std::move(new_context));
+}
+
+void Session::release_context(SlangContext& context) const
+{
+    {
+        std::lock_guard lk(contexts_lock);
+        free_contexts.emplace_back(&context);
     }
+    context_released.notify_one();
+}
+
+Eng::Gfx::PermutationGroup Session::parse_permutation_group(const std::filesystem::path& source_path)
+{
+    // Permutation switches are link-time constants declared as "extern static const bool NAME = default_value;"
+    Eng::Gfx::PermutationGroup group;
+    std::ifstream              file(source_path);
+    const std::string          source((std::istreambuf_iterator(file)), std::istreambuf_iterator<char>());
+    const std::regex           switch_regex(R"(extern\s+static\s+const\s+bool\s+(\w+)\s*=\s*(true|false)\s*;)");
+    for (auto it = std::sregex_iterator(source.begin(), source.end(), switch_regex); it != std::sregex_iterator(); ++it)
+        group.permutation_group.insert_or_assign((*it)[1].str(), (*it)[2].str() == "true");
+    return group;
 }
 
 std::optional<std::string> Session::try_register_variable(slang::VariableLayoutReflection* variable, ankerl::unordered_dense::map<std::string, StageInputOutputDescription>& in_outs, slang::IMetadata* metadata)
@@ -105,16 +237,11 @@ std::optional<std::string> Session::try_register_variable(slang::VariableLayoutR
     return {};
 }
 
-Session::~Session()
-{
-    session->release();
-}
+Session::~Session() = default;
 
 std::optional<std::filesystem::path> Session::get_filesystem_path() const
 {
-    if (!load_errors.empty())
-        return {};
-    return module->getFilePath() ? module->getFilePath() : std::optional<std::filesystem::path>{};
+    return source_path;
 }
 
 TypeReflection::TypeReflection(slang::TypeReflection* slang_type)
@@ -184,14 +311,47 @@ bool TypeReflection::can_reflect(slang::TypeReflection* slang_var)
 
 CompilationResult Session::compile(const std::string& render_pass, const Eng::Gfx::PermutationDescription& permutation) const
 {
-    std::lock_guard   lk(session_lock);
+    std::string key;
+    if (source_path)
+    {
+        key = ShaderCache::make_key(*source_path, render_pass, permutation);
+        std::vector<std::filesystem::path> dependencies;
+        if (auto cached = compiler->cache->load(key, dependencies))
+        {
+            track_dependencies(dependencies);
+            return std::move(*cached);
+        }
+    }
+
+    SlangContext& context = acquire_context();
+    auto          result  = compile_module(context, render_pass, permutation);
+    if (source_path && result.errors.empty())
+    {
+        // Every file the module was built from, including the imported modules
+        std::vector<std::filesystem::path> dependencies{*source_path};
+        for (SlangInt32 i = 0; i < context.module->getDependencyFileCount(); ++i)
+            if (const char* dependency = context.module->getDependencyFilePath(i); dependency && exists(std::filesystem::path(dependency)) && !std::filesystem::equivalent(dependency, *source_path))
+                dependencies.emplace_back(dependency);
+        track_dependencies(dependencies);
+        compiler->cache->save(key, result, dependencies);
+    }
+    release_context(context);
+    return result;
+}
+
+CompilationResult Session::compile_module(SlangContext& context, const std::string& render_pass, const Eng::Gfx::PermutationDescription& permutation) const
+{
     CompilationResult result;
 
-    for (const auto& error : load_errors)
+    for (const auto& error : context.load_errors)
         result.push_error(error);
     if (!result.errors.empty())
         return result;
+    if (!context.module)
+        return result.push_error({"Failed to load module " + module_path.string()});
 
+    const auto module  = context.module;
+    const auto session = context.session;
     for (SlangInt32 ep_i = 0; ep_i < module->getDefinedEntryPointCount(); ++ep_i)
     {
         Slang::ComPtr<slang::IEntryPoint> entry_point;
@@ -271,7 +431,7 @@ CompilationResult Session::compile(const std::string& render_pass, const Eng::Gf
         {
             bool                             b_is_used = true;
             slang::VariableLayoutReflection* parameter = shaderReflection->getParameterByIndex(par_i);
-            metadata->isParameterLocationUsed(static_cast<SlangParameterCategory>(parameter->getCategory()), 0, parameter->getBindingIndex(), b_is_used);
+            metadata->isParameterLocationUsed(static_cast<SlangParameterCategory>(parameter->getCategory()), parameter->getBindingSpace(), parameter->getBindingIndex(), b_is_used);
 
             if (parameter->getCategory() == slang::PushConstantBuffer && !b_is_used)
             {
@@ -285,7 +445,10 @@ CompilationResult Session::compile(const std::string& render_pass, const Eng::Gf
 
             if (b_is_used)
             {
-                if (parameter->getCategory() == slang::DescriptorTableSlot)
+                // The bindless table has a fixed layout owned by the device
+                if (parameter->getCategory() == slang::DescriptorTableSlot && parameter->getBindingSpace() == Eng::Gfx::BINDLESS_DESCRIPTOR_SET)
+                    data.b_uses_bindless = true;
+                else if (parameter->getCategory() == slang::DescriptorTableSlot)
                 {
                     Eng::Gfx::EBindingType binding_type;
 
@@ -333,7 +496,15 @@ CompilationResult Session::compile(const std::string& render_pass, const Eng::Gf
 
             // Note : uniforms in stage parameters are considered as push constant in vulkan ecosystem
             if (parameter->getTypeLayout()->getParameterCategory() == slang::Uniform)
+            {
                 data.push_constant_size = static_cast<uint32_t>(parameter->getTypeLayout()->getSize());
+                if (parameter->getTypeLayout()->getKind() == slang::TypeReflection::Kind::Struct)
+                    for (uint32_t fi = 0; fi < parameter->getTypeLayout()->getFieldCount(); ++fi)
+                    {
+                        auto field = parameter->getTypeLayout()->getFieldByIndex(fi);
+                        data.push_constant_fields.insert_or_assign(field->getName(), static_cast<uint32_t>(field->getOffset()));
+                    }
+            }
         }
 
         for (uint32_t pi = 0; pi < entry_point->getLayout()->getEntryPointByIndex(0)->getParameterCount(); ++pi)
@@ -2,7 +2,10 @@
 #include "gfx_types/format.hpp"
 #include "gfx_types/pipeline.hpp"
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
@@ -27,6 +30,7 @@ struct IGlobalSession;
 namespace ShaderCompiler
 {
 class Compiler;
+class ShaderCache;
 class ShaderParser;
 
 struct StageInputOutputDescription
@@ -79,6 +83,8 @@ struct StageData
     Eng::Gfx::EShaderStage                                                 stage;
     ankerl::unordered_dense::map<std::string, StageInputOutputDescription> inputs;
     uint32_t                                                               push_constant_size = 0;
+    ankerl::unordered_dense::map<std::string, uint32_t>                    push_constant_fields;    // Offset of each member of the push constants
+    bool                                                                   b_uses_bindless = false; // Reads the bindless table (see BINDLESS_DESCRIPTOR_SET)
 };
 
 struct CompilationResult
@@ -93,6 +99,14 @@ struct CompilationResult
     ankerl::unordered_dense::map<Eng::Gfx::EShaderStage, StageData> stages;
 };
 
+/**
+ * Shader module compiled on demand. Results are read from the shader cache when none of the module files changed, and Slang only loads the module
+ * on the first cache miss.
+ *
+ * Slang sessions are not thread safe : each concurrent compilation gets its own Slang session with the module loaded, kept for the next ones. Each
+ * of them loads and checks the whole module again, costing its time and memory : there are at most Compiler::get_max_contexts(), the compilations
+ * beyond wait for a free one.
+ */
 class Session
 {
 public:
@@ -107,18 +121,48 @@ public:
 
     std::optional<std::filesystem::path> get_filesystem_path() const;
 
+    // False once the source file, or a file it was compiled from, was modified after the session used it
+    bool is_up_to_date() const;
+
 private:
     friend class Compiler;
     Session(Compiler* in_compiler, const std::filesystem::path& path);
 
+    static Eng::Gfx::PermutationGroup parse_permutation_group(const std::filesystem::path& source_path);
+
+    // Source file of a module name, resolved the way Slang searches it
+    static std::optional<std::filesystem::path> find_source(const std::filesystem::path& module_name);
+
+    struct SlangContext
+    {
+        ~SlangContext();
+
+        slang::ISession*              session = nullptr;
+        slang::IModule*               module  = nullptr;
+        std::vector<CompilationError> load_errors;
+    };
+
+    std::unique_ptr<SlangContext> create_context() const;
+    SlangContext&                 acquire_context() const;
+    void                          release_context(SlangContext& context) const;
+    void                          track_dependencies(const std::vector<std::filesystem::path>& dependencies) const;
+    CompilationResult             compile_module(SlangContext& context, const std::string& render_pass, const Eng::Gfx::PermutationDescription& permutation) const;
+
     static std::optional<std::string> try_register_variable(slang::VariableLayoutReflection* variable, ankerl::unordered_dense::map<std::string, StageInputOutputDescription>& in_outs, slang::IMetadata* metadata);
 
-    mutable std::mutex            session_lock;
-    Compiler*                     compiler = nullptr;
-    slang::IModule*               module   = nullptr;
-    slang::ISession*              session  = nullptr;
-    Eng::Gfx::PermutationGroup    permutation_description;
-    std::vector<CompilationError> load_errors;
+    Compiler*                                          compiler = nullptr;
+    std::filesystem::path                              module_path;
+    std::optional<std::filesystem::path>               source_path;
+    std::filesystem::file_time_type                    source_time;
+    Eng::Gfx::PermutationGroup                         permutation_description;
+    mutable std::mutex                                 contexts_lock;
+    mutable std::condition_variable                    context_released;
+    mutable std::vector<std::unique_ptr<SlangContext>> contexts;
+    mutable std::vector<SlangContext*>                 free_contexts;
+    mutable size_t                                     context_count = 0; // Including the contexts being created
+
+    mutable std::mutex                                                                 dependencies_lock;
+    mutable ankerl::unordered_dense::map<std::string, std::filesystem::file_time_type> dependency_times; // Files the cached or compiled results came from
 };
 
 class Compiler
@@ -128,12 +172,29 @@ public:
 
     static Compiler& get();
 
+    // Sessions are shared by every user of the same module until its source changes
     std::shared_ptr<Session> create_session(const std::filesystem::path& path);
 
+    // Slang contexts of one session compiling in parallel, the hardware thread count by default. The engine sets its worker count.
+    void set_max_contexts(size_t count);
+
+    size_t get_max_contexts() const
+    {
+        return max_contexts;
+    }
+
 private:
     friend Session;
-    std::mutex             global_session_lock;
-    slang::IGlobalSession* global_session = nullptr;
+
+    // Created on the first cache miss
+    slang::IGlobalSession* get_global_session();
+
+    std::mutex                                                        global_session_lock;
+    slang::IGlobalSession*                                            global_session = nullptr;
+    std::unique_ptr<ShaderCache>                                      cache;
+    std::mutex                                                        sessions_lock;
+    ankerl::unordered_dense::map<std::string, std::weak_ptr<Session>> sessions;
+    std::atomic<size_t>                                               max_contexts;
 
     Compiler();
 };
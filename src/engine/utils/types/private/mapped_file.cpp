@@ -0,0 +1,92 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#if OS_WINDOWS
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+#if OS_WINDOWS
+    file_handle = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+    {
+        file_handle = nullptr;
+        return;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0)
+        return close();
+    mapping_handle = CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_handle)
+        return close();
+    mapping   = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    byte_size = mapping ? static_cast<size_t>(file_size.QuadPart) : 0;
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+    {
+        void* result = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (result != MAP_FAILED)
+        {
+            mapping   = result;
+            byte_size = static_cast<size_t>(file_stat.st_size);
+        }
+    }
+    // The mapping stays valid once the descriptor is closed
+    ::close(fd);
+#endif
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        mapping   = std::exchange(other.mapping, nullptr);
+        byte_size = std::exchange(other.byte_size, 0);
+#if OS_WINDOWS
+        file_handle    = std::exchange(other.file_handle, nullptr);
+        mapping_handle = std::exchange(other.mapping_handle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+void MappedFile::close()
+{
+#if OS_WINDOWS
+    if (mapping)
+        UnmapViewOfFile(mapping);
+    if (mapping_handle)
+        CloseHandle(mapping_handle);
+    if (file_handle)
+        CloseHandle(file_handle);
+    file_handle    = nullptr;
+    mapping_handle = nullptr;
+#else
+    if (mapping)
+        munmap(mapping, byte_size);
+#endif
+    mapping   = nullptr;
+    byte_size = 0;
+}
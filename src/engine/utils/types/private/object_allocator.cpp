@@ -148,10 +148,20 @@ ObjectAllocation* ContiguousObjectAllocator::allocate(const Reflection::Class* c
     return allocation;
 }
 
+void ContiguousObjectAllocator::reserve(const Reflection::Class* component_class, size_t additional_count)
+{
+    assert(component_class);
+    ContiguousObjectPool& pool = *pools.emplace(component_class, std::make_unique<ContiguousObjectPool>(this, component_class)).first->second;
+    pool.reserve(pool.size() + additional_count);
+}
+
 void ContiguousObjectAllocator::free(const Reflection::Class* component_class, void* allocation)
 {
     if (auto pool = pools.find(component_class); pool != pools.end())
+    {
         pool->second->free(allocation);
+        ++free_count;
+    }
     else
         LOG_FATAL("No object {} was allocated using this allocator", component_class->name())
 }
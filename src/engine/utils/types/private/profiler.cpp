@@ -34,13 +34,45 @@ void Profiler::clear()
 }
 
 
+void Profiler::add_counter(const std::string& name, int64_t value)
+{
+    std::lock_guard lk(counter_lock);
+    auto&           counter = counters[name];
+    counter.value += value;
+    counter.per_frame = true;
+}
+
+void Profiler::set_counter(const std::string& name, int64_t value)
+{
+    std::lock_guard lk(counter_lock);
+    counters[name] = Counter{.value = value, .per_frame = false};
+}
+
+ankerl::unordered_dense::map<std::string, int64_t> Profiler::last_frame_counters() const
+{
+    std::lock_guard lk(counter_lock);
+    return last_counters;
+}
+
 void Profiler::next_frame()
 {
+    {
+        std::lock_guard lk(counter_lock);
+        last_counters.clear();
+        for (auto& [name, counter] : counters)
+        {
+            last_counters.emplace(name, counter.value);
+            if (counter.per_frame)
+                counter.value = 0;
+        }
+    }
+
     std::lock_guard lk(global_lock);
     if (!b_record)
         return;
 
-    auto recorded_frame = std::make_shared<ProfilerFrameData>();
+    auto recorded_frame      = std::make_shared<ProfilerFrameData>();
+    recorded_frame->counters = last_frame_counters();
 
     std::lock_guard lk_all(all_threads_lock);
 
@@ -0,0 +1,46 @@
+#pragma once
+#include "simplemacros.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+/**
+ * Read-only memory mapping of a whole file. The content is paged in by the OS on access, so large files are read without intermediate copies.
+ */
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& path);
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const uint8_t* data() const
+    {
+        return static_cast<const uint8_t*>(mapping);
+    }
+
+    size_t size() const
+    {
+        return byte_size;
+    }
+
+    operator bool() const
+    {
+        return mapping != nullptr;
+    }
+
+private:
+    void close();
+
+    void*  mapping   = nullptr;
+    size_t byte_size = 0;
+#if OS_WINDOWS
+    void* file_handle    = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
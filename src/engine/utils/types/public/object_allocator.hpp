@@ -63,8 +63,9 @@ class ContiguousObjectPool
         return component_count;
     }
 
-  private:
     void reserve(size_t desired_count);
+
+  private:
     void resize(size_t new_count);
     void move_old_to_new_block(void* old, void* new_block);
 
@@ -227,8 +228,19 @@ class ContiguousObjectAllocator : public ObjectAllocator
 
     void merge_with(ContiguousObjectAllocator& other);
 
-  private:
+    // Grow the pool of the given class once to fit additional_count more objects, instead of growing it progressively
+    void reserve(const Reflection::Class* component_class, size_t additional_count);
+
+    // Pools of every class derived from parent_class
     std::vector<ContiguousObjectPool*> find_pools(const Reflection::Class* parent_class) const;
 
+    // Incremented each time an object is freed. Allows owners to skip cleanup passes when nothing was destroyed.
+    size_t get_free_count() const
+    {
+        return free_count;
+    }
+
+  private:
     ankerl::unordered_dense::map<const Reflection::Class*, std::unique_ptr<ContiguousObjectPool>> pools;
+    size_t                                                                                        free_count = 0;
 };
\ No newline at end of file
@@ -11,10 +11,14 @@
 #define PROFILER_MARKER(name)                   Profiler::get().add_marker({#name})
 #define PROFILER_SCOPE(name)                    Profiler::EventRecorder __profiler_event__##name(#name)
 #define PROFILER_SCOPE_NAMED(name, string_name) Profiler::EventRecorder __profiler_event__##name(string_name)
+#define PROFILER_COUNTER(name, value)           Profiler::get().set_counter(#name, static_cast<int64_t>(value))
+#define PROFILER_COUNTER_ADD(name, value)       Profiler::get().add_counter(#name, static_cast<int64_t>(value))
 #else
 #define PROFILER_MARKER(generic_name)
 #define PROFILER_SCOPE(generic_name)
 #define PROFILER_SCOPE_NAMED(generic_name, string_name)
+#define PROFILER_COUNTER(generic_name, value)
+#define PROFILER_COUNTER_ADD(generic_name, value)
 #endif
 
 
@@ -82,6 +86,7 @@ public:
         std::chrono::steady_clock::time_point                                      min;
         std::unique_ptr<std::shared_mutex>                                         threads_lock;
         ankerl::unordered_dense::map<std::thread::id, std::shared_ptr<ThreadData>> thread_data;
+        ankerl::unordered_dense::map<std::string, int64_t>                         counters;
     };
 
     void add_marker(const ProfilerMarker& marker) const
@@ -98,6 +103,21 @@ public:
         get_thread_data().events.push_back(event);
     }
 
+    /**
+     * Accumulate a value that is reset at the end of each frame (ex : draw calls)
+     */
+    void add_counter(const std::string& name, int64_t value);
+
+    /**
+     * Set a value that is kept until it is modified again (ex : queue depth)
+     */
+    void set_counter(const std::string& name, int64_t value);
+
+    /**
+     * Counter values of the last finished frame. Available even when the profiler is not recording
+     */
+    ankerl::unordered_dense::map<std::string, int64_t> last_frame_counters() const;
+
     struct FrameWrapper
     {
         FrameWrapper(Profiler* in_profiler) : profiler(in_profiler)
@@ -131,6 +151,16 @@ public:
 private:
     static ThreadData& get_thread_data();
 
+    struct Counter
+    {
+        int64_t value     = 0;
+        bool    per_frame = false;
+    };
+
+    mutable std::mutex                                 counter_lock;
+    ankerl::unordered_dense::map<std::string, Counter> counters;
+    ankerl::unordered_dense::map<std::string, int64_t> last_counters;
+
     std::chrono::steady_clock::time_point           record_start;
     std::mutex                                      global_lock;
     bool                                            b_record = false;
@@ -12,17 +12,23 @@
 #include "gfx/vulkan/descriptor_sets.hpp"
 #include "gfx_types/format.hpp"
 #include "import/assimp_import.hpp"
+#include "pulsing_light_component.hpp"
 #include "widgets/profiler.hpp"
 #include "scene/components/camera_component.hpp"
 #include "scene/components/mesh_component.hpp"
 #include "scene/scene.hpp"
 #include "scene/scene_view.hpp"
 #include "scene/components/directional_light_component.hpp"
+#include "scene/components/point_light_component.hpp"
+#include "scene/light_clusters.hpp"
+#include "scene/render_scene.hpp"
+#include "scene/scene_serializer.hpp"
 #include "widgets/content_browser.hpp"
 #include "widgets/render_graph_view.hpp"
 #include "widgets/scene_outliner.hpp"
 #include "widgets/viewport.hpp"
 
+#include <chrono>
 #include <numbers>
 #include <GLFW/glfw3.h>
 #include <gfx/window.hpp>
@@ -38,12 +44,12 @@ public:
 
     void pre_draw(const Gfx::RenderPassInstanceBase& rp) override
     {
-        scene->get_active_camera()->get_view().pre_draw(rp);
+        scene->get_active_camera()->get_view().pre_draw(*scene, rp);
     }
 
     void draw(const Gfx::RenderPassInstanceBase& rp, Gfx::CommandBuffer& command_buffer, size_t thread_index) override
     {
-        scene->get_active_camera()->get_view().draw(*scene, rp, command_buffer, thread_index, record_threads());
+        scene->get_active_camera()->get_view().draw(rp, command_buffer, thread_index, record_threads());
     }
 
     size_t record_threads() override
@@ -64,16 +70,22 @@ class GBufferResolveInterface : public Gfx::IRenderPass
 public:
     GBufferResolveInterface(const std::shared_ptr<Scene>& in_scene) : scene(in_scene)
     {
-        light_buffer = Gfx::Buffer::create("light_buffer", Engine::get().get_device(), Gfx::Buffer::CreateInfos{.usage = Gfx::EBufferUsage::GPU_MEMORY, .type = Gfx::EBufferType::IMMEDIATE}, sizeof(Light), 1);
+        light_clusters = LightClusters::create();
     }
 
+    // Size of the shadow_maps array of gbuffer_resolve.slang
+    static constexpr size_t max_shadow_maps = 16;
+
     struct Light
     {
-        glm::mat4 shadow_matrix;
-        alignas(8) glm::vec3 dir;
-        alignas(8) glm::vec3 pos;
-        alignas(4) uint32_t  has_shadows;
-        alignas(4) uint32_t type;
+        glm::mat4             shadow_matrices[LightComponent::max_cascades];
+        glm::vec4             cascade_splits;
+        alignas(16) glm::vec3 dir;
+        alignas(16) glm::vec3 pos;
+        uint32_t              has_shadows;
+        uint32_t              type;
+        uint32_t              shadow_map_index;
+        uint32_t              cascade_count;
     };
 
     void init(const Gfx::RenderPassInstanceBase&) override
@@ -98,45 +110,49 @@ public:
         resource->bind_image("gbuffer_position", dep->get_image_resource("position").lock());
         resource->bind_image("gbuffer_albedo_m", dep->get_image_resource("albedo-m").lock());
         resource->bind_image("gbuffer_normal_r", dep->get_image_resource("normal-r").lock());
-        resource->bind_image("gbuffer_depth", dep->get_image_resource("depth").lock());
     }
 
     void pre_draw(const Gfx::RenderPassInstanceBase& render_pass) override
     {
         lights.clear();
         std::vector<std::shared_ptr<Gfx::ImageView>> shadow_maps;
-        scene->for_each<LightComponent>(
-            [&](const LightComponent& comp)
+        const SceneView&                             camera_view = scene->get_active_camera()->get_view();
+        // Point and spot lights are shaded through the light clusters
+        scene->for_each<DirectionalLightComponent>(
+            [&](const DirectionalLightComponent& comp)
             {
-                if (comp.get_shadow_pass())
+                Light light{.cascade_splits   = glm::vec4(FLT_MAX),
+                            .dir              = comp.get_relative_rotation() * glm::vec3{-1, 0, 0},
+                            .pos              = glm::vec3(comp.get_relative_position() - camera_view.get_origin()),
+                            .has_shadows      = 0,
+                            .type             = 1,
+                            .shadow_map_index = static_cast<uint32_t>(shadow_maps.size()),
+                            .cascade_count    = 0};
+
+                for (const auto& cascade : comp.get_shadow_cascades())
                 {
-                    auto resource = comp.get_shadow_pass()->get_image_resource("depth");
-
-                    if (!resource.lock())
-                    {
-                        LOG_WARNING("bah ?");
-                        return;
-                    }
-                    auto light_mat = comp.get_shadow_view()->get_projection_view_matrix();
-                    lights.emplace_back(light_mat, comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 1, 1);
-
+                    // The lights over the limit keep their first cascades, or are rendered without shadows
+                    if (shadow_maps.size() >= max_shadow_maps)
+                        break;
+                    auto resource = cascade.pass->get_image_resource("depth").lock();
+                    if (!resource)
+                        continue;
+                    light.shadow_matrices[light.cascade_count] = cascade.view->get_projection_view_matrix();
+                    light.cascade_splits[light.cascade_count]  = cascade.far_distance;
+                    ++light.cascade_count;
                     shadow_maps.emplace_back(resource);
                 }
-            });
-
-        scene->for_each<LightComponent>(
-            [&](const LightComponent& comp)
-            {
-                if (!comp.get_shadow_pass())
-                {
-                    lights.emplace_back(glm::identity<glm::mat4>(), comp.get_relative_rotation() * glm::vec3{-1, 0, 0}, comp.get_relative_position(), 0, 1);
-                }
+                light.has_shadows = light.cascade_count > 0 ? 1 : 0;
+                lights.emplace_back(light);
             });
 
         auto desc_resource = material->get_descriptor_resource(render_pass.get_definition().render_pass_ref);
         if (!shadow_maps.empty())
             desc_resource->bind_images("shadow_maps", shadow_maps);
-        light_buffer->set_data(0, Gfx::BufferData(lights));
+        light_buffer = Engine::get().get_device().lock()->get_transient_allocator().write(Gfx::BufferData(lights));
+
+        if (auto render_scene = scene->get_render_scene())
+            light_clusters->update(*render_scene, camera_view);
     }
 
     void draw(const Gfx::RenderPassInstanceBase& render_pass, Gfx::CommandBuffer& command_buffer, size_t) override
@@ -148,15 +164,20 @@ public:
         auto desc_resource = material->get_descriptor_resource(render_pass.get_definition().render_pass_ref);
         desc_resource->bind_buffer("light_buffer", light_buffer);
         desc_resource->bind_buffer("scene_data_buffer", scene->get_active_camera()->get_view().get_view_buffer());
+        desc_resource->bind_buffer("cluster_lights", light_clusters->get_light_buffer());
+        desc_resource->bind_buffer("cluster_ranges", light_clusters->get_cluster_buffer());
+        desc_resource->bind_buffer("cluster_light_indices", light_clusters->get_index_buffer());
 
         struct PcData
         {
             glm::vec3 cam_pos;
             uint32_t  light_count;
+            float     cluster_z_near;
+            float     cluster_z_scale;
         };
         command_buffer.push_constant(Gfx::EShaderStage::Fragment, *resource,
                                      Gfx::BufferData{PcData{
-                                         scene->get_active_camera()->get_relative_position(), static_cast<uint32_t>(lights.size())
+                                         scene->get_active_camera()->get_view().get_render_position(), static_cast<uint32_t>(lights.size()), light_clusters->get_z_near(), light_clusters->get_z_scale()
                                      }});
 
         command_buffer.bind_pipeline(resource);
@@ -164,17 +185,13 @@ public:
         command_buffer.draw_procedural(6, 0, 1, 0);
     }
 
-    void pre_submit(const Gfx::RenderPassInstanceBase&) override
-    {
-        light_buffer->wait_data_upload();
-    }
-
     std::vector<Light> lights;
 
     TObjectRef<MaterialInstanceAsset> material;
     TObjectRef<SamplerAsset>          sampler;
     std::shared_ptr<Scene>            scene;
-    std::shared_ptr<Gfx::Buffer>      light_buffer;
+    Gfx::TransientBuffer              light_buffer;
+    std::shared_ptr<LightClusters>    light_clusters;
 };
 
 
@@ -246,7 +263,7 @@ class TestApp : public Application
 public:
     void init(Engine& engine, const std::weak_ptr<Gfx::Window>& in_default_window) override
     {
-        scene = std::make_shared<Scene>();
+        scene = std::make_shared<Scene>(engine.get_config().render_pipeline_depth);
 
         default_window = in_default_window;
 
@@ -258,12 +275,12 @@ public:
             [Gfx::Attachment::slot("position").format(Gfx::ColorFormat::R32G32B32A32_SFLOAT).clear_color({0, 0, 0, 0})]
             [Gfx::Attachment::slot("albedo-m").format(Gfx::ColorFormat::R8G8B8A8_UNORM).clear_color({0.5f, 0.5f, 0.8f, 0.0f})]
             [Gfx::Attachment::slot("normal-r").format(Gfx::ColorFormat::R8G8B8A8_UNORM).clear_color({0, 0, 0, 1.0f})]
-            [Gfx::Attachment::slot("depth").format(Gfx::ColorFormat::D32_SFLOAT).clear_depth({0.0f, 0.0f})];
+            [Gfx::Attachment::slot("depth").format(Gfx::ColorFormat::D32_SFLOAT).clear_depth({0.0f, 0.0f}).transient()];
 
         renderer["gbuffer_resolve"]
             .require("gbuffers")
             .render_pass<GBufferResolveInterface>(scene)
-            [Gfx::Attachment::slot("target").format(Gfx::ColorFormat::R8G8B8A8_UNORM)];
+            [Gfx::Attachment::slot("target").format(Gfx::ColorFormat::R8G8B8A8_UNORM).read_outside_graph()]; // Displayed by the viewports
 
         //Cmaa2 cmaa;
         //cmaa.append_to_renderer(renderer);
@@ -282,17 +299,46 @@ public:
         directional_light->enable_shadow(ELightType::Movable);
         directional_light->set_rotation(glm::vec3{0, 1.5f, 0.2f});
 
+        // Grid of colored pulsing point lights over the loaded scenes, shaded through the light clusters
+        for (int x = 0; x < 16; ++x)
+            for (int y = 0; y < 16; ++y)
+            {
+                auto point_light = scene->add_component<PulsingLightComponent>("Point light");
+                point_light->set_pulse(1.f + 0.1f * static_cast<float>(x), 0.5f * static_cast<float>(y));
+                point_light->set_position({x * 400.f - 6000.f, y * 400.f - 3000.f, 150.f});
+                point_light->set_range(600.f);
+                point_light->set_color({0.5f + 0.5f * std::sin(x * 0.7f), 0.5f + 0.5f * std::sin(y * 0.9f), 0.5f + 0.5f * std::cos((x + y) * 0.4f)});
+            }
+
         /*
         auto directional_light2 = scene->add_component<DirectionalLightComponent>("Directional light");
         directional_light2->enable_shadow(ELightType::Movable);
         directional_light2->set_rotation(glm::vec3{0, 1.8f, -1.2f});
         */
         std::shared_ptr<AssimpImporter> importer = std::make_shared<AssimpImporter>();
+        importer->generated_lods                 = 3;
         engine.jobs().schedule(
             [&, importer]
             {
-                auto  new_scene = importer->load_from_path("./resources/models/samples/Sponza/glTF/Sponza.gltf");
-                float pi        = std::numbers::pi_v<float>;
+                // The binary scene stores the assets, so once it exists Sponza is loaded without the importer
+                const std::filesystem::path cache_path = "./resources/models/samples/Sponza/glTF/Sponza.escn";
+                const auto                  start_time = std::chrono::steady_clock::now();
+                Scene                       new_scene  = [&]
+                {
+                    Scene cached_scene;
+                    if (exists(cache_path) && SceneSerializer::load(cached_scene, cache_path, Engine::get().asset_registry()))
+                    {
+                        LOG_INFO("Loaded Sponza from {} in {:.2f}ms", cache_path.string(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+                        return cached_scene;
+                    }
+                    AssetPayloads payloads;
+                    Scene         imported_scene = importer->load_from_path("./resources/models/samples/Sponza/glTF/Sponza.gltf", &payloads);
+                    LOG_INFO("Imported Sponza with assimp in {:.2f}ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count());
+                    SceneSerializer::save(imported_scene, cache_path, payloads);
+                    return imported_scene;
+                }();
+
+                float pi = std::numbers::pi_v<float>;
                 for (const auto& root : new_scene.get_nodes())
                     root->set_rotation(glm::quat({pi / 2, 0, 0}));
                 scene->merge(std::move(new_scene));
@@ -386,7 +432,7 @@ public:
 
         glm::vec3 vec = mov_vec.x * forward + mov_vec.y * right + mov_vec.z * up;
 
-        camera->set_position(camera->get_relative_position() + static_cast<float>(delta_second) * speed * vec);
+        camera->set_position(camera->get_relative_position() + delta_second * speed * glm::dvec3(vec));
 
         scene->tick(delta_second);
     }
@@ -0,0 +1,36 @@
+#pragma once
+#include "scene/components/point_light_component.hpp"
+
+#include <cmath>
+
+#include "pulsing_light_component.gen.hpp"
+
+/**
+ * Point light whose intensity pulses over time. Its tick only touches its own state, so the lights are ticked on the job system workers.
+ */
+class PulsingLightComponent : public Eng::PointLightComponent
+{
+    REFLECT_BODY()
+
+    static constexpr uint32_t class_flags = ParallelTick;
+
+    PulsingLightComponent() = default;
+
+    void set_pulse(float in_frequency, float in_phase)
+    {
+        frequency = in_frequency;
+        phase     = in_phase;
+    }
+
+    void tick(double delta_second) override
+    {
+        time += delta_second;
+        intensity = base_intensity * (0.75f + 0.25f * static_cast<float>(std::sin(time * frequency + phase)));
+    }
+
+private:
+    double time           = 0;
+    float  base_intensity = 100000.f;
+    float  frequency      = 1.f;
+    float  phase          = 0.f;
+};
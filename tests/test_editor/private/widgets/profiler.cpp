@@ -374,6 +374,15 @@ void ProfilerWindow::draw(Gfx::ImGuiWrapper&)
         Profiler::get().set_record(false);
     }
 
+    if (ImGui::CollapsingHeader("Counters"))
+    {
+        auto counters = Profiler::get().last_frame_counters();
+        std::vector<std::pair<std::string, int64_t>> sorted_counters(counters.begin(), counters.end());
+        std::ranges::sort(sorted_counters);
+        for (const auto& [name, value] : sorted_counters)
+            ImGui::Text("%s : %lld", format_name(name).c_str(), static_cast<long long>(value));
+    }
+
     ImGui::Separator();
     frames.draw(display_data);
     ImGui::Separator();
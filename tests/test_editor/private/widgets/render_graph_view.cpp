@@ -1,5 +1,6 @@
 #include "widgets/render_graph_view.hpp"
 
+#include "gfx/renderer/instance/attachment_aliasing.hpp"
 #include "gfx/renderer/instance/render_pass_instance.hpp"
 #include "gfx/ui/ImGuiWrapper.hpp"
 #include "gfx/vulkan/image_view.hpp"
@@ -32,8 +33,29 @@ static ImVec2 operator/(const ImVec2& a, const float& b)
 static constexpr ImVec2 image_padding{20, 20};
 static constexpr ImVec2 group_padding{300, 40};
 
+RenderGraphView::RenderGraphView(const std::string& name) : UiWindow(name)
+{
+    Eng::Gfx::AttachmentAliasing::disable();
+}
+
+RenderGraphView::~RenderGraphView()
+{
+    Eng::Gfx::AttachmentAliasing::enable();
+}
+
 void RenderGraphView::draw(Eng::Gfx::ImGuiWrapper& ctx)
 {
+    // Recreate the attachments of the graph without aliasing, they are used from the next frame
+    if (!graph_pinned)
+    {
+        ctx.get_current_render_pass()->for_each_dependency(
+            [&](const std::shared_ptr<Eng::Gfx::RenderPassInstanceBase>& dep)
+            {
+                dep->create_or_resize(dep->viewport_resolution(), dep->resolution(), true);
+            });
+        graph_pinned = true;
+    }
+
     Content content;
     ctx.get_current_render_pass()->for_each_dependency(
         [&](const std::shared_ptr<Eng::Gfx::RenderPassInstanceBase>& dep)
@@ -25,10 +25,9 @@ class RenderPassInstance;
 class RenderGraphView : public Eng::UiWindow
 {
 public:
-    explicit RenderGraphView(const std::string& name)
-        : UiWindow(name)
-    {
-    }
+    // The view samples every attachment of the graph : they must not share their memory while it is open
+    explicit RenderGraphView(const std::string& name);
+    ~RenderGraphView() override;
 
 protected:
     void draw(Eng::Gfx::ImGuiWrapper& ctx) override;
@@ -68,6 +67,7 @@ protected:
     float                 last_scroll_y = 0;
     float                 zoom          = 0;
     bool                  initialized   = false;
+    bool                  graph_pinned  = false; // The graph was recreated without aliasing
 
     static void add_pass_content(Eng::Gfx::ImGuiWrapper& ctx, const std::shared_ptr<Eng::Gfx::RenderPassInstanceBase>& pass, Content& content, int current_stage);
 };
\ No newline at end of file
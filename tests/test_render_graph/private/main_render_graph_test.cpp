@@ -0,0 +1,56 @@
+#include "gfx/renderer/instance/pass_dependencies.hpp"
+
+#include <cassert>
+
+using namespace Eng::Gfx;
+
+// Collects its dependencies once per frame, like RenderPassInstanceBase::collect_passes()
+struct TestPass
+{
+    void collect_passes(std::vector<TestPass*>& passes)
+    {
+        if (prepared)
+            return;
+        prepared = true;
+        for (TestPass* dependency : dependencies)
+            dependency->collect_passes(passes);
+        passes.emplace_back(this);
+    }
+
+    std::vector<TestPass*> dependencies;
+    bool                   prepared = false;
+};
+
+static std::vector<std::vector<size_t>> find_dependencies(const std::vector<TestPass*>& passes)
+{
+    return find_pass_dependencies(passes,
+                                  [](const TestPass& pass, const auto& callback)
+                                  {
+                                      for (const TestPass* dependency : pass.dependencies)
+                                          callback(dependency);
+                                  });
+}
+
+int main()
+{
+    // Two roots (e.g. two viewports) sharing the same shadow pass
+    TestPass shadows, gbuffers, first_root, second_root;
+    gbuffers.dependencies    = {&shadows};
+    first_root.dependencies  = {&gbuffers, &shadows};
+    second_root.dependencies = {&shadows};
+
+    std::vector<TestPass*> first_passes;
+    first_root.collect_passes(first_passes);
+    assert((first_passes == std::vector<TestPass*>{&shadows, &gbuffers, &first_root}));
+    const auto first_dependencies = find_dependencies(first_passes);
+    assert((first_dependencies[0].empty() && first_dependencies[1] == std::vector<size_t>{0} && first_dependencies[2] == std::vector<size_t>{1, 0}));
+
+    // The shared pass was recorded by the first root : the second one only depends on passes of its own graph
+    std::vector<TestPass*> second_passes;
+    second_root.collect_passes(second_passes);
+    assert((second_passes == std::vector<TestPass*>{&second_root}));
+    const auto second_dependencies = find_dependencies(second_passes);
+    assert(second_dependencies.size() == 1 && second_dependencies[0].empty());
+
+    return 0;
+}
@@ -0,0 +1,11 @@
+declare_module(
+    "test_render_graph",
+    {
+        deps = {"gfx"},
+        is_executable = true,
+        enable_reflection = true
+    }
+)
+
+target("test_render_graph")
+    set_group("test")
@@ -0,0 +1,18 @@
+#pragma once
+#include "scene/components/scene_component.hpp"
+
+#include "bounded_component.gen.hpp"
+
+// Component with a fixed bounding sphere, tracked by the scene partition without any mesh
+class BoundedComponent : public Eng::SceneComponent
+{
+    REFLECT_BODY()
+
+  public:
+    BoundedComponent() = default;
+
+    std::optional<double> get_bounding_radius() override
+    {
+        return 10.0;
+    }
+};
@@ -0,0 +1,78 @@
+#include "bounded_component.hpp"
+#include "logger.hpp"
+#include "scene/scene.hpp"
+
+#include <cassert>
+
+using namespace Eng;
+
+int main()
+{
+    Logger::get().enable_logs(Logger::LOG_LEVEL_DEBUG | Logger::LOG_LEVEL_ERROR | Logger::LOG_LEVEL_FATAL | Logger::LOG_LEVEL_INFO | Logger::LOG_LEVEL_WARNING);
+
+    Scene           scene;
+    ScenePartition& partition = scene.get_partition();
+    partition.set_activation_distance(1000.0, 0.25);
+
+    ankerl::unordered_dense::set<TObjectRef<SceneComponent>> active;
+    partition.set_activation_callbacks(
+        [&](const CellKey&, const std::vector<TObjectRef<SceneComponent>>& components)
+        {
+            for (const auto& component : components)
+            {
+                const bool b_inserted = active.insert(component).second;
+                assert(b_inserted);
+                (void)b_inserted;
+            }
+        },
+        [&](const CellKey&, const std::vector<TObjectRef<SceneComponent>>& components)
+        {
+            for (const auto& component : components)
+            {
+                const size_t erased = active.erase(component);
+                assert(erased == 1);
+                (void)erased;
+            }
+        });
+
+    TObjectRef<SceneComponent> near_component, far_component, child_component;
+    near_component = scene.add_component<BoundedComponent>("near");
+    near_component->set_position({100, 0, 0});
+    far_component = scene.add_component<BoundedComponent>("far");
+    far_component->set_position({100000, 0, 0});
+    child_component                      = far_component->add_component<BoundedComponent>("child");
+    TObjectRef<SceneComponent> no_bounds = scene.add_component<SceneComponent>("no_bounds");
+
+    // Components are tracked on the next tick, and only if they have bounds
+    CellKey key;
+    assert(!partition.find_cell(near_component, key));
+    scene.tick(0);
+    assert(partition.find_cell(near_component, key) && partition.find_cell(far_component, key) && partition.find_cell(child_component, key));
+    assert(!partition.find_cell(no_bounds, key));
+
+    // Only the cells in range are activated
+    partition.update_activation({0, 0, 0});
+    assert(active.contains(near_component) && !active.contains(far_component) && !active.contains(child_component));
+
+    // Out of the activation distance, but within the hysteresis margin : the cell stays active
+    partition.update_activation({-1700, 0, 0});
+    assert(active.contains(near_component));
+
+    partition.update_activation({100000, 0, 0});
+    assert(!active.contains(near_component) && active.contains(far_component) && active.contains(child_component));
+
+    // Moving into an active cell activates the component
+    near_component->set_position({100050, 0, 0});
+    partition.update();
+    assert(active.contains(near_component));
+
+    // Removing a component from an active cell deactivates it
+    partition.untrack(far_component);
+    assert(!active.contains(far_component) && !partition.find_cell(far_component, key));
+    assert(active.contains(near_component) && active.contains(child_component));
+
+    partition.update_activation({0, 0, 0});
+    assert(active.empty());
+
+    return 0;
+}
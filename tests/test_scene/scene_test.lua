@@ -0,0 +1,11 @@
+declare_module(
+    "test_scene",
+    {
+        deps = {"core"},
+        is_executable = true,
+        enable_reflection = true
+    }
+)
+
+target("test_scene")
+    set_group("test")